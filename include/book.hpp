@@ -1,10 +1,24 @@
 #ifndef BOOK_HPP
 #define BOOK_HPP
+#include "cascade_stats.hpp"
 #include "common.hpp"
+#include "insertable.hpp"
 #include "insertable_iterator.hpp"
+#include "level_table.hpp"
+#include "listener.hpp"
+#include "market_impact.hpp"
+#include "order_group.hpp"
+#include "participant.hpp"
+#include "snapshot.hpp"
+#include "timer_wheel.hpp"
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace elob {
 
@@ -16,13 +30,31 @@ class order;
 class insertable;
 
 using bid_order_iterator = elob::insertable_iterator<std::greater<double>,
-    elob::order_limit, std::shared_ptr<elob::order>>;
+    elob::order_limit, elob::order_ptr>;
 
 using ask_order_iterator = elob::insertable_iterator<std::less<double>,
-    elob::order_limit, std::shared_ptr<elob::order>>;
+    elob::order_limit, elob::order_ptr>;
 
 std::ostream &operator<<(std::ostream &t_os, const book &t_book);
 
+/**
+ * \internal
+ * @brief The compile-time properties of a side of the book: the order
+ * of its price levels and the side it trades against.
+ *
+ */
+template <side Side> struct side_traits;
+
+template <> struct side_traits<side::bid> {
+	using compare = std::greater<double>;
+	static constexpr side opposite = side::ask;
+};
+
+template <> struct side_traits<side::ask> {
+	using compare = std::less<double>;
+	static constexpr side opposite = side::bid;
+};
+
 /**
  * @brief book implements a price-time-priotity matching engine. Orders
  * and triggers can be inserted into book objects.
@@ -30,23 +62,172 @@ std::ostream &operator<<(std::ostream &t_os, const book &t_book);
  */
 class book {
 	private:
+	template <side Side>
+	using limit_map = std::map<double, order_limit,
+	    typename side_traits<Side>::compare>;
+
+	template <side Side> using peg_maps = limit_map<Side>[peg_type_count];
+
+	template <side Side>
+	using trigger_map = std::map<double, trigger_limit,
+	    typename side_traits<Side>::compare>;
+
+	/* how the orders of a level share an inbound order. Fixed for
+		the lifetime of the book. */
+	const matching_policy m_matching_policy;
+	const double m_lot_size;
+
 	/* During order execution. event handlers like "on_trade" are
 	 * called which may insert additional orders recursively. These
 	 * additional orders will be deferred. Only once
 	 * the outer insertion call has completed, the additional orders
-	 * are removed from the deferral queue and executed. */
+	 * are removed from the deferral queue and executed. Triggers
+	 * that fire on insertion from within event methods are deferred
+	 * as well, so a cascade of stops is processed in waves without
+	 * recursion. */
 	std::size_t m_order_deferral_depth = 0;
-	std::queue<order_ptr> m_deferred;
-
-	std::map<double, order_limit, std::greater<double>> m_bids;
-	std::map<double, order_limit, std::less<double>> m_asks;
-
-	std::map<double, trigger_limit, std::greater<double>> m_bid_triggers;
-	std::map<double, trigger_limit, std::less<double>> m_ask_triggers;
+	bool m_draining_deferred = false;
+	std::queue<insertable> m_deferred;
+	cascade_stats m_cascade;
+
+	/* one-cancels-other groups and brackets. Handle h refers to
+		m_groups[h - 1]; 0 means no group. A deque keeps the groups
+		in place while event methods create new ones. Groups fired
+		during an operation are resolved before the orders it
+		deferred execute. */
+	std::deque<order_group> m_groups;
+	std::vector<std::uint32_t> m_free_groups;
+	std::vector<std::uint32_t> m_fired_groups;
+
+	/* the participant index maps the owner of queued orders to the
+		first of them, the others are linked through the orders.
+		The orders on levels a fork still shares are indexed once
+		the fork needs them. The entries also hold the risk of the
+		participants and outlive their orders. */
+	std::unordered_map<std::uint64_t, participant> m_participants;
+	bool m_participants_indexed = true;
+
+	limit_map<side::bid> m_bids;
+	limit_map<side::ask> m_asks;
+
+	/* pegged orders are grouped by peg type and offset. The price of
+		a group is derived from the current reference price, so a
+		change of the best prices reprices every group at once
+		without touching the orders. Indexed by peg type - 1. */
+	peg_maps<side::bid> m_bid_pegs;
+	peg_maps<side::ask> m_ask_pegs;
+
+	trigger_map<side::bid> m_bid_triggers;
+	trigger_map<side::ask> m_ask_triggers;
+
+	/* orders and triggers refer to their level by a handle into
+		these tables. The comparator does not affect the iterator
+		type, so one table serves both sides. */
+	level_table<std::map<double, order_limit>::iterator> m_levels;
+	level_table<std::map<double, trigger_limit>::iterator>
+	    m_trigger_levels;
+
+	/* the map nodes of recently emptied levels, kept with their
+		queues so that a price that empties and refills, e.g. at a
+		flickering touch, does not allocate. Nodes move freely
+		between the maps of both sides and the peg groups. Trigger
+		levels keep the capacity of their arrays. */
+	static constexpr std::size_t spare_level_count = 8;
+	std::vector<std::map<double, order_limit>::node_type> m_spare_levels;
+	std::vector<std::map<double, trigger_limit>::node_type>
+	    m_spare_trigger_levels;
+
+	/* the price of the first trigger level of each side, so that a
+		trade which cannot fire a trigger costs one comparison.
+		-1.0 and max_price while a side has no triggers. */
+	double m_bid_trigger_price = -1.0;
+	double m_ask_trigger_price = max_price;
+
+	/* with lazy cancellation a canceled order only leaves a nullptr
+		in its queue, see set_lazy_cancel */
+	bool m_lazy_cancel = false;
 
 	// set to -1 to prevent triggers from being triggered
 	// immediately.
 	double m_market_price = -1.0;
+	double m_last_trade_quantity = 0.0;
+
+	/* the logical clock of the book and the timers of the orders and
+		triggers that expire. The timers are created on first use
+		and refer to their objects weakly: a timer whose object was
+		dequeued or got a later expiry in the meantime is skipped
+		or rescheduled when it fires. */
+	struct expiry_timer {
+		std::weak_ptr<order> m_order;
+		std::weak_ptr<trigger> m_trigger;
+
+		explicit expiry_timer(c_order_ptr &t_order)
+		    : m_order(t_order) {}
+		explicit expiry_timer(c_trigger_ptr &t_trigger)
+		    : m_trigger(t_trigger) {}
+	};
+
+	std::uint64_t m_time = 0;
+	std::unique_ptr<timer_wheel<expiry_timer>> m_timers;
+
+	/* during an auction orders are queued without matching until
+		uncross is called. The indicative price and volume are
+		recomputed once an operation has changed a level that
+		crosses the opposite side. */
+	bool m_auction = false;
+	bool m_indicative_changed = false;
+	double m_indicative_price = -1.0;
+	double m_indicative_volume = 0.0;
+
+	/* in batch mode the book stays in an auction that is cleared
+		whenever the clock passes a multiple of the interval.
+		Immediate-or-cancel orders rest for one batch only. */
+	std::uint64_t m_batch_interval = 0;
+	std::vector<order_ptr> m_batch_iocs;
+
+	// optional top-of-book publication for concurrent readers
+	std::unique_ptr<snapshot> m_snapshot;
+
+	/* optional market data listener. Price levels modified during
+		an operation are collected in m_touched and reported once
+		the operation has completed. */
+	listener *m_listener = nullptr;
+	std::vector<std::pair<side, double>> m_touched;
+
+	/**
+	 * \internal
+	 * @brief Get the price levels, peg groups or triggers of a side.
+	 * The matching kernels below are written once against these and
+	 * instantiated for either side, so the comparator and the
+	 * opposite side are resolved at compile time.
+	 *
+	 */
+	template <side Side> inline limit_map<Side> &limits();
+	template <side Side> inline const limit_map<Side> &limits() const;
+	template <side Side> inline peg_maps<Side> &pegs();
+	template <side Side> inline const peg_maps<Side> &pegs() const;
+	template <side Side> inline trigger_map<Side> &triggers();
+
+	/**
+	 * \internal
+	 * @brief Find or create the level at t_price. A new level is
+	 * given a handle and reuses a spare node if there is one.
+	 *
+	 */
+	template <class Limits>
+	inline typename Limits::iterator emplace_level(
+	    Limits &t_limits, const double t_price);
+
+	/**
+	 * \internal
+	 * @brief Erase a level and release its handle. The nodes of
+	 * order levels are kept as spares while there is room.
+	 *
+	 * @return the level following t_limit_it
+	 */
+	template <class Limits>
+	inline typename Limits::iterator erase_level(
+	    Limits &t_limits, typename Limits::iterator t_limit_it);
 
 	/**
 	 * \internal
@@ -66,429 +247,2491 @@ class book {
 	 */
 	inline void end_order_deferral();
 
-	inline void insert_bid(c_order_ptr &t_order);
-	inline void insert_ask(c_order_ptr &t_order);
-
-	inline void insert_aon_bid(c_order_ptr &t_order);
-	inline void insert_aon_ask(c_order_ptr &t_order);
+	/**
+	 * \internal
+	 * @brief Call the on_triggered method of a trigger that fired on
+	 * insertion. Orders it inserts are deferred until it returns.
+	 *
+	 */
+	inline void fire(c_trigger_ptr &t_trigger);
 
 	/**
 	 * \internal
-	 * @brief Check if the bid order can be filled completely. This
-	 * check is performed before all-or-nothing orders are executed.
+	 * @brief Get the group handle stored in an order or trigger.
 	 *
-	 * @param t_order the (all-or-nothing) bid order to be executed.
-	 * @return true the order is completely fillable
-	 * @return false the order is only partially fillable
 	 */
-	inline bool bid_is_fillable(c_order_ptr &t_order) const;
+	static inline std::uint32_t &group_of(const insertable &t_leg);
 
 	/**
 	 * \internal
-	 * @brief Check if the ask order can be filled completely. This
-	 * check is performed before all-or-nothing orders are executed.
+	 * @brief Get a handle for a new group. O(1) amortized.
 	 *
-	 * @param t_order the (all-or-nothing) ask order to be executed.
-	 * @return true the order is completely fillable
-	 * @return false the order is only partially fillable
 	 */
-	inline bool ask_is_fillable(c_order_ptr &t_order) const;
+	inline std::uint32_t acquire_group();
 
-	inline void execute_bid(c_order_ptr &t_order);
-	inline void execute_ask(c_order_ptr &t_order);
+	/**
+	 * \internal
+	 * @brief Detach the remaining legs of a group and free its
+	 * handle.
+	 *
+	 */
+	inline void release_group(const std::uint32_t t_group);
 
-	inline void execute_queued_bid(c_order_ptr &t_order);
-	inline void execute_queued_ask(c_order_ptr &t_order);
+	/**
+	 * \internal
+	 * @brief Called when a leg of a group traded or fired. The leg
+	 * leaves the group. The triggers among the other legs are
+	 * canceled right away. The orders are withdrawn from their levels
+	 * and skipped by the matching loops until they are canceled by
+	 * resolve_groups, as their levels may be in use. The exits of a
+	 * bracket whose entry traded are inserted by resolve_groups as
+	 * well. O(n) in the legs of the group plus the triggers canceled.
+	 *
+	 * @param t_group the group handle stored in the leg
+	 */
+	inline void fire_group(std::uint32_t &t_group);
 
-	inline void queue_bid_order(c_order_ptr &t_order);
-	inline void queue_ask_order(c_order_ptr &t_order);
+	/**
+	 * \internal
+	 * @brief Check if the group of a queued order has fired, in
+	 * which case the order is about to be canceled.
+	 *
+	 */
+	inline bool is_group_fired(const std::uint32_t t_group) const;
 
-	inline void queue_bid_trigger(c_trigger_ptr &t_trigger);
-	inline void queue_ask_trigger(c_trigger_ptr &t_trigger);
+	/**
+	 * \internal
+	 * @brief Cancel the other legs of the fired groups and insert the
+	 * exits of brackets whose entry traded. Called between the waves
+	 * of deferred orders, when no level is being matched.
+	 *
+	 */
+	inline void resolve_groups();
 
 	/**
-	 * @brief Check if any all-or-nothing bids at the specified
-	 * price or lower are executable. This function is called if the
-	 * quantity of queued orders is increased.
+	 * \internal
+	 * @brief Called when a leg of a group was canceled or expired.
+	 * The group is released once none of its legs is queued.
 	 *
-	 * @param t_price the price from which queued all-or-nothing
-	 * will be checked.
 	 */
-	inline void check_bid_aons(const double t_price);
+	inline void leave_group(const std::uint32_t t_group);
 
 	/**
-	 * @brief Check if any all-or-nothing asks at the specified
-	 * price or higher are executable. This function is called if
-	 * the quantity of queued orders is increased.
+	 * \internal
+	 * @brief Insert the legs of a group in order until one of them
+	 * trades or fires.
 	 *
-	 * @param t_price the price from which queued all-or-nothing
-	 * will be checked.
 	 */
-	inline void check_ask_aons(const double t_price);
+	inline void insert_legs(const std::uint32_t t_group);
 
-	public:
-	template <class T, class... Args>
-	inline std::shared_ptr<T> insert(Args &&...args);
+	/**
+	 * \internal
+	 * @brief Link a queued order into the participant index without
+	 * adding it to the open orders of its owner, e.g. the copy of an
+	 * order that is already accounted for. O(1) on average.
+	 *
+	 */
+	inline participant &link(order &t_order);
 
 	/**
-	 * @brief Inserts an order into the book. Marketable orders will
-	 * be executed. Partially filled orders will be queued (or
-	 * canelled if marked as immediate-or-cancel). When the function
-	 * is called from within another order's event handler (like
-	 * on_trade), the order will be deferred and only executed once
-	 * the other order has been handled.
+	 * \internal
+	 * @brief Link a queued order into the participant index and add
+	 * it to the open orders of its owner. O(1) on average.
 	 *
-	 * @param t_order the order to be inserted
 	 */
-	inline void insert(c_order_ptr t_order);
+	inline void index(order &t_order);
 
 	/**
-	 * @brief Inserts a trigger into the book. Unlike orders,
-	 * triggers will cannot be deferred and will instead be queued
-	 * immediately.
+	 * \internal
+	 * @brief Unlink an order from the participant index and remove
+	 * it from the open orders of its owner. O(1) on average.
 	 *
-	 * @param t_trigger the trigger to be inserted
 	 */
-	inline void insert(c_trigger_ptr t_trigger);
+	inline void unindex(order &t_order);
 
-	inline void insert(const insertable &ins);
+	/**
+	 * \internal
+	 * @brief Account for a change of the quantity of a queued order
+	 * of a participant. O(1) on average.
+	 *
+	 */
+	inline void resize_owned(const order &t_order, const double t_change);
 
 	/**
-	 * @brief Get the best bid price.
+	 * \internal
+	 * @brief Account for a fill of an order of a participant. The
+	 * open quantity shrinks if the order is still queued. O(1) on
+	 * average.
 	 *
-	 * @return double the best bid price
 	 */
-	inline double get_bid_price() const;
+	inline void fill_owned(const order &t_order, const double t_quantity,
+	    const double t_price);
 
 	/**
-	 * @brief Get the best ask price.
+	 * \internal
+	 * @brief Check if an order of participant t_owner with
+	 * t_quantity, including hidden quantity, at t_price is within
+	 * the risk limits of the participant. O(1) on average.
 	 *
-	 * @return double the best ask price
+	 * @param t_open true if the current quantity of t_order is
+	 * already open for t_owner, i.e. only the increase counts
+	 * towards its open quantity and the order towards its order
+	 * count already
 	 */
-	inline double get_ask_price() const;
+	template <side Side>
+	inline bool is_within_limits(const std::uint64_t t_owner,
+	    const order &t_order, const double t_price,
+	    const double t_quantity, const bool t_open);
 
 	/**
-	 * @brief Get the price at which the last trade occured.
+	 * \internal
+	 * @brief Index the orders of the levels shared with the book
+	 * this one was forked from by taking copies of them. Does
+	 * nothing once they have been indexed.
 	 *
-	 * @return double the current market price
 	 */
-	inline double get_market_price() const;
+	inline void index_participants();
 
 	/**
-	 * @brief Get an iterator to the first bid price level
+	 * \internal
+	 * @brief Cancel the queued orders of a participant that satisfy
+	 * a predicate. The orders are removed level by level and every
+	 * emptied level is erased once. The event methods are called
+	 * once all of them have been removed. O(n log n) where n is the
+	 * number of orders of the participant.
 	 *
-	 * @return std::map<double, order_limit>::iterator bid begin
-	 * iterator
+	 * @return the number of canceled orders
 	 */
-	inline std::map<double, order_limit>::iterator bid_limits_begin();
+	template <class Predicate>
+	inline std::size_t cancel_owned(
+	    const std::uint64_t t_owner, Predicate t_predicate);
 
 	/**
-	 * @brief Get an iterator to the first ask price level
+	 * \internal
+	 * @brief Publish the top of the book to the snapshot, if
+	 * enabled. Called once an outer operation has completed.
 	 *
-	 * @return std::map<double, order_limit>::iterator ask begin
-	 * iterator
 	 */
-	inline std::map<double, order_limit>::iterator ask_limits_begin();
+	inline void publish();
 
 	/**
-	 * @brief Get an iterator to the end of the bids
+	 * \internal
+	 * @brief Record that the price level at t_price was modified so
+	 * that it is reported to the listener, if any.
 	 *
-	 * @return std::map<double, order_limit>::iterator bid price
-	 * level end iterator
 	 */
-	inline std::map<double, order_limit>::iterator bid_limits_end();
+	inline void touch(const side t_side, const double t_price);
 
 	/**
-	 * @brief Get an iterator to the end of the asks
+	 * \internal
+	 * @brief Report the modified price levels to the listener.
 	 *
-	 * @return std::map<double, order_limit>::iterator ask price
-	 * level end iterator
 	 */
-	inline std::map<double, order_limit>::iterator ask_limits_end();
+	inline void notify_listener();
 
 	/**
-	 * @brief Get bid price limit at specified price
+	 * \internal
+	 * @brief Get the reference price of pegged orders.
 	 *
-	 * @param t_price the price of the bid limit
-	 * @return std::map<double, order_limit>::iterator the bid price
-	 * limit. Equals bid_limits_end() if this price limit does not
-	 * exist.
+	 * @param t_side the side of the pegged orders
+	 * @param t_peg the peg type
+	 * @param t_reference receives the reference price
+	 * @return true the reference price is available
+	 * @return false the best prices it depends on do not exist
 	 */
-	inline std::map<double, order_limit>::iterator bid_limit_at(
-	    const double t_price);
+	inline bool get_peg_reference(const side t_side, const peg_type t_peg,
+	    double &t_reference) const;
 
 	/**
-	 * @brief Get ask price limit at specified price
+	 * \internal
+	 * @brief Get the reference prices of all peg types of a side,
+	 * indexed by peg type - 1.
 	 *
-	 * @param t_price the price of the ask limit
-	 * @return std::map<double, order_limit>::iterator the ask price
-	 * limit. Equals ask_limits_end() if this price limit does not
-	 * exist.
 	 */
-	inline std::map<double, order_limit>::iterator ask_limit_at(
-	    const double t_price);
+	inline void get_peg_references(const side t_side,
+	    double (&t_references)[peg_type_count],
+	    bool (&t_available)[peg_type_count]) const;
 
 	/**
-	 * @brief Get iterator to first order pointer at first
-	 * price limit on bid side
+	 * \internal
+	 * @brief Walk the price levels and peg groups of one side in
+	 * price-time priority up to and including t_bound. Ordinary
+	 * levels precede peg groups at the same price. t_function is
+	 * called with the price, the level and whether it is a peg
+	 * group and returns false to stop. Levels emptied by
+	 * t_function are erased from t_book. Peg groups without an
+	 * available reference price are skipped.
 	 *
-	 * @return bid_order_iterator to order pointer
 	 */
-	inline bid_order_iterator bid_orders_begin();
+	template <class Limits, class Function>
+	inline static void for_each_level(Limits &t_limits,
+	    Limits (&t_pegs)[peg_type_count],
+	    const double (&t_references)[peg_type_count],
+	    const bool (&t_available)[peg_type_count], const double t_bound,
+	    Function t_function, book *t_book = nullptr);
 
 	/**
-	 * @brief Get iterator to first order pointer at first
-	 * price limit on ask side
+	 * \internal
+	 * @brief Erase the price level or peg group of a dequeued order,
+	 * or the level of a dequeued trigger, if it is empty.
 	 *
-	 * @return ask_order_iterator to order pointer
 	 */
-	inline ask_order_iterator ask_orders_begin();
+	template <side Side> inline void erase_if_empty(const order &t_order);
+	template <side Side>
+	inline void erase_if_empty(const trigger &t_trigger);
 
 	/**
-	 * @brief Get iterator to past-the-end order pointer on bid side
+	 * \internal
+	 * @brief Remove a queued order from its level.
 	 *
-	 * @return bid_order_iterator iterator to past-the-end order pointer
+	 * @return order_ptr the reference that kept the order alive
 	 */
-	inline bid_order_iterator bid_orders_end();
+	template <side Side> inline order_ptr dequeue(order &t_order);
 
 	/**
-	 * @brief Get iterator to past-the-end order pointer on ask side
+	 * \internal
+	 * @brief Change the quantity of a queued order and execute
+	 * whatever became executable.
 	 *
-	 * @return ask_order_iterator iterator to past-the-end order pointer
 	 */
-	inline ask_order_iterator ask_orders_end();
+	template <side Side>
+	inline bool set_quantity(c_order_ptr &t_order, const double t_quantity);
 
-	~book();
+	/**
+	 * \internal
+	 * @brief The side-specialized body of replace.
+	 *
+	 */
+	template <side Side>
+	inline bool replace_order(c_order_ptr &t_order, const double t_price,
+	    const double t_quantity);
 
-	friend std::ostream &operator<<(std::ostream &t_os, const book &t_book);
-	friend order;
-	friend trigger;
-};
+	/**
+	 * \internal
+	 * @brief Make sure a timer is pending for the expiry of a
+	 * queued order or trigger. Objects whose expiry has passed
+	 * expire immediately.
+	 *
+	 */
+	template <class T>
+	inline void schedule_expiry(const std::shared_ptr<T> &t_object);
 
-} // namespace elob
+	/**
+	 * \internal
+	 * @brief Handle a timer of an order or trigger that fired at
+	 * t_timer.
+	 *
+	 */
+	template <class T>
+	inline void on_timer(
+	    const std::shared_ptr<T> &t_object, const std::uint64_t t_timer);
 
-#include "common.hpp"
-#include "insertable.hpp"
-#include "insertable_iterator.hpp"
-#include "order.hpp"
-#include "order_limit.hpp"
-#include "trigger.hpp"
-#include "trigger_limit.hpp"
-#include <iomanip>
+	inline void expire(c_order_ptr &t_order);
+	inline void expire(c_trigger_ptr &t_trigger);
 
-std::ostream &elob::operator<<(std::ostream &t_os, const elob::book &t_book) {
-	std::size_t w = 12;
-	auto bid_it = t_book.m_bids.begin();
-	auto ask_it = t_book.m_asks.begin();
-	t_os << "┌─────────────────BIDS─────────────────"
-	     << "┬─────────────────ASKS─────────────────┐\n";
-	t_os << "│ " << std::setw(w) << "PRC" << std::setw(w) << "QTY"
-	     << std::setw(w) << "AON QTY"
-	     << " │ ";
-	t_os << std::setw(w) << "PRC" << std::setw(w) << "QTY" << std::setw(w)
-	     << "AON QTY"
-	     << " │\n";
+	/**
+	 * \internal
+	 * @brief Dequeue the orders of t_limits that have an expiry.
+	 * Levels in which every order expires are freed at once.
+	 *
+	 * @param t_expired receives the dequeued orders
+	 */
+	template <class Limits>
+	inline void expire_levels(Limits &t_limits, const side t_side,
+	    const bool t_pegged, std::vector<order_ptr> &t_expired);
 
-	while (true) {
+	/**
+	 * \internal
+	 * @brief Match an accepted order and queue the remainder or, in
+	 * an auction, queue it right away.
+	 *
+	 */
+	template <side Side> inline void match_or_queue(c_order_ptr &t_order);
 
-		if (bid_it == t_book.m_bids.end() &&
-		    ask_it == t_book.m_asks.end()) {
-			break;
-		}
+	/**
+	 * \internal
+	 * @brief Validate an order and match or queue it right away, even
+	 * while orders are deferred. Called by insert<Side> unless it
+	 * defers the order.
+	 *
+	 */
+	template <side Side> inline void insert_now(c_order_ptr &t_order);
 
-		if (bid_it != t_book.m_bids.end()) {
-			t_os << "│ " << std::setw(w) << bid_it->first
-			     << std::setw(w) << bid_it->second.get_quantity()
-			     << std::setw(w)
-			     << bid_it->second.get_aon_quantity() << " │ ";
-			bid_it++;
-		} else {
-			t_os << "│ " << std::setw(36) << ' ' << " │ ";
-		}
+	/**
+	 * \internal
+	 * @brief Compute the price that maximizes the executable
+	 * quantity of the crossed part of the book. Ties are broken by
+	 * the smaller imbalance and then by the distance to the market
+	 * price or, if there has not been a trade, to the midpoint of
+	 * the best prices. All-or-nothing and pegged orders are not
+	 * taken into account.
+	 *
+	 * @param t_price receives the price, -1.0 if not crossed
+	 * @param t_volume receives the executable quantity
+	 */
+	inline void compute_clearing_price(
+	    double &t_price, double &t_volume) const;
 
-		if (ask_it != t_book.m_asks.end()) {
-			if (ask_it->second.order_count() > 0) {
-				t_os << std::setw(w) << ask_it->first
-				     << std::setw(w)
-				     << ask_it->second.get_quantity()
-				     << std::setw(w)
-				     << ask_it->second.get_aon_quantity()
-				     << " │\n";
-			}
-			ask_it++;
-		} else {
-			t_os << std::setw(36) << ' ' << " │\n";
-		}
-	}
+	/**
+	 * \internal
+	 * @brief Trade t_order against the levels of t_limits at or
+	 * better than its price in price-time priority.
+	 *
+	 */
+	template <class Limits>
+	inline void fill_at_clearing_price(
+	    Limits &t_limits, const side t_side, c_order_ptr &t_order);
 
-	return t_os;
-}
+	/**
+	 * \internal
+	 * @brief Trigger the triggers of a side that the market price
+	 * has reached: bid triggers at or above it and ask triggers at
+	 * or below it.
+	 *
+	 */
+	template <side Side> inline void fire_triggers();
 
-template <class T, class... Args>
-std::shared_ptr<T> elob::book::insert(Args &&...args) {
-	auto ptr = std::make_shared<T>(std::forward<Args>(args)...);
-	insert(ptr);
-	return ptr;
-}
+	/**
+	 * \internal
+	 * @brief Cache the price of the first trigger level of a side
+	 * after its trigger levels have changed.
+	 *
+	 */
+	template <side Side> inline void cache_trigger_price();
 
-void elob::book::insert(elob::c_order_ptr t_order) {
-	// check if order is valid
-	if (m_order_deferral_depth > 0) {
+	/**
+	 * \internal
+	 * @brief Trade t_order against a level according to the
+	 * matching policy.
+	 *
+	 * @return the traded quantity
+	 */
+	inline double trade(
+	    order_limit &t_limit, c_order_ptr &t_order, const double t_price);
+
+	/**
+	 * \internal
+	 * @brief Execute the crossed orders at the clearing price and
+	 * end the auction.
+	 *
+	 */
+	inline void clear_auction();
+
+	/**
+	 * \internal
+	 * @brief Fire the expiry timers due by t_time.
+	 *
+	 */
+	inline void advance_timers(const std::uint64_t t_time);
+
+	template <side Side> inline void insert_order(c_order_ptr &t_order);
+	template <side Side>
+	inline void insert_aon_order(c_order_ptr &t_order);
+
+	/**
+	 * \internal
+	 * @brief Check if the order can be filled completely. This
+	 * check is performed before all-or-nothing orders are executed.
+	 *
+	 * @param t_order the (all-or-nothing) order to be executed.
+	 * @return true the order is completely fillable
+	 * @return false the order is only partially fillable
+	 */
+	template <side Side>
+	inline bool is_fillable(c_order_ptr &t_order) const;
+
+	/**
+	 * \internal
+	 * @brief Get the quantity an inbound order would trade at a
+	 * price level, respecting queued all-or-nothing orders.
+	 *
+	 * @param t_limit the price level
+	 * @param t_quantity the quantity of the inbound order
+	 * @return double the traded quantity
+	 */
+	inline static double simulate_fill(
+	    const order_limit &t_limit, const double t_quantity);
+
+	/**
+	 * \internal
+	 * @brief Walk the price levels of one side once and accumulate
+	 * the fills of t_count hypothetical market orders.
+	 *
+	 */
+	template <class Limits>
+	inline void simulate_market_orders(const Limits &t_limits,
+	    const Limits (&t_pegs)[peg_type_count], const side t_side,
+	    const double t_limit_price, const double *t_quantities,
+	    market_impact *t_impacts, const std::size_t t_count) const;
+
+	template <side Side> inline void execute(c_order_ptr &t_order);
+	template <side Side> inline void execute_queued(c_order_ptr &t_order);
+
+	template <side Side> inline void queue_order(c_order_ptr &t_order);
+	template <side Side> inline void queue_peg_order(c_order_ptr &t_order);
+	template <side Side>
+	inline void queue_trigger(c_trigger_ptr &t_trigger);
+
+	/**
+	 * @brief Check if any all-or-nothing orders of a side at the
+	 * specified price or worse are executable. This function is
+	 * called if the quantity of queued orders is increased.
+	 *
+	 * @param t_price the price from which queued all-or-nothing
+	 * will be checked.
+	 */
+	template <side Side> inline void check_aons(const double t_price);
+
+	public:
+	/**
+	 * @brief Construct a new book object.
+	 *
+	 * @param t_matching_policy how an inbound order is allocated
+	 * among the orders of a level. fifo fills them in time
+	 * priority. pro_rata allocates in proportion to their displayed
+	 * quantity and top_pro_rata fills the oldest order first and
+	 * allocates the rest pro rata. A level that the inbound order
+	 * sweeps entirely, all-or-nothing orders and quantity left over
+	 * by rounding are filled in time priority.
+	 * @param t_lot_size the unit in which pro rata shares are
+	 * rounded
+	 */
+	inline explicit book(const matching_policy t_matching_policy = fifo,
+	    const double t_lot_size = 1.0);
+
+	template <class T, class... Args>
+	inline std::shared_ptr<T> insert(Args &&...args);
+
+	/**
+	 * @brief Inserts an order into the book. Marketable orders will
+	 * be executed. Partially filled orders will be queued (or
+	 * canelled if marked as immediate-or-cancel). When the function
+	 * is called from within another order's event handler (like
+	 * on_trade), the order will be deferred and only executed once
+	 * the other order has been handled.
+	 *
+	 * @param t_order the order to be inserted
+	 */
+	inline void insert(c_order_ptr &t_order);
+
+	/**
+	 * @brief Inserts a trigger into the book. Unlike orders,
+	 * triggers will cannot be deferred and will instead be queued
+	 * immediately.
+	 *
+	 * @param t_trigger the trigger to be inserted
+	 */
+	inline void insert(c_trigger_ptr &t_trigger);
+
+	/**
+	 * @brief Insert an order or trigger of a side known at compile
+	 * time, e.g. in replays or batch paths. Skips the dispatch on the
+	 * side of t_object; objects of the other side are rejected.
+	 * Otherwise equivalent to insert(t_object).
+	 *
+	 * @tparam Side the side of t_object
+	 * @param t_object the order or trigger to be inserted
+	 */
+	template <side Side> inline void insert(c_order_ptr &t_object);
+	template <side Side> inline void insert(c_trigger_ptr &t_object);
+
+	inline void insert(const insertable &ins);
+
+	/**
+	 * @brief Insert orders and triggers as a one-cancels-other
+	 * group. Once one of them trades or fires, the others are
+	 * canceled. They are not matched in the meantime and are
+	 * canceled before any order deferred by the operation executes.
+	 * The legs are inserted in the given order; once one trades or
+	 * fires on insertion, the remaining ones are not inserted. A
+	 * canceled or expired leg leaves the group. The legs must not
+	 * belong to another group. Forks do not inherit groups. Must not
+	 * be called from within event methods.
+	 *
+	 * @param t_legs the orders and triggers of the group
+	 */
+	inline void insert_oco(const std::vector<insertable> &t_legs);
+
+	/**
+	 * @brief Insert an order with exits, e.g. a take profit order
+	 * and a stop order. Once the entry trades for the first time,
+	 * the exits are inserted as a one-cancels-other group (see
+	 * insert_oco). They are discarded if the entry is canceled or
+	 * expires before. Must not be called from within event methods.
+	 *
+	 * @param t_entry the entry order
+	 * @param t_exits the orders and triggers inserted once the entry
+	 * has traded
+	 */
+	inline void insert_bracket(
+	    c_order_ptr &t_entry, const std::vector<insertable> &t_exits);
+
+	/**
+	 * @brief Cancel all queued orders of a participant, e.g. as a
+	 * kill switch. on_canceled is called once all of them have been
+	 * removed. O(n log n) where n is the number of orders of the
+	 * participant. A fork first indexes the orders of the levels it
+	 * still shares, which takes a copy of them. Must not be called
+	 * from within event methods.
+	 *
+	 * @param t_owner the owner id of the participant
+	 * @return the number of canceled orders
+	 */
+	inline std::size_t mass_cancel(const std::uint64_t t_owner);
+
+	/**
+	 * @brief Cancel the queued orders of a participant at one side
+	 * of the book priced within [t_min_price, t_max_price]. Pegged
+	 * orders are canceled if their current price is in range. See
+	 * mass_cancel(t_owner).
+	 *
+	 * @param t_owner the owner id of the participant
+	 * @param t_side the side of the orders
+	 * @param t_min_price the lowest price of the orders
+	 * @param t_max_price the highest price of the orders
+	 * @return the number of canceled orders
+	 */
+	inline std::size_t mass_cancel(const std::uint64_t t_owner,
+	    const side t_side, const double t_min_price = 0.0,
+	    const double t_max_price = max_price);
+
+	/**
+	 * @brief Replace the quotes of a participant. Its queued orders
+	 * are canceled and the new quotes, which become owned by the
+	 * participant, are inserted in the given order. The book
+	 * publishes a single update for the whole operation and only
+	 * the orders released by the quotes count towards its cascade
+	 * statistics. Must not be called from within event methods.
+	 *
+	 * @param t_owner the owner id of the participant
+	 * @param t_quotes the orders that replace the queued ones
+	 * @return the number of canceled orders
+	 */
+	inline std::size_t mass_quote(const std::uint64_t t_owner,
+	    const std::vector<order_ptr> &t_quotes);
+
+	/**
+	 * @brief Set the pre-trade limits of a participant. Inserted
+	 * orders of the participant that would exceed them are rejected
+	 * before they execute. The limits are checked against the open
+	 * orders and fills of the participant in O(1); bids are valued
+	 * at their price, market bids at the best ask, and asks at
+	 * their price or the best bid, whichever is higher. Orders that
+	 * are already queued and replaced orders are not checked. Forks
+	 * inherit the limits.
+	 *
+	 * @param t_owner the owner id of the participant
+	 * @param t_limits the new limits
+	 */
+	inline void set_risk_limits(
+	    const std::uint64_t t_owner, const risk_limits &t_limits);
+
+	/**
+	 * @brief Get the open orders and fills of a participant. They are
+	 * kept up to date as its orders are queued, traded and
+	 * canceled.
+	 *
+	 * @param t_owner the owner id of the participant
+	 * @return the risk of the participant, all zero if it has had
+	 * no orders in this book
+	 */
+	inline participant_risk get_participant_risk(
+	    const std::uint64_t t_owner) const;
+
+	/**
+	 * @brief Atomically change the price and quantity of a queued
+	 * order. For iceberg orders, the quantity includes the hidden
+	 * part. The order keeps its time priority if only its
+	 * quantity is reduced. Otherwise it moves behind the orders
+	 * at its (new) price level and, if its price changed, is
+	 * matched like a newly inserted order. Unlike cancelling and
+	 * inserting a new order, the order object and, if it does not
+	 * empty, its price level are reused.
+	 *
+	 * @param t_order the queued order
+	 * @param t_price the new price
+	 * @param t_quantity the new quantity
+	 * @return true the order was replaced
+	 * @return false the order is not queued in this book, is
+	 * pegged, the quantity is not positive or the order would
+	 * exceed the risk limits of its owner
+	 */
+	inline bool replace(c_order_ptr &t_order, const double t_price,
+	    const double t_quantity);
+
+	/**
+	 * @brief Get the best bid price. Pegged orders are not
+	 * considered.
+	 *
+	 * @return double the best bid price
+	 */
+	inline double get_bid_price() const;
+
+	/**
+	 * @brief Get the best ask price. Pegged orders are not
+	 * considered.
+	 *
+	 * @return double the best ask price
+	 */
+	inline double get_ask_price() const;
+
+	/**
+	 * @brief Get the price at which the last trade occured.
+	 *
+	 * @return double the current market price
+	 */
+	inline double get_market_price() const;
+
+	/**
+	 * @brief Get the statistics of the cascade of stops and other
+	 * orders released by event methods during the last operation,
+	 * e.g. the last insertion.
+	 *
+	 * @return const cascade_stats& the statistics
+	 */
+	inline const cascade_stats &get_cascade_stats() const;
+
+	/**
+	 * @brief Get the current price of pegged orders. Inbound orders
+	 * trade against pegged orders at the prices derived from the
+	 * reference prices at the time of their insertion.
+	 *
+	 * @param t_side the side of the pegged orders
+	 * @param t_peg the peg type
+	 * @param t_offset the offset from the reference price
+	 * @return double the price or -1.0 if the reference price is
+	 * unavailable
+	 */
+	inline double get_peg_price(const side t_side, const peg_type t_peg,
+	    const double t_offset) const;
+
+	/**
+	 * @brief Get the logical clock of the book. It starts at 0 and
+	 * is only moved by advance_time.
+	 *
+	 * @return std::uint64_t the current time
+	 */
+	inline std::uint64_t get_time() const;
+
+	/**
+	 * @brief Advance the logical clock and expire every order and
+	 * trigger whose expiry is at or before t_time, in the order of
+	 * their expiry. Expired orders are canceled and their
+	 * on_canceled method is called. Orders inserted from within
+	 * those event methods are deferred until all timers have been
+	 * handled. Advancing costs O(1) per expired object amortized,
+	 * regardless of the distance advanced. In batch mode the
+	 * batches that end by t_time are cleared at their boundaries
+	 * (see set_batch_interval). Must not be called from within
+	 * event methods.
+	 *
+	 * @param t_time the new time. Earlier times are ignored.
+	 */
+	inline void advance_time(const std::uint64_t t_time);
+
+	/**
+	 * @brief Expire every order and trigger that has an expiry,
+	 * independent of the clock, e.g. at the end of a session.
+	 * Price levels in which every order expires are freed as a
+	 * whole rather than order by order. Must not be called from
+	 * within event methods.
+	 *
+	 */
+	inline void expire_all();
+
+	/**
+	 * @brief Start a call auction. Until uncross is called, inserted
+	 * orders are queued without being matched, even if they cross
+	 * the book, and immediate-or-cancel orders are canceled.
+	 *
+	 */
+	inline void begin_auction();
+
+	/**
+	 * @brief End the auction. The crossed orders execute at a
+	 * single price that maximizes the executed quantity (see
+	 * get_indicative_price) in price-time priority, and the
+	 * triggers fire once. Queued orders trade against an order
+	 * representing the auction, priced at the clearing price, and
+	 * the trade is reported to the listener as one bid of the
+	 * entire volume. All-or-nothing orders only execute if the
+	 * volume reaches them in full. Remaining orders stay queued and
+	 * continuous matching resumes.
+	 *
+	 */
+	inline void uncross();
+
+	/**
+	 * @brief Check if the book is in an auction.
+	 *
+	 * @return true orders are queued until uncross is called
+	 * @return false orders are matched on insertion
+	 */
+	inline bool is_auction() const;
+
+	/**
+	 * @brief Get the price at which the auction would uncross if it
+	 * ended now. The price maximizes the executable quantity; ties
+	 * are broken by the smaller imbalance and then by the distance
+	 * to the market price or, without one, to the midpoint of the
+	 * best prices. All-or-nothing and pegged orders do not
+	 * participate in the computation. Updated once every outer
+	 * operation has completed.
+	 *
+	 * @return double the indicative price or -1.0 if the book is
+	 * not crossed or not in an auction
+	 */
+	inline double get_indicative_price() const;
+
+	/**
+	 * @brief Get the quantity that would execute if the auction
+	 * ended now.
+	 *
+	 * @return double the indicative volume
+	 */
+	inline double get_indicative_volume() const;
+
+	/**
+	 * @brief Switch to frequent batch auctions. Inserted orders are
+	 * queued as in a call auction and the book is uncrossed
+	 * whenever advance_time passes a multiple of t_interval.
+	 * Immediate-or-cancel orders take part in the next batch and
+	 * are canceled afterwards. Orders inserted by event methods
+	 * during the clearing join the following batch. Clearing costs
+	 * O(log n) plus the crossed levels, and batches in which no
+	 * crossing level changed are skipped, so advancing over empty
+	 * intervals is free. No indicative price is published while
+	 * batching. Must not be called from within event methods.
+	 *
+	 * @param t_interval the length of a batch on the clock of the
+	 * book, or 0 to clear the pending batch and resume continuous
+	 * matching
+	 */
+	inline void set_batch_interval(const std::uint64_t t_interval);
+
+	/**
+	 * @brief Get the length of a batch.
+	 *
+	 * @return std::uint64_t the batch interval or 0 if orders are
+	 * matched continuously or in a call auction
+	 */
+	inline std::uint64_t get_batch_interval() const;
+
+	/**
+	 * @brief Get the matching policy of the book.
+	 *
+	 * @return matching_policy the policy
+	 */
+	inline matching_policy get_matching_policy() const;
+
+	/**
+	 * @brief Get the unit in which pro rata shares are rounded.
+	 *
+	 * @return double the lot size
+	 */
+	inline double get_lot_size() const;
+
+	/**
+	 * @brief Switch lazy cancellation on or off. A lazily canceled
+	 * order is removed from the totals of its level and its entry
+	 * in the queue is overwritten with a nullptr instead of being
+	 * unlinked. The entries are unlinked when a trade passes over
+	 * them, when they outnumber the orders of the level, when the
+	 * orders of the level are iterated or when compact is called.
+	 * Fills and market data are the same in either mode.
+	 * All-or-nothing orders are always unlinked.
+	 *
+	 * @param t_lazy true to cancel lazily
+	 */
+	inline void set_lazy_cancel(const bool t_lazy);
+
+	/**
+	 * @brief Check if orders are canceled lazily.
+	 *
+	 * @return true if orders are canceled lazily
+	 */
+	inline bool is_lazy_cancel() const;
+
+	/**
+	 * @brief Unlink the entries of lazily canceled orders from all
+	 * price levels, e.g. while the market is idle. O(n).
+	 *
+	 */
+	inline void compact();
+
+	/**
+	 * @brief Compute the outcome of a market order without
+	 * inserting it. The book is not modified, no event methods are
+	 * called and no memory is allocated.
+	 *
+	 * @param t_side the side of the hypothetical order. Bids trade
+	 * against asks and vice versa.
+	 * @param t_quantity the quantity of the hypothetical order
+	 * @param t_limit_price the worst price the order may trade at.
+	 * Pass max_price (bid) or min_price (ask) for a market order.
+	 * @return market_impact the fills the order would receive
+	 */
+	inline market_impact simulate_market_order(const side t_side,
+	    const double t_quantity, const double t_limit_price) const;
+
+	/**
+	 * @brief Compute the outcome of several market orders of
+	 * different quantities in a single pass over the price levels.
+	 * Each quantity is simulated independently against the
+	 * current book. t_impacts is resized to the number of
+	 * quantities, so reusing it avoids allocation.
+	 *
+	 * @param t_side the side of the hypothetical orders
+	 * @param t_quantities the quantities of the hypothetical orders
+	 * @param t_impacts receives one result per quantity
+	 * @param t_limit_price the worst price the orders may trade at
+	 */
+	inline void simulate_market_orders(const side t_side,
+	    const std::vector<double> &t_quantities,
+	    std::vector<market_impact> &t_impacts,
+	    const double t_limit_price) const;
+
+	/**
+	 * @brief Enable publication of the top snapshot_depth price
+	 * levels and the last trade into a seqlock-protected snapshot.
+	 * The snapshot is updated once every outer insertion,
+	 * cancellation or quantity update has completed and can be read
+	 * from other threads without locking the book.
+	 *
+	 * @return const snapshot& the snapshot readers should poll
+	 */
+	inline const snapshot &enable_snapshot();
+
+	/**
+	 * @brief Get the published snapshot.
+	 *
+	 * @return const snapshot* the snapshot or nullptr if
+	 * publication has not been enabled.
+	 */
+	inline const snapshot *get_snapshot() const;
+
+	/**
+	 * @brief Attach a market data listener. Trades are reported as
+	 * they occur, modified price levels once every outer operation
+	 * has completed. The listener must outlive the book or be
+	 * detached by passing nullptr.
+	 *
+	 * @param t_listener the listener or nullptr to detach it
+	 */
+	inline void set_listener(listener *t_listener);
+
+	/**
+	 * @brief Create a copy of the book for what-if simulation.
+	 * Price levels are shared with the copy until either book
+	 * modifies them, so forking costs a copy of the price index
+	 * rather than of every queued order. Orders inserted into the
+	 * fork trade against copies of the queued orders; the event
+	 * methods of the original orders are never called and the
+	 * original book is left unchanged. Pegged orders are forked
+	 * like price levels. The clock is copied but orders do not
+	 * expire in the fork. The auction state and batch interval are
+	 * copied, but immediate-or-cancel orders of a pending batch
+	 * stay queued in the fork. Triggers, the snapshot and the
+	 * listener are not carried over. Must not be called from
+	 * within event methods.
+	 *
+	 * @return std::unique_ptr<book> the fork
+	 */
+	inline std::unique_ptr<book> fork() const;
+
+	/**
+	 * @brief Get an iterator to the first bid price level
+	 *
+	 * @return std::map<double, order_limit>::iterator bid begin
+	 * iterator
+	 */
+	inline std::map<double, order_limit>::iterator bid_limits_begin();
+
+	/**
+	 * @brief Get an iterator to the first ask price level
+	 *
+	 * @return std::map<double, order_limit>::iterator ask begin
+	 * iterator
+	 */
+	inline std::map<double, order_limit>::iterator ask_limits_begin();
+
+	/**
+	 * @brief Get an iterator to the end of the bids
+	 *
+	 * @return std::map<double, order_limit>::iterator bid price
+	 * level end iterator
+	 */
+	inline std::map<double, order_limit>::iterator bid_limits_end();
+
+	/**
+	 * @brief Get an iterator to the end of the asks
+	 *
+	 * @return std::map<double, order_limit>::iterator ask price
+	 * level end iterator
+	 */
+	inline std::map<double, order_limit>::iterator ask_limits_end();
+
+	/**
+	 * @brief Get bid price limit at specified price
+	 *
+	 * @param t_price the price of the bid limit
+	 * @return std::map<double, order_limit>::iterator the bid price
+	 * limit. Equals bid_limits_end() if this price limit does not
+	 * exist.
+	 */
+	inline std::map<double, order_limit>::iterator bid_limit_at(
+	    const double t_price);
+
+	/**
+	 * @brief Get ask price limit at specified price
+	 *
+	 * @param t_price the price of the ask limit
+	 * @return std::map<double, order_limit>::iterator the ask price
+	 * limit. Equals ask_limits_end() if this price limit does not
+	 * exist.
+	 */
+	inline std::map<double, order_limit>::iterator ask_limit_at(
+	    const double t_price);
+
+	/**
+	 * @brief Get iterator to first order pointer at first
+	 * price limit on bid side
+	 *
+	 * @return bid_order_iterator to order pointer
+	 */
+	inline bid_order_iterator bid_orders_begin();
+
+	/**
+	 * @brief Get iterator to first order pointer at first
+	 * price limit on ask side
+	 *
+	 * @return ask_order_iterator to order pointer
+	 */
+	inline ask_order_iterator ask_orders_begin();
+
+	/**
+	 * @brief Get iterator to past-the-end order pointer on bid side
+	 *
+	 * @return bid_order_iterator iterator to past-the-end order pointer
+	 */
+	inline bid_order_iterator bid_orders_end();
+
+	/**
+	 * @brief Get iterator to past-the-end order pointer on ask side
+	 *
+	 * @return ask_order_iterator iterator to past-the-end order pointer
+	 */
+	inline ask_order_iterator ask_orders_end();
+
+	~book();
+
+	friend std::ostream &operator<<(std::ostream &t_os, const book &t_book);
+	friend order;
+	friend order_limit;
+	friend trigger;
+	friend trigger_limit;
+};
+
+} // namespace elob
+
+#include "common.hpp"
+#include "insertable_iterator.hpp"
+#include "order.hpp"
+#include "order_limit.hpp"
+#include "trigger.hpp"
+#include "trigger_limit.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iterator>
+#include <type_traits>
+
+std::ostream &elob::operator<<(std::ostream &t_os, const elob::book &t_book) {
+	std::size_t w = 12;
+	auto bid_it = t_book.m_bids.begin();
+	auto ask_it = t_book.m_asks.begin();
+	t_os << "┌─────────────────BIDS─────────────────"
+	     << "┬─────────────────ASKS─────────────────┐\n";
+	t_os << "│ " << std::setw(w) << "PRC" << std::setw(w) << "QTY"
+	     << std::setw(w) << "AON QTY"
+	     << " │ ";
+	t_os << std::setw(w) << "PRC" << std::setw(w) << "QTY" << std::setw(w)
+	     << "AON QTY"
+	     << " │\n";
+
+	while (true) {
+
+		if (bid_it == t_book.m_bids.end() &&
+		    ask_it == t_book.m_asks.end()) {
+			break;
+		}
+
+		if (bid_it != t_book.m_bids.end()) {
+			t_os << "│ " << std::setw(w) << bid_it->first
+			     << std::setw(w) << bid_it->second.get_quantity()
+			     << std::setw(w)
+			     << bid_it->second.get_aon_quantity() << " │ ";
+			bid_it++;
+		} else {
+			t_os << "│ " << std::setw(36) << ' ' << " │ ";
+		}
+
+		if (ask_it != t_book.m_asks.end()) {
+			if (ask_it->second.order_count() > 0) {
+				t_os << std::setw(w) << ask_it->first
+				     << std::setw(w)
+				     << ask_it->second.get_quantity()
+				     << std::setw(w)
+				     << ask_it->second.get_aon_quantity()
+				     << " │\n";
+			}
+			ask_it++;
+		} else {
+			t_os << std::setw(36) << ' ' << " │\n";
+		}
+	}
+
+	return t_os;
+}
+
+template <class T, class... Args>
+std::shared_ptr<T> elob::book::insert(Args &&...args) {
+	auto ptr = std::make_shared<T>(std::forward<Args>(args)...);
+	insert(ptr);
+	return ptr;
+}
+
+void elob::book::insert(elob::c_order_ptr &t_order) {
+	if (t_order->m_side == elob::side::bid) {
+		insert<elob::side::bid>(t_order);
+	} else {
+		insert<elob::side::ask>(t_order);
+	}
+}
+
+template <elob::side Side>
+void elob::book::insert(elob::c_order_ptr &t_order) {
+	// deferred orders are inserted by their side, so orders of the
+	// other side are rejected right away
+	if (m_order_deferral_depth > 0 && t_order->m_side == Side) {
 		m_deferred.push(t_order);
 		return;
 	}
 
-	begin_order_deferral();
+	insert_now<Side>(t_order);
+}
+
+template <elob::side Side>
+void elob::book::insert_now(elob::c_order_ptr &t_order) {
+	// check if order is valid
+	begin_order_deferral();
+
+	if (t_order->m_quantity <= 0.0) {
+		t_order->on_rejected();
+		end_order_deferral();
+		return;
+	}
+
+	if (t_order->m_queued || t_order->m_side != Side) {
+		t_order->on_rejected();
+		end_order_deferral();
+		return;
+	}
+
+	if (t_order->m_expiry != 0 && t_order->m_expiry <= m_time) {
+		t_order->on_rejected();
+		end_order_deferral();
+		return;
+	}
+
+	// pegged orders must not be priced through the reference price
+	if (t_order->is_pegged() &&
+	    (Side == elob::side::bid ? t_order->m_offset > 0.0
+				     : t_order->m_offset < 0.0)) {
+		t_order->on_rejected();
+		end_order_deferral();
+		return;
+	}
+
+	if (t_order->m_owner != 0 &&
+	    !is_within_limits<Side>(t_order->m_owner, *t_order,
+		t_order->m_price,
+		t_order->m_quantity + t_order->m_hidden_quantity, false)) {
+		t_order->on_rejected();
+		end_order_deferral();
+		return;
+	}
+
+	// order is valid
+	t_order->m_book = this;
+
+	if (t_order->is_pegged()) {
+		t_order->on_accepted();
+		queue_peg_order<Side>(t_order);
+		schedule_expiry(t_order);
+		end_order_deferral();
+		return;
+	}
+
+	// iceberg orders trade their entire quantity on entry
+	t_order->m_quantity += t_order->m_hidden_quantity;
+	t_order->m_hidden_quantity = 0.0;
+	t_order->on_accepted();
+	match_or_queue<Side>(t_order);
+
+	if (t_order->m_queued) {
+		schedule_expiry(t_order);
+	}
+
+	end_order_deferral();
+}
+
+bool elob::book::replace(elob::c_order_ptr &t_order, const double t_price,
+    const double t_quantity) {
+	if (!t_order->m_queued || t_order->m_book != this ||
+	    t_order->is_pegged() || t_quantity <= 0.0) {
+		return false;
+	}
+
+	if (t_order->m_side == elob::side::bid) {
+		return replace_order<elob::side::bid>(
+		    t_order, t_price, t_quantity);
+	}
+
+	return replace_order<elob::side::ask>(t_order, t_price, t_quantity);
+}
+
+template <elob::side Side>
+bool elob::book::replace_order(elob::c_order_ptr &t_order,
+    const double t_price, const double t_quantity) {
+	constexpr elob::side opposite = side_traits<Side>::opposite;
+
+	// a new price or a larger quantity must stay within the limits
+	if (t_order->m_owner != 0 &&
+	    (t_price != t_order->m_price ||
+		t_quantity > t_order->m_quantity +
+				 t_order->m_hidden_quantity) &&
+	    !is_within_limits<Side>(t_order->m_owner, *t_order, t_price,
+		t_quantity, true)) {
+		return false;
+	}
+
+	begin_order_deferral();
+	auto &limit_obj = m_levels[t_order->m_level]->second;
+	limit_obj.unshare(this);
+	touch(Side, t_order->m_price);
+
+	if (t_price == t_order->m_price) {
+		// the quantity of iceberg orders includes the hidden part
+		const double quantity_change = t_quantity -
+					       t_order->m_quantity -
+					       t_order->m_hidden_quantity;
+
+		if (t_order->m_owner != 0) {
+			resize_owned(*t_order, quantity_change);
+		}
+
+		if (t_order->m_all_or_nothing) {
+			if (!t_order->m_withdrawn) {
+				limit_obj.m_aon_quantity += quantity_change;
+			}
+
+			t_order->m_quantity = t_quantity;
+		} else {
+			const double displayed_quantity =
+			    t_order->is_iceberg()
+				? std::min(t_order->m_quantity, t_quantity)
+				: t_quantity;
+
+			if (!t_order->m_withdrawn) {
+				limit_obj.m_quantity +=
+				    displayed_quantity - t_order->m_quantity;
+				limit_obj.m_hidden_quantity +=
+				    t_quantity - displayed_quantity -
+				    t_order->m_hidden_quantity;
+			}
+
+			t_order->m_quantity = displayed_quantity;
+			t_order->m_hidden_quantity =
+			    t_quantity - displayed_quantity;
+		}
+
+		limit_obj.update(t_order.get());
+
+		// only size reductions keep time priority
+		if (quantity_change > 0.0) {
+			limit_obj.requeue(t_order->m_order_slot);
+		}
+
+		t_order->on_replaced();
+
+		if (quantity_change > 0.0) {
+			// the larger order may fill all-or-nothing orders
+			check_aons<opposite>(t_price);
+		} else if (t_order->m_all_or_nothing && !m_auction &&
+			   !t_order->m_withdrawn &&
+			   is_fillable<Side>(t_order)) {
+			// the smaller all-or-nothing order became fillable
+			execute_queued<Side>(t_order);
+			const order_ptr self =
+			    limit_obj.erase(t_order->m_order_slot);
+			erase_if_empty<Side>(*t_order);
+			t_order->m_book = nullptr;
+		}
+
+		end_order_deferral();
+		return true;
+	}
+
+	// price changes lose time priority and may execute
+	const order_ptr self = limit_obj.erase(t_order->m_order_slot);
+	erase_if_empty<Side>(*t_order);
+	t_order->m_price = t_price;
+	t_order->m_quantity = t_quantity;
+	t_order->m_hidden_quantity = 0.0;
+	t_order->on_replaced();
+	match_or_queue<Side>(self);
+	end_order_deferral();
+	return true;
+}
+
+template <elob::side Side>
+void elob::book::match_or_queue(elob::c_order_ptr &t_order) {
+	// during an auction orders only execute when it is uncrossed
+	if (m_auction) {
+		if (t_order->m_immediate_or_cancel && m_batch_interval == 0) {
+			t_order->on_canceled();
+			t_order->m_book = nullptr;
+			return;
+		}
+
+		if (t_order->m_immediate_or_cancel) {
+			m_batch_iocs.push_back(t_order);
+		}
+
+		queue_order<Side>(t_order);
+		return;
+	}
+
+	if (t_order->m_all_or_nothing) {
+		insert_aon_order<Side>(t_order);
+	} else {
+		insert_order<Side>(t_order);
+	}
+}
+
+template <elob::side Side>
+elob::book::limit_map<Side> &elob::book::limits() {
+	if constexpr (Side == elob::side::bid) {
+		return m_bids;
+	} else {
+		return m_asks;
+	}
+}
+
+template <elob::side Side>
+const elob::book::limit_map<Side> &elob::book::limits() const {
+	if constexpr (Side == elob::side::bid) {
+		return m_bids;
+	} else {
+		return m_asks;
+	}
+}
+
+template <elob::side Side> elob::book::peg_maps<Side> &elob::book::pegs() {
+	if constexpr (Side == elob::side::bid) {
+		return m_bid_pegs;
+	} else {
+		return m_ask_pegs;
+	}
+}
+
+template <elob::side Side>
+const elob::book::peg_maps<Side> &elob::book::pegs() const {
+	if constexpr (Side == elob::side::bid) {
+		return m_bid_pegs;
+	} else {
+		return m_ask_pegs;
+	}
+}
+
+template <elob::side Side>
+elob::book::trigger_map<Side> &elob::book::triggers() {
+	if constexpr (Side == elob::side::bid) {
+		return m_bid_triggers;
+	} else {
+		return m_ask_triggers;
+	}
+}
+
+template <class Limits>
+typename Limits::iterator elob::book::emplace_level(
+    Limits &t_limits, const double t_price) {
+	auto limit_it = t_limits.lower_bound(t_price);
+
+	if (limit_it != t_limits.end() &&
+	    !t_limits.key_comp()(t_price, limit_it->first)) {
+		return limit_it;
+	}
+
+	constexpr bool orders = std::is_same<typename Limits::mapped_type,
+	    elob::order_limit>::value;
+	auto &spare_levels = [this]() -> auto & {
+		if constexpr (orders) {
+			return m_spare_levels;
+		} else {
+			return m_spare_trigger_levels;
+		}
+	}();
+
+	if (spare_levels.empty()) {
+		limit_it = t_limits.try_emplace(limit_it, t_price);
+	} else {
+		auto node = std::move(spare_levels.back());
+		spare_levels.pop_back();
+		node.key() = t_price;
+		limit_it = t_limits.insert(limit_it, std::move(node));
+	}
+
+	if constexpr (orders) {
+		limit_it->second.m_handle = m_levels.acquire(limit_it);
+	} else {
+		limit_it->second.m_handle = m_trigger_levels.acquire(limit_it);
+	}
+
+	return limit_it;
+}
+
+template <class Limits>
+typename Limits::iterator elob::book::erase_level(
+    Limits &t_limits, const typename Limits::iterator t_limit_it) {
+	if constexpr (std::is_same<typename Limits::mapped_type,
+			  elob::order_limit>::value) {
+		m_levels.release(t_limit_it->second.m_handle);
+
+		if (m_spare_levels.size() < spare_level_count) {
+			const auto next_it = std::next(t_limit_it);
+			m_spare_levels.push_back(t_limits.extract(t_limit_it));
+			m_spare_levels.back().mapped().recycle(this);
+			return next_it;
+		}
+	} else {
+		m_trigger_levels.release(t_limit_it->second.m_handle);
+
+		if (m_spare_trigger_levels.size() < spare_level_count &&
+		    t_limit_it->second.is_empty()) {
+			const auto next_it = std::next(t_limit_it);
+			m_spare_trigger_levels.push_back(
+			    t_limits.extract(t_limit_it));
+			m_spare_trigger_levels.back().mapped().recycle();
+			return next_it;
+		}
+	}
+
+	return t_limits.erase(t_limit_it);
+}
+
+void elob::book::begin_order_deferral() {
+	// an outer operation starts a new cascade
+	if (m_order_deferral_depth++ == 0 && !m_draining_deferred) {
+		m_cascade = cascade_stats();
+	}
+}
+
+void elob::book::end_order_deferral() {
+	// deferred orders inserted below drain through the outer loop
+	if (--m_order_deferral_depth != 0 || m_draining_deferred) {
+		return;
+	}
+
+	m_draining_deferred = true;
+
+	while (!m_deferred.empty() || !m_fired_groups.empty()) {
+		resolve_groups();
+
+		if (m_deferred.empty()) {
+			break;
+		}
+
+		// the orders and triggers released by this wave are queued
+		// behind it and form the next one
+		const std::size_t wave_size = m_deferred.size();
+		++m_cascade.wave_count;
+		m_cascade.max_wave_size =
+		    std::max(m_cascade.max_wave_size, wave_size);
+
+		for (std::size_t i = 0; i < wave_size; ++i) {
+			const insertable deferred =
+			    std::move(m_deferred.front());
+			m_deferred.pop();
+
+			if (deferred.is_order()) {
+				++m_cascade.order_count;
+				insert(*deferred.get_order());
+				continue;
+			}
+
+			c_trigger_ptr &trigger_obj = *deferred.get_trigger();
+
+			// it may have been inserted again in the meantime
+			if (!trigger_obj->m_queued &&
+			    trigger_obj->m_book == this) {
+				fire(trigger_obj);
+			}
+		}
+	}
+
+	m_draining_deferred = false;
+	publish();
+}
+
+void elob::book::fire(elob::c_trigger_ptr &t_trigger) {
+	begin_order_deferral();
+	++m_cascade.trigger_count;
+
+	if (t_trigger->m_group != 0) {
+		fire_group(t_trigger->m_group);
+	}
+
+	t_trigger->on_triggered();
+
+	if (!t_trigger->m_queued) { // on_triggered may reinsert the trigger
+		t_trigger->m_book = nullptr;
+	}
+
+	end_order_deferral();
+}
+
+void elob::book::publish() {
+	if (m_auction && m_indicative_changed && m_batch_interval == 0) {
+		compute_clearing_price(m_indicative_price, m_indicative_volume);
+		m_indicative_changed = false;
+
+		if (m_listener) {
+			m_listener->on_indicative(
+			    m_indicative_price, m_indicative_volume);
+		}
+	}
+
+	if (m_listener) {
+		notify_listener();
+	}
+
+	if (!m_snapshot) {
+		return;
+	}
+
+	elob::snapshot_data data;
+	data.sequence = m_snapshot->get_sequence();
+	data.market_price = m_market_price;
+	data.last_trade_quantity = m_last_trade_quantity;
+
+	for (auto it = m_bids.begin();
+	     it != m_bids.end() && data.bid_count < snapshot_depth; ++it) {
+		auto &level = data.bids[data.bid_count++];
+		level.price = it->first;
+		level.quantity = it->second.m_quantity;
+		level.aon_quantity = it->second.m_aon_quantity;
+		level.order_count = it->second.order_count();
+	}
+
+	for (auto it = m_asks.begin();
+	     it != m_asks.end() && data.ask_count < snapshot_depth; ++it) {
+		auto &level = data.asks[data.ask_count++];
+		level.price = it->first;
+		level.quantity = it->second.m_quantity;
+		level.aon_quantity = it->second.m_aon_quantity;
+		level.order_count = it->second.order_count();
+	}
+
+	m_snapshot->write(data);
+}
+
+void elob::book::touch(const elob::side t_side, const double t_price) {
+	// levels that do not cross the opposite side cannot change the
+	// indicative price
+	const bool crossing = t_side == elob::side::bid
+				  ? t_price >= get_ask_price()
+				  : t_price <= get_bid_price();
+
+	if (m_auction && crossing) {
+		m_indicative_changed = true;
+	}
+
+	if (m_listener) {
+		m_touched.emplace_back(t_side, t_price);
+	}
+}
+
+void elob::book::notify_listener() {
+	std::sort(m_touched.begin(), m_touched.end());
+	const auto touched_end = std::unique(m_touched.begin(), m_touched.end());
+
+	for (auto it = m_touched.begin(); it != touched_end; ++it) {
+		const elob::order_limit *limit_obj = nullptr;
+
+		if (it->first == elob::side::bid) {
+			const auto limit_it = m_bids.find(it->second);
+			if (limit_it != m_bids.end()) {
+				limit_obj = &limit_it->second;
+			}
+		} else {
+			const auto limit_it = m_asks.find(it->second);
+			if (limit_it != m_asks.end()) {
+				limit_obj = &limit_it->second;
+			}
+		}
+
+		if (limit_obj) {
+			m_listener->on_level(it->first, it->second,
+			    limit_obj->m_quantity, limit_obj->m_aon_quantity,
+			    limit_obj->order_count());
+		} else {
+			m_listener->on_level(it->first, it->second, 0.0, 0.0, 0);
+		}
+	}
+
+	m_touched.clear();
+	m_listener->on_published(m_market_price);
+}
+
+void elob::book::insert(elob::c_trigger_ptr &t_trigger) {
+	if (t_trigger->m_side == elob::side::bid) {
+		insert<elob::side::bid>(t_trigger);
+	} else {
+		insert<elob::side::ask>(t_trigger);
+	}
+}
+
+template <elob::side Side>
+void elob::book::insert(elob::c_trigger_ptr &t_trigger) {
+	// check if order is valid
+	if (t_trigger->m_queued || t_trigger->m_side != Side) {
+		return;
+	}
+
+	if (t_trigger->m_expiry != 0 && t_trigger->m_expiry <= m_time) {
+		t_trigger->on_rejected();
+		return;
+	}
+
+	// order is valid
+	t_trigger->m_book = this;
+	t_trigger->on_accepted();
+	const typename side_traits<Side>::compare compare;
+
+	// the same condition as in fire_triggers
+	if (m_market_price >= 0.0 &&
+	    !compare(m_market_price, t_trigger->m_price)) {
+		if (m_order_deferral_depth > 0) {
+			m_deferred.push(t_trigger);
+		} else {
+			fire(t_trigger);
+		}
+	} else {
+		queue_trigger<Side>(t_trigger);
+		schedule_expiry(t_trigger);
+	}
+}
+
+void elob::book::insert(const insertable &ins) {
+
+	if (ins.is_order()) {
+		insert(*(ins.get_order()));
+	} else {
+		insert(*(ins.get_trigger()));
+	}
+}
+
+void elob::book::insert_oco(const std::vector<elob::insertable> &t_legs) {
+	const std::uint32_t group = acquire_group();
+	m_groups[group - 1].m_legs = t_legs;
+
+	for (const auto &leg : t_legs) {
+		group_of(leg) = group;
+	}
+
+	insert_legs(group);
+}
+
+void elob::book::insert_bracket(
+    elob::c_order_ptr &t_entry, const std::vector<elob::insertable> &t_exits) {
+	if (t_exits.empty()) {
+		insert(t_entry);
+		return;
+	}
+
+	const std::uint32_t group = acquire_group();
+	m_groups[group - 1].m_legs.emplace_back(t_entry);
+	m_groups[group - 1].m_exits = t_exits;
+	t_entry->m_group = group;
+	insert_legs(group);
+}
+
+std::uint32_t &elob::book::group_of(const elob::insertable &t_leg) {
+	if (t_leg.is_order()) {
+		return (*t_leg.get_order())->m_group;
+	}
+
+	return (*t_leg.get_trigger())->m_group;
+}
+
+std::uint32_t elob::book::acquire_group() {
+	if (m_free_groups.empty()) {
+		m_groups.emplace_back();
+		return static_cast<std::uint32_t>(m_groups.size());
+	}
+
+	const std::uint32_t group = m_free_groups.back();
+	m_free_groups.pop_back();
+	return group;
+}
+
+void elob::book::release_group(const std::uint32_t t_group) {
+	auto &group = m_groups[t_group - 1];
+
+	for (const auto &leg : group.m_legs) {
+		if (group_of(leg) == t_group) {
+			group_of(leg) = 0;
+		}
+	}
+
+	group.m_legs.clear();
+	group.m_exits.clear();
+	group.m_fired = false;
+	m_free_groups.push_back(t_group);
+}
+
+void elob::book::fire_group(std::uint32_t &t_group) {
+	// the leg keeps trading without its group
+	const std::uint32_t handle = t_group;
+	auto &group = m_groups[handle - 1];
+	t_group = 0;
+
+	if (group.m_fired) {
+		return;
+	}
+
+	group.m_fired = true;
+	m_fired_groups.push_back(handle);
+
+	for (const auto &leg : group.m_legs) {
+		if (group_of(leg) != handle) {
+			continue;
+		}
+
+		// the other orders no longer count towards their levels
+		if (leg.is_order()) {
+			order &order_obj = **leg.get_order();
+
+			if (order_obj.m_queued && order_obj.m_book == this &&
+			    !order_obj.m_withdrawn) {
+				auto &limit_obj =
+				    m_levels[order_obj.m_level]->second;
+				limit_obj.unshare(this);
+				limit_obj.withdraw(&order_obj);
+
+				if (!order_obj.is_pegged()) {
+					touch(order_obj.m_side,
+					    order_obj.m_price);
+				}
+			}
+
+			continue;
+		}
+
+		// trigger levels can be modified while orders are matched
+		const trigger_ptr trigger_obj = *leg.get_trigger();
+		trigger_obj->m_group = 0;
+
+		// a trigger waiting to fire is dropped by the drain loop
+		if (!trigger_obj->cancel() && trigger_obj->m_book == this) {
+			trigger_obj->m_book = nullptr;
+			trigger_obj->on_canceled();
+		}
+	}
+}
+
+bool elob::book::is_group_fired(const std::uint32_t t_group) const {
+	return m_groups[t_group - 1].m_fired;
+}
+
+void elob::book::resolve_groups() {
+	// inserting exits and canceling legs may fire further groups
+	for (std::size_t i = 0; i < m_fired_groups.size(); ++i) {
+		const std::uint32_t handle = m_fired_groups[i];
+		auto &group = m_groups[handle - 1];
+
+		if (!group.m_exits.empty()) {
+			group.m_legs = std::move(group.m_exits);
+			group.m_exits.clear();
+			group.m_fired = false;
+
+			for (const auto &leg : group.m_legs) {
+				group_of(leg) = handle;
+			}
+
+			insert_legs(handle);
+			continue;
+		}
+
+		// the legs still in the group have neither traded nor
+		// fired
+		std::vector<order_ptr> siblings;
+
+		for (const auto &leg : group.m_legs) {
+			if (leg.is_order() && group_of(leg) == handle) {
+				siblings.push_back(*leg.get_order());
+			}
+		}
+
+		release_group(handle);
+
+		for (const auto &order_obj : siblings) {
+			order_obj->cancel();
+		}
+	}
+
+	m_fired_groups.clear();
+}
 
-	if (t_order->m_quantity <= 0.0) {
-		t_order->on_rejected();
+void elob::book::leave_group(const std::uint32_t t_group) {
+	auto &group = m_groups[t_group - 1];
+
+	if (group.m_fired) {
 		return;
 	}
 
-	if (t_order->m_queued) {
-		t_order->on_rejected();
-		return;
+	for (const auto &leg : group.m_legs) {
+		if (group_of(leg) != t_group) {
+			continue;
+		}
+
+		if (leg.is_order() ? (*leg.get_order())->m_queued
+				   : (*leg.get_trigger())->m_queued) {
+			return;
+		}
 	}
 
-	// order is valid
-	t_order->m_book = this;
-	t_order->on_accepted();
+	release_group(t_group);
+}
 
-	if (t_order->m_side == elob::side::bid) {
-		if (t_order->m_all_or_nothing) {
-			insert_aon_bid(t_order);
-		} else {
-			insert_bid(t_order);
+void elob::book::insert_legs(const std::uint32_t t_group) {
+	// inserting a leg may resolve the group
+	const auto legs = m_groups[t_group - 1].m_legs;
+	bool grouped = false;
+
+	for (const auto &leg : legs) {
+		if (group_of(leg) != t_group || is_group_fired(t_group)) {
+			break;
 		}
-	} else {
-		if (t_order->m_all_or_nothing) {
-			insert_aon_ask(t_order);
+
+		insert(leg);
+	}
+
+	for (const auto &leg : legs) {
+		grouped = grouped || group_of(leg) == t_group;
+	}
+
+	// drop the group if none of its legs was queued
+	if (grouped && m_order_deferral_depth == 0) {
+		leave_group(t_group);
+	}
+}
+
+std::size_t elob::book::mass_cancel(const std::uint64_t t_owner) {
+	return cancel_owned(t_owner, [](const order &) { return true; });
+}
+
+std::size_t elob::book::mass_cancel(const std::uint64_t t_owner,
+    const elob::side t_side, const double t_min_price,
+    const double t_max_price) {
+	return cancel_owned(t_owner, [=](const order &t_order) {
+		if (t_order.m_side != t_side) {
+			return false;
+		}
+
+		const double price = t_order.get_price();
+		return price >= t_min_price && price <= t_max_price;
+	});
+}
+
+std::size_t elob::book::mass_quote(
+    const std::uint64_t t_owner, const std::vector<order_ptr> &t_quotes) {
+	// the quotes are inserted once the old ones have been canceled.
+	// They are not part of the cascade of the operation.
+	begin_order_deferral();
+	const std::size_t canceled =
+	    cancel_owned(t_owner, [](const order &) { return true; });
+
+	for (const auto &quote : t_quotes) {
+		if (!quote->m_queued) {
+			quote->m_owner = t_owner;
+		}
+
+		if (quote->m_side == elob::side::bid) {
+			insert_now<elob::side::bid>(quote);
 		} else {
-			insert_ask(t_order);
+			insert_now<elob::side::ask>(quote);
 		}
 	}
 
 	end_order_deferral();
+	return canceled;
+}
+
+void elob::book::set_risk_limits(
+    const std::uint64_t t_owner, const elob::risk_limits &t_limits) {
+	m_participants[t_owner].m_limits = t_limits;
 }
 
-void elob::book::begin_order_deferral() { ++m_order_deferral_depth; }
+elob::participant_risk elob::book::get_participant_risk(
+    const std::uint64_t t_owner) const {
+	const auto participant_it = m_participants.find(t_owner);
 
-void elob::book::end_order_deferral() {
-	if (--m_order_deferral_depth != 0) {
-		return;
+	if (participant_it == m_participants.end()) {
+		return participant_risk();
+	}
+
+	return participant_it->second.m_risk;
+}
+
+elob::participant &elob::book::link(elob::order &t_order) {
+	participant &owner = m_participants[t_order.m_owner];
+	t_order.m_prev_owned = nullptr;
+	t_order.m_next_owned = owner.m_first;
+
+	if (owner.m_first) {
+		owner.m_first->m_prev_owned = &t_order;
 	}
 
-	while (!m_deferred.empty()) {
-		auto order_obj = m_deferred.front();
-		m_deferred.pop();
-		insert(order_obj);
+	owner.m_first = &t_order;
+	return owner;
+}
+
+void elob::book::index(elob::order &t_order) {
+	participant_risk &risk = link(t_order).m_risk;
+	const double quantity =
+	    t_order.m_quantity + t_order.m_hidden_quantity;
+	++risk.order_count;
+
+	if (t_order.m_side == side::bid) {
+		risk.open_bid_quantity += quantity;
+	} else {
+		risk.open_ask_quantity += quantity;
 	}
 }
 
-void elob::book::insert(elob::c_trigger_ptr t_trigger) {
-	// check if order is valid
-	if (t_trigger->m_queued) {
+void elob::book::unindex(elob::order &t_order) {
+	participant &owner = m_participants[t_order.m_owner];
+	const double quantity =
+	    t_order.m_quantity + t_order.m_hidden_quantity;
+	--owner.m_risk.order_count;
+
+	if (t_order.m_side == side::bid) {
+		owner.m_risk.open_bid_quantity -= quantity;
+	} else {
+		owner.m_risk.open_ask_quantity -= quantity;
+	}
+
+	if (t_order.m_next_owned) {
+		t_order.m_next_owned->m_prev_owned = t_order.m_prev_owned;
+	}
+
+	if (t_order.m_prev_owned) {
+		t_order.m_prev_owned->m_next_owned = t_order.m_next_owned;
+	} else {
+		owner.m_first = t_order.m_next_owned;
+	}
+
+	t_order.m_prev_owned = nullptr;
+	t_order.m_next_owned = nullptr;
+}
+
+void elob::book::resize_owned(
+    const elob::order &t_order, const double t_change) {
+	participant_risk &risk = m_participants[t_order.m_owner].m_risk;
+
+	if (t_order.m_side == side::bid) {
+		risk.open_bid_quantity += t_change;
+	} else {
+		risk.open_ask_quantity += t_change;
+	}
+}
+
+void elob::book::fill_owned(const elob::order &t_order,
+    const double t_quantity, const double t_price) {
+	participant_risk &risk = m_participants[t_order.m_owner].m_risk;
+	risk.notional += t_price * t_quantity;
+
+	if (t_order.m_side == side::bid) {
+		risk.position += t_quantity;
+		risk.open_bid_quantity -= t_order.m_queued ? t_quantity : 0.0;
+	} else {
+		risk.position -= t_quantity;
+		risk.open_ask_quantity -= t_order.m_queued ? t_quantity : 0.0;
+	}
+}
+
+template <elob::side Side>
+bool elob::book::is_within_limits(const std::uint64_t t_owner,
+    const elob::order &t_order, const double t_price,
+    const double t_quantity, const bool t_open) {
+	const participant &owner = m_participants[t_owner];
+	const risk_limits &limits = owner.m_limits;
+	const participant_risk &risk = owner.m_risk;
+
+	// the part of the order that is not open yet
+	const double quantity =
+	    t_open ? t_quantity - t_order.m_quantity -
+			 t_order.m_hidden_quantity
+		   : t_quantity;
+
+	// the worst case is that every open order of the side fills
+	const double position =
+	    Side == side::bid
+		? risk.position + risk.open_bid_quantity + quantity
+		: risk.open_ask_quantity + quantity - risk.position;
+	const double open_quantity =
+	    Side == side::bid ? risk.open_bid_quantity
+			      : risk.open_ask_quantity;
+
+	if (t_quantity > limits.max_order_quantity ||
+	    (!t_open && risk.order_count >= limits.max_order_count) ||
+	    open_quantity + quantity > limits.max_open_quantity ||
+	    position > limits.max_position) {
+		return false;
+	}
+
+	if (limits.max_notional >= max_price) {
+		return true;
+	}
+
+	// bids trade at most at their price, asks at least at theirs
+	double price = t_price;
+
+	if (t_order.is_pegged()) {
+		price = get_peg_price(Side, t_order.m_peg, t_order.m_offset);
+	}
+
+	if (Side == side::bid && price >= max_price) {
+		price = get_ask_price();
+	} else if (Side == side::ask) {
+		price = std::max(price, get_bid_price());
+	}
+
+	return price >= max_price ||
+	       risk.notional + std::max(price, 0.0) * t_quantity <=
+		   limits.max_notional;
+}
+
+void elob::book::index_participants() {
+	if (m_participants_indexed) {
 		return;
 	}
 
-	// order is valid
-	t_trigger->m_book = this;
-	t_trigger->on_accepted();
+	// the copies of the shared orders are indexed as they are taken
+	const auto unshare = [this](auto &t_limits) {
+		for (auto &limit : t_limits) {
+			limit.second.unshare(this);
+		}
+	};
 
-	if (t_trigger->m_side == elob::side::bid) {
-		if (t_trigger->m_price >= m_market_price &&
-		    m_market_price >= 0.0) { // prevent execution at start
-			t_trigger->on_triggered();
-			t_trigger->m_book = nullptr;
+	unshare(m_bids);
+	unshare(m_asks);
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		unshare(m_bid_pegs[i]);
+		unshare(m_ask_pegs[i]);
+	}
+
+	m_participants_indexed = true;
+}
+
+template <class Predicate>
+std::size_t elob::book::cancel_owned(
+    const std::uint64_t t_owner, Predicate t_predicate) {
+	index_participants();
+	const auto participant_it = m_participants.find(t_owner);
+
+	if (participant_it == m_participants.end()) {
+		return 0;
+	}
+
+	std::vector<order *> orders;
+
+	for (order *order_obj = participant_it->second.m_first; order_obj;
+	     order_obj = order_obj->m_next_owned) {
+		if (t_predicate(*order_obj)) {
+			orders.push_back(order_obj);
+		}
+	}
+
+	// the orders of a level are removed one after another
+	std::sort(orders.begin(), orders.end(),
+	    [](const order *t_lhs, const order *t_rhs) {
+		    return t_lhs->m_level < t_rhs->m_level;
+	    });
+
+	begin_order_deferral();
+	std::vector<order_ptr> canceled;
+	canceled.reserve(orders.size());
+
+	for (std::size_t i = 0; i < orders.size(); ++i) {
+		order &order_obj = *orders[i];
+
+		// pegged orders keep the price at which they were canceled
+		if (order_obj.is_pegged()) {
+			order_obj.m_price = order_obj.get_price();
 		} else {
-			queue_bid_trigger(t_trigger);
+			touch(order_obj.m_side, order_obj.m_price);
 		}
-	} else {
-		if (t_trigger->m_price <= m_market_price) {
-			t_trigger->on_triggered();
-			t_trigger->m_book = nullptr;
+
+		auto &limit_obj = m_levels[order_obj.m_level]->second;
+		limit_obj.unshare(this);
+		canceled.push_back(
+		    limit_obj.erase(order_obj.m_order_slot, m_lazy_cancel));
+
+		if (i + 1 < orders.size() &&
+		    orders[i + 1]->m_level == order_obj.m_level) {
+			continue;
+		}
+
+		if (order_obj.m_side == side::bid) {
+			erase_if_empty<side::bid>(order_obj);
 		} else {
-			queue_ask_trigger(t_trigger);
+			erase_if_empty<side::ask>(order_obj);
 		}
 	}
-}
 
-void elob::book::insert(const insertable &ins) {
+	// every order is dequeued before the event methods are called
+	for (const auto &order_obj : canceled) {
+		if (order_obj->m_group != 0) {
+			leave_group(order_obj->m_group);
+		}
 
-	if (ins.is_order()) {
-		insert(*(ins.get_order()));
-	} else {
-		insert(*(ins.get_trigger()));
+		order_obj->on_canceled();
+		order_obj->m_book = nullptr;
 	}
+
+	end_order_deferral();
+	return canceled.size();
 }
 
-void elob::book::queue_bid_trigger(elob::c_trigger_ptr &t_trigger) {
+template <elob::side Side>
+void elob::book::queue_trigger(elob::c_trigger_ptr &t_trigger) {
 	const auto limit_it =
-	    m_bid_triggers.emplace(t_trigger->m_price, elob::trigger_limit())
-		.first;
-	const auto trigger_it = limit_it->second.insert(t_trigger);
-	t_trigger->m_limit_it = limit_it;
-	t_trigger->m_trigger_it = trigger_it;
+	    emplace_level(triggers<Side>(), t_trigger->m_price);
+	limit_it->second.insert(t_trigger);
+	t_trigger->m_level = limit_it->second.m_handle;
 	t_trigger->m_queued = true;
+	cache_trigger_price<Side>();
 	t_trigger->on_queued();
 }
 
-void elob::book::queue_ask_trigger(elob::c_trigger_ptr &t_trigger) {
-	const auto limit_it =
-	    m_ask_triggers.emplace(t_trigger->m_price, elob::trigger_limit())
-		.first;
-	const auto trigger_it = limit_it->second.insert(t_trigger);
-	t_trigger->m_limit_it = limit_it;
-	t_trigger->m_trigger_it = trigger_it;
-	t_trigger->m_queued = true;
-	t_trigger->on_queued();
-}
+template <elob::side Side>
+void elob::book::queue_order(elob::c_order_ptr &t_order) {
+	const auto limit_it = emplace_level(limits<Side>(), t_order->m_price);
+	limit_it->second.unshare(this);
+	t_order->m_order_slot = limit_it->second.insert(t_order);
+	t_order->m_level = limit_it->second.m_handle;
+	t_order->m_queued = true;
+
+	if (t_order->m_owner != 0) {
+		index(*t_order);
+	}
+
+	touch(Side, t_order->m_price);
+	check_aons<side_traits<Side>::opposite>(t_order->m_price);
+	t_order->on_queued();
+}
+
+template <elob::side Side>
+void elob::book::queue_peg_order(elob::c_order_ptr &t_order) {
+	auto &limits = pegs<Side>()[t_order->m_peg - 1];
+	const auto limit_it = emplace_level(limits, t_order->m_offset);
+	limit_it->second.unshare(this);
+	t_order->m_order_slot = limit_it->second.insert(t_order);
+	t_order->m_level = limit_it->second.m_handle;
+	t_order->m_queued = true;
+
+	if (t_order->m_owner != 0) {
+		index(*t_order);
+	}
+
+	double reference = 0.0;
+
+	if (get_peg_reference(Side, t_order->m_peg, reference)) {
+		check_aons<side_traits<Side>::opposite>(
+		    reference + t_order->m_offset);
+	}
+
+	t_order->on_queued();
+}
+
+bool elob::book::get_peg_reference(const elob::side t_side,
+    const elob::peg_type t_peg, double &t_reference) const {
+	const bool has_bid = !m_bids.empty();
+	const bool has_ask = !m_asks.empty();
+
+	// the reference prices are taken from ordinary price levels only
+	switch (t_peg) {
+	case elob::primary_peg:
+		if (t_side == elob::side::bid ? !has_bid : !has_ask) {
+			return false;
+		}
+
+		t_reference = t_side == elob::side::bid ? m_bids.begin()->first
+							: m_asks.begin()->first;
+		return true;
+	case elob::market_peg:
+		if (t_side == elob::side::bid ? !has_ask : !has_bid) {
+			return false;
+		}
+
+		t_reference = t_side == elob::side::bid ? m_asks.begin()->first
+							: m_bids.begin()->first;
+		return true;
+	case elob::mid_peg:
+		if (!has_bid || !has_ask) {
+			return false;
+		}
+
+		t_reference =
+		    (m_bids.begin()->first + m_asks.begin()->first) / 2.0;
+		return true;
+	default:
+		return false;
+	}
+}
+
+void elob::book::get_peg_references(const elob::side t_side,
+    double (&t_references)[peg_type_count],
+    bool (&t_available)[peg_type_count]) const {
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		t_references[i] = 0.0;
+		t_available[i] = get_peg_reference(t_side,
+		    static_cast<elob::peg_type>(i + 1), t_references[i]);
+	}
+}
+
+template <class Limits, class Function>
+void elob::book::for_each_level(Limits &t_limits,
+    Limits (&t_pegs)[peg_type_count],
+    const double (&t_references)[peg_type_count],
+    const bool (&t_available)[peg_type_count], const double t_bound,
+    Function t_function, elob::book *t_book) {
+	const auto key_comp = t_limits.key_comp();
+
+	// the next level of the ordinary levels (0) and of every peg type
+	decltype(t_limits.begin()) limit_its[peg_type_count + 1];
+	Limits *limits[peg_type_count + 1] = {&t_limits};
+	limit_its[0] = t_limits.begin();
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		limits[i + 1] = &t_pegs[i];
+		limit_its[i + 1] =
+		    t_available[i] ? t_pegs[i].begin() : t_pegs[i].end();
+	}
+
+	while (true) {
+		std::size_t best = peg_type_count + 1;
+		double best_price = 0.0;
+		double keys[peg_type_count + 1];
+
+		for (std::size_t i = 0; i <= peg_type_count; ++i) {
+			if (limit_its[i] == limits[i]->end()) {
+				continue;
+			}
+
+			keys[i] = limit_its[i]->first;
+			const double price =
+			    i == 0 ? keys[i] : t_references[i - 1] + keys[i];
+
+			// ties are resolved in favor of ordinary levels
+			if (best > peg_type_count ||
+			    key_comp(price, best_price)) {
+				best = i;
+				best_price = price;
+			}
+		}
+
+		if (best > peg_type_count || key_comp(t_bound, best_price)) {
+			return;
+		}
+
+		const bool proceed =
+		    t_function(best_price, limit_its[best], best != 0);
+
+		if constexpr (!std::is_const<Limits>::value) {
+			if (limit_its[best]->second.is_empty()) {
+				limit_its[best] = t_book->erase_level(
+				    *limits[best], limit_its[best]);
+			} else {
+				++limit_its[best];
+			}
+
+			// event methods may have erased the other next levels
+			for (std::size_t i = 0; i <= peg_type_count; ++i) {
+				if (i != best &&
+				    limit_its[i] != limits[i]->end()) {
+					limit_its[i] =
+					    limits[i]->lower_bound(keys[i]);
+				}
+			}
+		} else {
+			++limit_its[best];
+		}
+
+		if (!proceed) {
+			return;
+		}
+	}
+}
+
+template <class T>
+void elob::book::schedule_expiry(const std::shared_ptr<T> &t_object) {
+	if (t_object->m_expiry == 0) {
+		return;
+	}
+
+	if (t_object->m_expiry <= m_time) {
+		expire(t_object);
+		return;
+	}
+
+	// a pending timer that fires no later than the expiry is reused
+	if (t_object->m_timer_book == this && t_object->m_timer != 0 &&
+	    t_object->m_timer <= t_object->m_expiry) {
+		return;
+	}
+
+	if (!m_timers) {
+		m_timers =
+		    std::make_unique<elob::timer_wheel<expiry_timer>>(m_time);
+	}
+
+	m_timers->schedule(t_object->m_expiry, expiry_timer(t_object));
+	t_object->m_timer = t_object->m_expiry;
+	t_object->m_timer_book = this;
+}
+
+template <class T>
+void elob::book::on_timer(
+    const std::shared_ptr<T> &t_object, const std::uint64_t t_timer) {
+	if (t_object->m_timer_book == this && t_object->m_timer == t_timer) {
+		t_object->m_timer = 0;
+	}
+
+	// the expiry may have been changed since the timer was scheduled
+	if (t_object->m_queued && t_object->m_book == this) {
+		schedule_expiry(t_object);
+	}
+}
+
+void elob::book::expire(elob::c_order_ptr &t_order) {
+	const order_ptr self = t_order->dequeue();
+	t_order->on_canceled();
+	t_order->m_book = nullptr;
+}
+
+void elob::book::expire(elob::c_trigger_ptr &t_trigger) {
+	t_trigger->cancel();
+}
+
+template <class Limits>
+void elob::book::expire_levels(Limits &t_limits, const elob::side t_side,
+    const bool t_pegged, std::vector<elob::order_ptr> &t_expired) {
+	const auto expires = [](const elob::order *t_order) {
+		return t_order->m_expiry != 0;
+	};
+
+	auto limit_it = t_limits.begin();
+
+	while (limit_it != t_limits.end()) {
+		auto &limit_obj = limit_it->second;
+
+		// levels shared with forks are only copied if they change
+		if (std::none_of(limit_obj.orders().begin(),
+			limit_obj.orders().end(), expires)) {
+			++limit_it;
+			continue;
+		}
+
+		limit_obj.unshare(this);
+
+		if (!t_pegged) {
+			touch(t_side, limit_it->first);
+		}
+
+		auto &orders = limit_obj.orders();
+
+		if (std::all_of(orders.begin(), orders.end(), expires)) {
+			// free the whole level at once
+			for (const auto order_obj : orders) {
+				if (t_pegged) {
+					order_obj->m_price =
+					    order_obj->get_price();
+				}
+
+				if (order_obj->m_owner != 0) {
+					unindex(*order_obj);
+				}
+
+				order_obj->m_queued = false;
+				t_expired.push_back(
+				    std::move(order_obj->m_self));
+			}
+
+			limit_it = erase_level(t_limits, limit_it);
+			continue;
+		}
+
+		auto order_it = orders.begin();
+
+		while (order_it != orders.end()) {
+			elob::order *const order_obj = *(order_it++);
+
+			if (!expires(order_obj)) {
+				continue;
+			}
+
+			if (t_pegged) {
+				order_obj->m_price = order_obj->get_price();
+			}
+
+			t_expired.push_back(
+			    limit_obj.erase(order_obj->m_order_slot));
+		}
+
+		++limit_it;
+	}
+}
+
+template <elob::side Side>
+void elob::book::erase_if_empty(const elob::order &t_order) {
+	const auto limit_it = m_levels[t_order.m_level];
+
+	if (!limit_it->second.is_empty()) {
+		return;
+	}
+
+	if (t_order.is_pegged()) {
+		erase_level(pegs<Side>()[t_order.m_peg - 1], limit_it);
+	} else {
+		erase_level(limits<Side>(), limit_it);
+	}
+}
+
+template <elob::side Side>
+void elob::book::erase_if_empty(const elob::trigger &t_trigger) {
+	const auto limit_it = m_trigger_levels[t_trigger.m_level];
+
+	// a firing level is erased once it has fired
+	if (limit_it->second.is_empty() && !limit_it->second.m_firing) {
+		erase_level(triggers<Side>(), limit_it);
+		cache_trigger_price<Side>();
+	}
+}
+
+template <elob::side Side>
+elob::order_ptr elob::book::dequeue(elob::order &t_order) {
+	// pegged orders keep the price at which they were canceled
+	if (t_order.is_pegged()) {
+		t_order.m_price = t_order.get_price();
+	} else {
+		touch(Side, t_order.m_price);
+	}
+
+	auto &limit_obj = m_levels[t_order.m_level]->second;
+	limit_obj.unshare(this);
+	order_ptr self = limit_obj.erase(t_order.m_order_slot, m_lazy_cancel);
+	erase_if_empty<Side>(t_order);
+
+	if (t_order.m_group != 0) {
+		leave_group(t_order.m_group);
+	}
+
+	return self;
+}
+
+template <elob::side Side>
+bool elob::book::set_quantity(
+    elob::c_order_ptr &t_order, const double t_quantity) {
+	// an increase must stay within the limits of the owner
+	if (t_order->m_owner != 0 && t_quantity > t_order->m_quantity &&
+	    !is_within_limits<Side>(t_order->m_owner, *t_order,
+		t_order->m_price,
+		t_quantity + t_order->m_hidden_quantity, true)) {
+		return false;
+	}
+
+	auto &limit_obj = m_levels[t_order->m_level]->second;
+	begin_order_deferral();
+	limit_obj.unshare(this);
+
+	if (!t_order->is_pegged()) {
+		touch(Side, t_order->m_price);
+	}
+
+	// the quantity of withdrawn orders does not count towards the level
+	const double level_change =
+	    t_order->m_withdrawn ? 0.0 : t_quantity - t_order->m_quantity;
+
+	if (t_order->m_all_or_nothing) {
+		limit_obj.m_aon_quantity += level_change;
+	} else {
+		limit_obj.m_quantity += level_change;
+	}
 
-void elob::book::queue_bid_order(elob::c_order_ptr &t_order) {
-	const auto limit_it =
-	    m_bids.emplace(t_order->m_price, elob::order_limit()).first;
-	const auto order_it = limit_it->second.insert(t_order);
-	t_order->m_limit_it = limit_it;
-	t_order->m_order_it = order_it;
-	t_order->m_queued = true;
-	check_ask_aons(t_order->m_price);
-	t_order->on_queued();
-}
+	if (t_order->m_owner != 0) {
+		resize_owned(*t_order, t_quantity - t_order->m_quantity);
+	}
 
-void elob::book::queue_ask_order(elob::c_order_ptr &t_order) {
-	const auto limit_it =
-	    m_asks.emplace(t_order->m_price, elob::order_limit()).first;
-	const auto order_it = limit_it->second.insert(t_order);
-	t_order->m_limit_it = limit_it;
-	t_order->m_order_it = order_it;
-	t_order->m_queued = true;
-	check_bid_aons(t_order->m_price);
-	t_order->on_queued();
-}
+	t_order->m_quantity = t_quantity;
+	limit_obj.update(t_order.get());
+
+	// all-or-nothing orders only execute if they can be filled
+	// completely, pegged orders never cross the book, during an
+	// auction orders only execute when it is uncrossed and withdrawn
+	// orders are about to be canceled
+	bool executable = !t_order->m_all_or_nothing &&
+			  !t_order->is_pegged() && !m_auction &&
+			  !t_order->m_withdrawn;
 
-void elob::book::insert_bid(elob::c_order_ptr &t_order) {
+	if (t_order->m_all_or_nothing && !m_auction &&
+	    !t_order->m_withdrawn) {
+		executable = is_fillable<Side>(t_order);
+	}
 
-	execute_bid(t_order);
+	if (executable) {
+		execute_queued<Side>(t_order);
 
-	if (t_order->m_immediate_or_cancel) {
-		if (t_order->m_quantity > 0.0) {
-			t_order->on_canceled();
+		if (t_order->m_quantity <= 0.0) {
+			limit_obj.erase(t_order->m_order_slot);
+			erase_if_empty<Side>(*t_order);
+			t_order->m_book = nullptr;
 		}
-
-		t_order->m_book = nullptr;
-		return;
 	}
 
-	if (t_order->m_quantity > 0.0) {
-		queue_bid_order(t_order);
-	} else {
-		t_order->m_book = nullptr;
+	// pegged orders cannot fill anything without a reference price
+	double price = t_order->m_price;
+
+	if (!t_order->is_pegged() ||
+	    get_peg_reference(Side, t_order->m_peg, price)) {
+		// the offset of other orders is zero
+		check_aons<side_traits<Side>::opposite>(
+		    price + t_order->m_offset);
 	}
+
+	end_order_deferral();
+	return true;
 }
 
-void elob::book::insert_ask(elob::c_order_ptr &t_order) {
+template <elob::side Side>
+void elob::book::insert_order(elob::c_order_ptr &t_order) {
 
-	execute_ask(t_order);
+	execute<Side>(t_order);
 
 	if (t_order->m_immediate_or_cancel) {
 		if (t_order->m_quantity > 0.0) {
@@ -500,16 +2743,17 @@ void elob::book::insert_ask(elob::c_order_ptr &t_order) {
 	}
 
 	if (t_order->m_quantity > 0.0) {
-		queue_ask_order(t_order);
+		queue_order<Side>(t_order);
 	} else {
 		t_order->m_book = nullptr;
 	}
 }
 
-void elob::book::insert_aon_bid(elob::c_order_ptr &t_order) {
+template <elob::side Side>
+void elob::book::insert_aon_order(elob::c_order_ptr &t_order) {
 
-	if (bid_is_fillable(t_order)) {
-		execute_bid(t_order);
+	if (is_fillable<Side>(t_order)) {
+		execute<Side>(t_order);
 		t_order->m_book = nullptr;
 		return;
 	}
@@ -521,194 +2765,507 @@ void elob::book::insert_aon_bid(elob::c_order_ptr &t_order) {
 	}
 
 	// queue unexecuted aon order
-	queue_bid_order(t_order);
+	queue_order<Side>(t_order);
 }
 
-void elob::book::insert_aon_ask(elob::c_order_ptr &t_order) {
+template <elob::side Side>
+bool elob::book::is_fillable(elob::c_order_ptr &t_order) const {
+	constexpr elob::side opposite = side_traits<Side>::opposite;
+	double references[peg_type_count];
+	bool available[peg_type_count];
+	get_peg_references(opposite, references, available);
+	double quantity_remaining = t_order->m_quantity;
 
-	if (ask_is_fillable(t_order)) {
-		execute_ask(t_order);
-		t_order->m_book = nullptr;
-		return;
+	for_each_level(limits<opposite>(), pegs<opposite>(), references,
+	    available, t_order->m_price,
+	    [&](const double, const auto t_limit_it, const bool) {
+		    quantity_remaining -=
+			simulate_fill(t_limit_it->second, quantity_remaining);
+		    return quantity_remaining > 0.0;
+	    });
+
+	return quantity_remaining <= 0.0;
+}
+
+double elob::book::simulate_fill(
+    const elob::order_limit &t_limit, const double t_quantity) {
+	const double limit_quantity =
+	    t_limit.m_quantity + t_limit.m_hidden_quantity;
+	const double total_quantity = limit_quantity + t_limit.m_aon_quantity;
+
+	if (t_quantity >= total_quantity) {
+		return total_quantity;
 	}
 
-	if (t_order->m_immediate_or_cancel) {
-		t_order->on_canceled();
-		t_order->m_book = nullptr;
-		return;
+	// the regular orders alone can absorb the order
+	if (t_quantity <= limit_quantity) {
+		return t_quantity;
 	}
 
-	// queue unexecuted aon order
-	queue_ask_order(t_order);
+	// computationally expensive
+	return t_quantity - t_limit.simulate_trade(t_quantity);
 }
 
-bool elob::book::bid_is_fillable(elob::c_order_ptr &t_order) const {
-	auto limit_it = m_asks.begin();
-	double quantity_remaining = t_order->m_quantity;
-	const double order_price = t_order->m_price;
-
-	while (limit_it != m_asks.end() && limit_it->first <= order_price &&
-	       quantity_remaining > 0.0) {
-		const double limit_quantity = limit_it->second.m_quantity;
-		const double aon_limit_quantity =
-		    limit_it->second.m_aon_quantity;
-		const double total_limit_quantity =
-		    limit_quantity + aon_limit_quantity;
-
-		if (quantity_remaining >= total_limit_quantity) {
-			quantity_remaining -= total_limit_quantity;
-		} else if (quantity_remaining <= limit_quantity) {
-			return true;
-		} else {
-			// computationally expensive
-			quantity_remaining =
-			    limit_it->second.simulate_trade(quantity_remaining);
-		}
+template <class Limits>
+void elob::book::simulate_market_orders(const Limits &t_limits,
+    const Limits (&t_pegs)[peg_type_count], const elob::side t_side,
+    const double t_limit_price, const double *t_quantities,
+    elob::market_impact *t_impacts, const std::size_t t_count) const {
+	for (std::size_t i = 0; i < t_count; ++i) {
+		t_impacts[i] = elob::market_impact();
+		t_impacts[i].remaining_quantity = t_quantities[i];
+	}
 
-		++limit_it;
+	double references[peg_type_count];
+	bool available[peg_type_count];
+	get_peg_references(t_side, references, available);
+
+	for_each_level(t_limits, t_pegs, references, available, t_limit_price,
+	    [&](const double t_price, const auto t_limit_it, const bool) {
+		    bool active = false;
+
+		    for (std::size_t i = 0; i < t_count; ++i) {
+			    auto &impact = t_impacts[i];
+
+			    if (impact.remaining_quantity <= 0.0) {
+				    continue;
+			    }
+
+			    const double fill = simulate_fill(
+				t_limit_it->second, impact.remaining_quantity);
+
+			    if (fill > 0.0) {
+				    impact.filled_quantity += fill;
+				    impact.remaining_quantity -= fill;
+				    impact.notional += fill * t_price;
+				    impact.worst_price = t_price;
+				    ++impact.level_count;
+			    }
+
+			    active = active || impact.remaining_quantity > 0.0;
+		    }
+
+		    return active;
+	    });
+}
+
+elob::market_impact elob::book::simulate_market_order(const elob::side t_side,
+    const double t_quantity, const double t_limit_price) const {
+	elob::market_impact impact;
+
+	if (t_side == elob::side::bid) {
+		simulate_market_orders(m_asks, m_ask_pegs, elob::side::ask,
+		    t_limit_price, &t_quantity, &impact, 1);
+	} else {
+		simulate_market_orders(m_bids, m_bid_pegs, elob::side::bid,
+		    t_limit_price, &t_quantity, &impact, 1);
 	}
 
-	return quantity_remaining <= 0.0;
+	return impact;
 }
 
-bool elob::book::ask_is_fillable(elob::c_order_ptr &t_order) const {
-	auto limit_it = m_bids.begin();
-	double quantity_remaining = t_order->m_quantity;
-	const double order_price = t_order->m_price;
-
-	while (limit_it != m_bids.end() && limit_it->first >= order_price &&
-	       quantity_remaining > 0.0) {
-		const double limit_quantity = limit_it->second.m_quantity;
-		const double aon_limit_quantity =
-		    limit_it->second.m_aon_quantity;
-		const double total_limit_quantity =
-		    limit_quantity + aon_limit_quantity;
-
-		if (quantity_remaining >= total_limit_quantity) {
-			quantity_remaining -= total_limit_quantity;
-		} else if (quantity_remaining <= limit_quantity) {
-			return true;
-		} else {
-			// computationally expensive
-			quantity_remaining =
-			    limit_it->second.simulate_trade(quantity_remaining);
+void elob::book::simulate_market_orders(const elob::side t_side,
+    const std::vector<double> &t_quantities,
+    std::vector<elob::market_impact> &t_impacts,
+    const double t_limit_price) const {
+	t_impacts.resize(t_quantities.size());
+
+	if (t_side == elob::side::bid) {
+		simulate_market_orders(m_asks, m_ask_pegs, elob::side::ask,
+		    t_limit_price, t_quantities.data(), t_impacts.data(),
+		    t_quantities.size());
+	} else {
+		simulate_market_orders(m_bids, m_bid_pegs, elob::side::bid,
+		    t_limit_price, t_quantities.data(), t_impacts.data(),
+		    t_quantities.size());
+	}
+}
+
+double elob::book::trade(elob::order_limit &t_limit,
+    elob::c_order_ptr &t_order, const double t_price) {
+	double traded_quantity = 0.0;
+
+	if (t_order->m_quantity < t_limit.m_quantity) {
+		if (m_matching_policy == elob::pro_rata) {
+			traded_quantity = t_limit.trade_pro_rata<false>(
+			    t_order, t_price, m_lot_size);
+		} else if (m_matching_policy == elob::top_pro_rata) {
+			traded_quantity = t_limit.trade_pro_rata<true>(
+			    t_order, t_price, m_lot_size);
 		}
+	}
 
-		++limit_it;
+	if (t_order->m_quantity > 0.0) {
+		traded_quantity += t_limit.trade(t_order, t_price);
 	}
 
-	return quantity_remaining <= 0.0;
+	return traded_quantity;
 }
 
-void elob::book::execute_bid(elob::c_order_ptr &t_order) {
-	auto limit_it = m_asks.begin();
-	double order_price = t_order->m_price;
+template <elob::side Side>
+void elob::book::execute(elob::c_order_ptr &t_order) {
+	constexpr elob::side opposite = side_traits<Side>::opposite;
+	double references[peg_type_count];
+	bool available[peg_type_count];
+	get_peg_references(opposite, references, available);
+
+	for_each_level(limits<opposite>(), pegs<opposite>(), references,
+	    available, t_order->m_price,
+	    [&](const double t_price, const auto t_limit_it,
+		const bool t_pegged) {
+		    t_limit_it->second.unshare(this);
+		    const double traded_quantity =
+			trade(t_limit_it->second, t_order, t_price);
+
+		    if (traded_quantity > 0.0) {
+			    m_market_price = t_price;
+			    m_last_trade_quantity = traded_quantity;
+
+			    if (t_order->m_group != 0) {
+				    fire_group(t_order->m_group);
+			    }
+
+			    if (!t_pegged) {
+				    touch(opposite, t_price);
+			    }
+
+			    if (m_listener) {
+				    m_listener->on_trade(
+					Side, t_price, traded_quantity);
+			    }
+		    }
+
+		    return t_order->m_quantity > 0.0;
+	    },
+	    this);
+
+	fire_triggers<opposite>();
+}
 
-	while (limit_it != m_asks.end() && limit_it->first <= order_price &&
-	       t_order->m_quantity > 0.0) {
-		if (limit_it->second.trade(t_order) > 0.0) {
-			m_market_price = limit_it->first;
-		}
+template <elob::side Side> void elob::book::fire_triggers() {
+	auto &trigger_limits = triggers<Side>();
+	const auto key_comp = trigger_limits.key_comp();
+	const double trigger_price =
+	    Side == elob::side::bid ? m_bid_trigger_price : m_ask_trigger_price;
 
-		if (limit_it->second.is_empty()) {
-			m_asks.erase(limit_it++);
+	// the market price is negative before the first trade
+	if (m_market_price < 0.0 || key_comp(m_market_price, trigger_price)) {
+		return;
+	}
+
+	auto trigger_limit_it = trigger_limits.begin();
+
+	while (trigger_limit_it != trigger_limits.end() &&
+	       !key_comp(m_market_price, trigger_limit_it->first)) {
+		m_cascade.trigger_count +=
+		    trigger_limit_it->second.trigger_all();
+		++trigger_limit_it;
+	}
+
+	while (trigger_limits.begin() != trigger_limit_it) {
+		erase_level(trigger_limits, trigger_limits.begin());
+	}
+
+	cache_trigger_price<Side>();
+}
+
+template <elob::side Side> void elob::book::cache_trigger_price() {
+	const auto &trigger_limits = triggers<Side>();
+
+	if constexpr (Side == elob::side::bid) {
+		m_bid_trigger_price = trigger_limits.empty()
+					  ? -1.0
+					  : trigger_limits.begin()->first;
+	} else {
+		m_ask_trigger_price = trigger_limits.empty()
+					  ? max_price
+					  : trigger_limits.begin()->first;
+	}
+}
+
+void elob::book::compute_clearing_price(
+    double &t_price, double &t_volume) const {
+	t_price = -1.0;
+	t_volume = 0.0;
+
+	if (m_bids.empty() || m_asks.empty() ||
+	    m_bids.begin()->first < m_asks.begin()->first) {
+		return;
+	}
+
+	const double bid_price = m_bids.begin()->first;
+	const double ask_price = m_asks.begin()->first;
+	double reference = m_market_price;
+
+	// market orders do not carry a price
+	if (reference < 0.0) {
+		if (bid_price == max_price) {
+			reference = ask_price;
+		} else if (ask_price == min_price) {
+			reference = bid_price;
 		} else {
-			++limit_it;
+			reference = (bid_price + ask_price) / 2.0;
 		}
 	}
 
-	auto trigger_limit_it = m_ask_triggers.begin();
+	// only the crossed levels can trade
+	const auto bids_end = m_bids.upper_bound(ask_price);
+	const auto asks_end = m_asks.upper_bound(bid_price);
+	double demand = 0.0;
+	double supply = 0.0;
 
-	while (trigger_limit_it != m_ask_triggers.end() &&
-	       trigger_limit_it->first <= m_market_price) {
-		trigger_limit_it->second.trigger_all();
-		++trigger_limit_it;
+	for (auto it = m_bids.begin(); it != bids_end; ++it) {
+		demand += it->second.m_quantity + it->second.m_hidden_quantity;
 	}
 
-	m_ask_triggers.erase(m_ask_triggers.begin(), trigger_limit_it);
+	// walk the crossed prices upwards: demand holds the bids at or
+	// above the price, supply the asks at or below it
+	auto bid_it = std::make_reverse_iterator(bids_end);
+	const auto bid_end = m_bids.rend();
+	auto ask_it = m_asks.begin();
+	double best_imbalance = 0.0;
+
+	while (bid_it != bid_end || ask_it != asks_end) {
+		double price = 0.0;
+
+		if (bid_it == bid_end) {
+			price = ask_it->first;
+		} else if (ask_it == asks_end) {
+			price = bid_it->first;
+		} else {
+			price = std::min(bid_it->first, ask_it->first);
+		}
+
+		while (ask_it != asks_end && ask_it->first <= price) {
+			supply += ask_it->second.m_quantity +
+				  ask_it->second.m_hidden_quantity;
+			++ask_it;
+		}
+
+		const double volume = std::min(demand, supply);
+		const double imbalance = std::abs(demand - supply);
+
+		const bool better =
+		    volume > t_volume ||
+		    (volume == t_volume && volume > 0.0 &&
+			(imbalance < best_imbalance ||
+			    (imbalance == best_imbalance &&
+				std::abs(price - reference) <
+				    std::abs(t_price - reference))));
+
+		// the levels of market orders are no clearing price
+		if (better && price != max_price && price != min_price) {
+			t_price = price;
+			t_volume = volume;
+			best_imbalance = imbalance;
+		}
+
+		while (bid_it != bid_end && bid_it->first <= price) {
+			demand -= bid_it->second.m_quantity +
+				  bid_it->second.m_hidden_quantity;
+			++bid_it;
+		}
+	}
 }
 
-void elob::book::execute_ask(elob::c_order_ptr &t_order) {
-	auto limit_it = m_bids.begin();
-	double order_price = t_order->m_price;
+template <class Limits>
+void elob::book::fill_at_clearing_price(
+    Limits &t_limits, const elob::side t_side, elob::c_order_ptr &t_order) {
+	const auto key_comp = t_limits.key_comp();
+	auto limit_it = t_limits.begin();
 
-	while (limit_it != m_bids.end() && limit_it->first >= order_price &&
+	while (limit_it != t_limits.end() &&
+	       !key_comp(t_order->m_price, limit_it->first) &&
 	       t_order->m_quantity > 0.0) {
-		if (limit_it->second.trade(t_order) > 0.0) {
-			m_market_price = limit_it->first;
-		}
+		limit_it->second.unshare(this);
+		trade(limit_it->second, t_order, limit_it->first);
+		touch(t_side, limit_it->first);
 
 		if (limit_it->second.is_empty()) {
-			m_bids.erase(limit_it++);
+			limit_it = erase_level(t_limits, limit_it);
 		} else {
 			++limit_it;
 		}
 	}
+}
 
-	auto trigger_limit_it = m_bid_triggers.begin();
-
-	while (trigger_limit_it != m_bid_triggers.end() &&
-	       trigger_limit_it->first >= m_market_price) {
-		trigger_limit_it->second.trigger_all();
-		++trigger_limit_it;
+void elob::book::begin_auction() {
+	if (m_auction) {
+		return;
 	}
 
-	m_bid_triggers.erase(m_bid_triggers.begin(), trigger_limit_it);
+	m_auction = true;
+	m_indicative_changed = true;
+	publish();
 }
 
-void elob::book::execute_queued_bid(elob::c_order_ptr &t_order) {
-	const double quantity = t_order->m_quantity;
-	execute_bid(t_order);
-	t_order->m_limit_it->second.m_aon_quantity -= quantity;
+void elob::book::clear_auction() {
+	double price = 0.0;
+	double volume = 0.0;
+	compute_clearing_price(price, volume);
+	m_auction = false;
+	m_indicative_changed = false;
+	m_indicative_price = -1.0;
+	m_indicative_volume = 0.0;
+
+	if (volume > 0.0) {
+		m_market_price = price;
+		m_last_trade_quantity = volume;
+
+		// both sides trade against the auction
+		const auto auction_bid = std::make_shared<elob::order>(
+		    elob::side::bid, price, volume);
+		const auto auction_ask = std::make_shared<elob::order>(
+		    elob::side::ask, price, volume);
+		auction_bid->m_book = this;
+		auction_ask->m_book = this;
+		fill_at_clearing_price(m_asks, elob::side::ask, auction_bid);
+		fill_at_clearing_price(m_bids, elob::side::bid, auction_ask);
+
+		if (m_listener) {
+			m_listener->on_trade(elob::side::bid, price, volume);
+		}
+
+		fire_triggers<elob::side::ask>();
+		fire_triggers<elob::side::bid>();
+	}
+
+	for (const auto &order_obj : m_batch_iocs) {
+		if (order_obj->m_queued && order_obj->m_book == this) {
+			expire(order_obj);
+		}
+	}
+
+	m_batch_iocs.clear();
+
+	// only all-or-nothing orders can still cross the book
+	if (!m_bids.empty() && !m_asks.empty() &&
+	    m_bids.begin()->first >= m_asks.begin()->first) {
+		check_aons<elob::side::bid>(m_bids.begin()->first);
+		check_aons<elob::side::ask>(m_asks.begin()->first);
+	}
 }
 
-void elob::book::execute_queued_ask(elob::c_order_ptr &t_order) {
-	const double quantity = t_order->m_quantity;
-	execute_ask(t_order);
-	t_order->m_limit_it->second.m_aon_quantity -= quantity;
+void elob::book::uncross() {
+	// batches are cleared by the clock
+	if (!m_auction || m_batch_interval != 0) {
+		return;
+	}
+
+	begin_order_deferral();
+	clear_auction();
+	end_order_deferral();
 }
 
-void elob::book::check_bid_aons(const double t_price) {
-	auto limit_it = m_bids.lower_bound(t_price);
+void elob::book::set_batch_interval(const std::uint64_t t_interval) {
+	const bool batching = m_batch_interval != 0;
+	m_batch_interval = t_interval;
 
-	while (limit_it != m_bids.end()) {
-		auto &limit_obj = limit_it->second;
-		auto order_it = limit_obj.m_aon_order_its.begin();
-		while (order_it != limit_obj.m_aon_order_its.end()) {
-			auto order_obj = **order_it;
-			if (bid_is_fillable(order_obj)) {
-				execute_queued_bid(order_obj);
-				limit_obj.erase(*(order_it++));
-			} else {
-				++order_it;
-			}
+	if (t_interval == 0) {
+		if (batching) {
+			uncross();
 		}
 
-		if (limit_it->second.is_empty()) {
-			m_bids.erase(limit_it++);
-		} else {
-			++limit_it;
+		return;
+	}
+
+	// the crossed orders of a call auction join the first batch
+	m_auction = true;
+	m_indicative_changed = true;
+	m_indicative_price = -1.0;
+	m_indicative_volume = 0.0;
+}
+
+std::uint64_t elob::book::get_batch_interval() const {
+	return m_batch_interval;
+}
+
+elob::matching_policy elob::book::get_matching_policy() const {
+	return m_matching_policy;
+}
+
+double elob::book::get_lot_size() const { return m_lot_size; }
+
+void elob::book::set_lazy_cancel(const bool t_lazy) {
+	m_lazy_cancel = t_lazy;
+}
+
+bool elob::book::is_lazy_cancel() const { return m_lazy_cancel; }
+
+void elob::book::compact() {
+	const auto compact_levels = [](auto &t_limits) {
+		for (auto &limit : t_limits) {
+			limit.second.compact();
 		}
+	};
+
+	compact_levels(m_bids);
+	compact_levels(m_asks);
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		compact_levels(m_bid_pegs[i]);
+		compact_levels(m_ask_pegs[i]);
+	}
+}
+
+template <elob::side Side>
+void elob::book::execute_queued(elob::c_order_ptr &t_order) {
+	const double quantity = t_order->m_quantity;
+	execute<Side>(t_order);
+	auto &limit_obj = m_levels[t_order->m_level]->second;
+
+	if (t_order->m_all_or_nothing) {
+		limit_obj.m_aon_quantity -= quantity - t_order->m_quantity;
+	} else {
+		limit_obj.m_quantity -= quantity - t_order->m_quantity;
 	}
+
+	limit_obj.update(t_order.get());
 }
 
-void elob::book::check_ask_aons(const double t_price) {
-	auto limit_it = m_asks.lower_bound(t_price);
-	while (limit_it != m_asks.end()) {
+template <elob::side Side>
+void elob::book::check_aons(const double t_price) {
+	// all-or-nothing orders wait for the auction to end
+	if (m_auction) {
+		return;
+	}
+
+	auto &side_limits = limits<Side>();
+	auto limit_it = side_limits.lower_bound(t_price);
+
+	while (limit_it != side_limits.end()) {
 		auto &limit_obj = limit_it->second;
-		auto order_it = limit_obj.m_aon_order_its.begin();
-		while (order_it != limit_obj.m_aon_order_its.end()) {
-			auto order_obj = **order_it;
-			if (ask_is_fillable(order_obj)) {
-				execute_queued_ask(order_obj);
-				limit_obj.erase(*(order_it++));
+		auto *queue = limit_obj.m_queue.get();
+		std::uint32_t aon_slot = queue->m_aon_orders.first();
+		while (aon_slot != no_slot) {
+			elob::order *const order_obj =
+			    queue->m_orders[queue->m_aon_orders[aon_slot]];
+			if (!order_obj->m_withdrawn &&
+			    is_fillable<Side>(order_obj->m_self)) {
+				limit_obj.unshare(this);
+
+				// restart on the level's own copy of the orders
+				if (limit_obj.m_queue.get() != queue) {
+					queue = limit_obj.m_queue.get();
+					aon_slot = queue->m_aon_orders.first();
+					continue;
+				}
+
+				// the order's event methods may release it
+				const order_ptr executed_order = order_obj->m_self;
+				execute_queued<Side>(executed_order);
+				const std::uint32_t next_slot =
+				    queue->m_aon_orders.next(aon_slot);
+				limit_obj.erase(order_obj->m_order_slot);
+				aon_slot = next_slot;
+				touch(Side, limit_it->first);
 			} else {
-				++order_it;
+				aon_slot = queue->m_aon_orders.next(aon_slot);
 			}
 		}
 
 		if (limit_it->second.is_empty()) {
-			m_asks.erase(limit_it++);
+			limit_it = erase_level(side_limits, limit_it);
 		} else {
 			++limit_it;
 		}
@@ -727,6 +3284,148 @@ double elob::book::get_ask_price() const {
 
 double elob::book::get_market_price() const { return m_market_price; }
 
+const elob::cascade_stats &elob::book::get_cascade_stats() const {
+	return m_cascade;
+}
+
+std::uint64_t elob::book::get_time() const { return m_time; }
+
+void elob::book::advance_timers(const std::uint64_t t_time) {
+	if (m_timers) {
+		m_timers->advance(t_time, [this](const std::uint64_t t_expiry,
+					      const expiry_timer &t_timer) {
+			m_time = t_expiry;
+
+			if (const auto order_obj = t_timer.m_order.lock()) {
+				on_timer(order_obj, t_expiry);
+			} else if (const auto trigger_obj =
+					   t_timer.m_trigger.lock()) {
+				on_timer(trigger_obj, t_expiry);
+			}
+		});
+	}
+
+	m_time = t_time;
+}
+
+void elob::book::advance_time(const std::uint64_t t_time) {
+	if (t_time <= m_time) {
+		return;
+	}
+
+	// clear the batches in which a crossing level changed or which
+	// hold immediate or cancel orders to cancel. Orders inserted by
+	// event methods join the next batch, which ends the loop once no
+	// more orders cross.
+	while (m_batch_interval != 0 &&
+	       (m_indicative_changed || !m_batch_iocs.empty()) &&
+	       m_time <= UINT64_MAX - m_batch_interval) {
+		const std::uint64_t boundary =
+		    m_time - m_time % m_batch_interval + m_batch_interval;
+
+		if (boundary > t_time) {
+			break;
+		}
+
+		begin_order_deferral();
+		advance_timers(boundary);
+		clear_auction();
+		m_auction = true;
+		end_order_deferral();
+	}
+
+	begin_order_deferral();
+	advance_timers(t_time);
+	end_order_deferral();
+}
+
+void elob::book::expire_all() {
+	begin_order_deferral();
+	std::vector<elob::order_ptr> expired;
+
+	// peg groups first as their prices depend on the other levels
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		expire_levels(m_bid_pegs[i], elob::side::bid, true, expired);
+		expire_levels(m_ask_pegs[i], elob::side::ask, true, expired);
+	}
+
+	expire_levels(m_bids, elob::side::bid, false, expired);
+	expire_levels(m_asks, elob::side::ask, false, expired);
+
+	// every order is dequeued before the event methods are called
+	for (const auto &order_obj : expired) {
+		if (order_obj->m_group != 0) {
+			leave_group(order_obj->m_group);
+		}
+
+		order_obj->on_canceled();
+		order_obj->m_book = nullptr;
+	}
+
+	std::vector<elob::trigger_ptr> expired_triggers;
+
+	for (auto &limit : m_bid_triggers) {
+		for (const auto trigger_obj : limit.second) {
+			if (trigger_obj->m_expiry != 0) {
+				expired_triggers.push_back(trigger_obj->m_self);
+			}
+		}
+	}
+
+	for (auto &limit : m_ask_triggers) {
+		for (const auto trigger_obj : limit.second) {
+			if (trigger_obj->m_expiry != 0) {
+				expired_triggers.push_back(trigger_obj->m_self);
+			}
+		}
+	}
+
+	for (const auto &trigger_obj : expired_triggers) {
+		trigger_obj->cancel();
+	}
+
+	end_order_deferral();
+}
+
+bool elob::book::is_auction() const { return m_auction; }
+
+double elob::book::get_indicative_price() const {
+	return m_indicative_price;
+}
+
+double elob::book::get_indicative_volume() const {
+	return m_indicative_volume;
+}
+
+double elob::book::get_peg_price(const elob::side t_side,
+    const elob::peg_type t_peg, const double t_offset) const {
+	double reference = 0.0;
+
+	if (!get_peg_reference(t_side, t_peg, reference)) {
+		return -1.0;
+	}
+
+	return reference + t_offset;
+}
+
+const elob::snapshot &elob::book::enable_snapshot() {
+	if (!m_snapshot) {
+		m_snapshot = std::make_unique<elob::snapshot>();
+		publish();
+	}
+
+	return *m_snapshot;
+}
+
+const elob::snapshot *elob::book::get_snapshot() const {
+	return m_snapshot.get();
+}
+
+void elob::book::set_listener(elob::listener *t_listener) {
+	m_listener = t_listener;
+	m_touched.clear();
+}
+
 std::map<double, elob::order_limit>::iterator elob::book::bid_limits_begin() {
 	return m_bids.begin();
 }
@@ -754,11 +3453,19 @@ std::map<double, elob::order_limit>::iterator elob::book::ask_limit_at(
 }
 
 elob::bid_order_iterator elob::book::bid_orders_begin() {
+	if (m_bids.empty()) {
+		return bid_orders_end();
+	}
+
 	return elob::bid_order_iterator(
 	    m_bids, m_bids.begin(), m_bids.begin()->second.begin());
 }
 
 elob::ask_order_iterator elob::book::ask_orders_begin() {
+	if (m_asks.empty()) {
+		return ask_orders_end();
+	}
+
 	return elob::ask_order_iterator(
 	    m_asks, m_asks.begin(), m_asks.begin()->second.begin());
 }
@@ -771,12 +3478,100 @@ elob::ask_order_iterator elob::book::ask_orders_end() {
 	return elob::ask_order_iterator(m_asks, m_asks.end());
 }
 
+std::unique_ptr<elob::book> elob::book::fork() const {
+	auto copy =
+	    std::make_unique<elob::book>(m_matching_policy, m_lot_size);
+	copy->m_bids = m_bids;
+	copy->m_asks = m_asks;
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		copy->m_bid_pegs[i] = m_bid_pegs[i];
+		copy->m_ask_pegs[i] = m_ask_pegs[i];
+	}
+
+	// the levels of the fork keep their handles
+	copy->m_levels = m_levels;
+	const auto rebind = [&copy](auto &t_limits) {
+		for (auto it = t_limits.begin(); it != t_limits.end(); ++it) {
+			copy->m_levels.assign(it->second.m_handle, it);
+		}
+	};
+
+	rebind(copy->m_bids);
+	rebind(copy->m_asks);
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		rebind(copy->m_bid_pegs[i]);
+		rebind(copy->m_ask_pegs[i]);
+	}
+
+	copy->m_market_price = m_market_price;
+	copy->m_last_trade_quantity = m_last_trade_quantity;
+	copy->m_time = m_time;
+	copy->m_auction = m_auction;
+	copy->m_indicative_price = m_indicative_price;
+	copy->m_indicative_volume = m_indicative_volume;
+	copy->m_batch_interval = m_batch_interval;
+	copy->m_lazy_cancel = m_lazy_cancel;
+
+	// the fork indexes its copies of the orders of the shared levels
+	// once it needs them
+	bool owns_orders = false;
+	copy->m_participants = m_participants;
+
+	for (auto &entry : copy->m_participants) {
+		owns_orders = owns_orders || entry.second.m_first;
+		entry.second.m_first = nullptr;
+	}
+
+	copy->m_participants_indexed = m_participants_indexed && !owns_orders;
+	return copy;
+}
+
+elob::book::book(const elob::matching_policy t_matching_policy,
+    const double t_lot_size)
+    : m_matching_policy(t_matching_policy), m_lot_size(t_lot_size) {}
+
 elob::book::~book() {
+	for (auto &limit : m_bids) {
+		limit.second.release(this);
+	}
+
+	for (auto &limit : m_asks) {
+		limit.second.release(this);
+	}
+
+	for (std::size_t i = 0; i < peg_type_count; ++i) {
+		for (auto &limit : m_bid_pegs[i]) {
+			limit.second.release(this);
+		}
+
+		for (auto &limit : m_ask_pegs[i]) {
+			limit.second.release(this);
+		}
+
+		m_bid_pegs[i].clear();
+		m_ask_pegs[i].clear();
+	}
+
 	m_bids.clear();
 	m_asks.clear();
 
 	m_bid_triggers.clear();
 	m_ask_triggers.clear();
+
+	// the legs may outlive the book
+	for (std::uint32_t i = 0; i < m_groups.size(); ++i) {
+		for (const auto &leg : m_groups[i].m_legs) {
+			if (group_of(leg) == i + 1) {
+				group_of(leg) = 0;
+			}
+		}
+
+		for (const auto &leg : m_groups[i].m_exits) {
+			group_of(leg) = 0;
+		}
+	}
 }
 
 #endif // BOOK_HPP
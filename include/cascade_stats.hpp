@@ -0,0 +1,30 @@
+#ifndef CASCADE_STATS_HPP
+#define CASCADE_STATS_HPP
+#include <cstddef>
+
+namespace elob {
+
+/**
+ * @brief Statistics of the cascade released by an operation of a book,
+ * see book::get_cascade_stats. Orders inserted by event methods and
+ * triggers that fire on insertion from within event methods are
+ * processed in waves: the work released by one wave forms the next.
+ *
+ */
+struct cascade_stats {
+	// number of waves, i.e. the depth of the cascade
+	std::size_t wave_count = 0;
+
+	// the largest number of orders and triggers in a wave
+	std::size_t max_wave_size = 0;
+
+	// orders inserted by event methods
+	std::size_t order_count = 0;
+
+	// triggers fired, including those fired by the operation itself
+	std::size_t trigger_count = 0;
+};
+
+} // namespace elob
+
+#endif // #ifndef CASCADE_STATS_HPP
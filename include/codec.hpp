@@ -0,0 +1,296 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/* The wire format shared by the gateway and the shared memory feed.
+	Every message consists of a fixed 8 byte header followed by a
+	fixed-length block. Both are accessed through flyweight views
+	that read and write the fields in place at fixed offsets, so
+	encoding and decoding never copy or allocate. Fields are stored
+	in host byte order without padding.
+
+	The schema below is the single declaration of all messages: each
+	ELOB_CODEC_*_FIELDS list is expanded into a view class with one
+	getter and one setter per field. New fields must be appended to
+	the end of a list so that older readers, which only check that
+	the block is at least as long as they expect, keep working. */
+
+// clang-format off
+#define ELOB_CODEC_INSERT_FIELDS(FIELD)                                        \
+	FIELD(std::uint64_t, token)                                            \
+	FIELD(double, price)                                                   \
+	FIELD(double, quantity)                                                \
+	FIELD(std::uint8_t, side)                                              \
+	FIELD(std::uint8_t, flags)
+
+#define ELOB_CODEC_CANCEL_FIELDS(FIELD)                                        \
+	FIELD(std::uint64_t, token)
+
+#define ELOB_CODEC_AMEND_FIELDS(FIELD)                                         \
+	FIELD(std::uint64_t, token)                                            \
+	FIELD(double, price)                                                   \
+	FIELD(double, quantity)
+
+#define ELOB_CODEC_ACK_FIELDS(FIELD)                                           \
+	FIELD(std::uint64_t, token)                                            \
+	FIELD(double, price)                                                   \
+	FIELD(double, quantity)                                                \
+	FIELD(std::uint8_t, status)                                            \
+	FIELD(std::uint8_t, side)
+
+#define ELOB_CODEC_FILL_FIELDS(FIELD)                                          \
+	FIELD(std::uint64_t, token)                                            \
+	FIELD(std::uint64_t, batch)                                            \
+	FIELD(double, price)                                                   \
+	FIELD(double, quantity)                                                \
+	FIELD(std::uint8_t, side)
+
+#define ELOB_CODEC_LEVEL_FIELDS(FIELD)                                         \
+	FIELD(std::uint64_t, batch)                                            \
+	FIELD(double, price)                                                   \
+	FIELD(double, quantity)                                                \
+	FIELD(double, aon_quantity)                                            \
+	FIELD(std::uint32_t, order_count)                                      \
+	FIELD(std::uint8_t, side)
+
+#define ELOB_CODEC_BATCH_FIELDS(FIELD)                                         \
+	FIELD(std::uint64_t, batch)                                            \
+	FIELD(double, market_price)
+
+#define ELOB_CODEC_MESSAGES(MESSAGE)                                           \
+	MESSAGE(insert_message, 1, ELOB_CODEC_INSERT_FIELDS)                   \
+	MESSAGE(cancel_message, 2, ELOB_CODEC_CANCEL_FIELDS)                   \
+	MESSAGE(amend_message, 3, ELOB_CODEC_AMEND_FIELDS)                     \
+	MESSAGE(ack_message, 4, ELOB_CODEC_ACK_FIELDS)                         \
+	MESSAGE(fill_message, 5, ELOB_CODEC_FILL_FIELDS)                       \
+	MESSAGE(level_message, 6, ELOB_CODEC_LEVEL_FIELDS)                     \
+	MESSAGE(batch_message, 7, ELOB_CODEC_BATCH_FIELDS)
+// clang-format on
+
+namespace elob {
+namespace codec {
+
+const std::uint16_t schema_id = 0x454c; // "EL"
+const std::uint16_t schema_version = 1;
+
+enum flags : std::uint8_t {
+	immediate_or_cancel_flag = 1,
+	all_or_nothing_flag = 2
+};
+
+enum status : std::uint8_t {
+	accepted_status = 'A',
+	rejected_status = 'J',
+	canceled_status = 'C',
+	replaced_status = 'R'
+};
+
+namespace detail {
+
+template <class T> inline T load(const char *t_address) {
+	T value;
+	std::memcpy(&value, t_address, sizeof(T));
+	return value;
+}
+
+template <class T> inline void store(char *t_address, const T t_value) {
+	std::memcpy(t_address, &t_value, sizeof(T));
+}
+
+template <std::size_t N>
+constexpr std::size_t offset_of(
+    const std::size_t (&t_sizes)[N], const std::size_t t_index) {
+	std::size_t offset = 0;
+
+	for (std::size_t i = 0; i < t_index; ++i) {
+		offset += t_sizes[i];
+	}
+
+	return offset;
+}
+
+} // namespace detail
+
+/**
+ * @brief View of the header that precedes every message.
+ *
+ * @tparam Byte char for encoding, const char for decoding
+ */
+template <class Byte> class basic_header {
+	private:
+	Byte *m_buffer;
+
+	public:
+	static constexpr std::size_t encoded_length = 8;
+
+	explicit basic_header(Byte *t_buffer) : m_buffer(t_buffer) {}
+
+	std::uint16_t block_length() const {
+		return detail::load<std::uint16_t>(m_buffer);
+	}
+
+	std::uint16_t template_id() const {
+		return detail::load<std::uint16_t>(m_buffer + 2);
+	}
+
+	std::uint16_t schema() const {
+		return detail::load<std::uint16_t>(m_buffer + 4);
+	}
+
+	std::uint16_t version() const {
+		return detail::load<std::uint16_t>(m_buffer + 6);
+	}
+
+	/**
+	 * @brief Get the length of the header and the block.
+	 *
+	 * @return the number of bytes the message occupies.
+	 */
+	std::size_t message_length() const {
+		return encoded_length + block_length();
+	}
+
+	void encode(const std::uint16_t t_block_length,
+	    const std::uint16_t t_template_id) {
+		detail::store(m_buffer, t_block_length);
+		detail::store(m_buffer + 2, t_template_id);
+		detail::store(m_buffer + 4, schema_id);
+		detail::store(m_buffer + 6, schema_version);
+	}
+};
+
+using header_encoder = basic_header<char>;
+using header_decoder = basic_header<const char>;
+
+#define ELOB_CODEC_FIELD_INDEX(TYPE, NAME) NAME##_index,
+
+#define ELOB_CODEC_FIELD_SIZE(TYPE, NAME) sizeof(TYPE),
+
+#define ELOB_CODEC_FIELD_ACCESSORS(TYPE, NAME)                                 \
+	TYPE NAME() const {                                                    \
+		return detail::load<TYPE>(m_buffer + header_length +           \
+		    detail::offset_of(field_sizes, NAME##_index));             \
+	}                                                                      \
+                                                                               \
+	basic_message &NAME(const TYPE t_value) {                              \
+		detail::store(m_buffer + header_length +                       \
+			detail::offset_of(field_sizes, NAME##_index),          \
+		    t_value);                                                  \
+		return *this;                                                  \
+	}
+
+#define ELOB_CODEC_MESSAGE_VIEW(NAME, ID, FIELDS)                              \
+	template <class Byte> class basic_##NAME {                             \
+		private:                                                       \
+		using basic_message = basic_##NAME;                            \
+		static constexpr std::size_t header_length =                   \
+		    basic_header<Byte>::encoded_length;                        \
+                                                                               \
+		enum field_index : std::size_t {                               \
+			FIELDS(ELOB_CODEC_FIELD_INDEX) field_count             \
+		};                                                             \
+                                                                               \
+		static constexpr std::size_t field_sizes[] = {                 \
+		    FIELDS(ELOB_CODEC_FIELD_SIZE)};                            \
+                                                                               \
+		Byte *m_buffer;                                                \
+                                                                               \
+		public:                                                        \
+		static constexpr std::uint16_t template_id = ID;               \
+		static constexpr std::uint16_t block_length =                  \
+		    detail::offset_of(field_sizes, field_count);               \
+		static constexpr std::size_t encoded_length =                  \
+		    header_length + block_length;                              \
+                                                                               \
+		explicit basic_##NAME(Byte *t_buffer) : m_buffer(t_buffer) {}  \
+                                                                               \
+		/* write the header; the fields are set individually */       \
+		basic_message &encode_header() {                               \
+			basic_header<Byte>(m_buffer).encode(                   \
+			    block_length, template_id);                        \
+			return *this;                                          \
+		}                                                              \
+                                                                               \
+		Byte *buffer() const { return m_buffer; }                      \
+                                                                               \
+		FIELDS(ELOB_CODEC_FIELD_ACCESSORS)                             \
+	};                                                                     \
+                                                                               \
+	using NAME##_encoder = basic_##NAME<char>;                             \
+	using NAME##_decoder = basic_##NAME<const char>;
+
+ELOB_CODEC_MESSAGES(ELOB_CODEC_MESSAGE_VIEW)
+
+#undef ELOB_CODEC_MESSAGE_VIEW
+#undef ELOB_CODEC_FIELD_ACCESSORS
+#undef ELOB_CODEC_FIELD_SIZE
+#undef ELOB_CODEC_FIELD_INDEX
+
+#define ELOB_CODEC_MAX_LENGTH(NAME, ID, FIELDS) NAME##_encoder::encoded_length,
+
+namespace detail {
+constexpr std::size_t max_length() {
+	const std::size_t lengths[] = {ELOB_CODEC_MESSAGES(
+	    ELOB_CODEC_MAX_LENGTH) 0};
+	std::size_t length = 0;
+
+	for (const auto current : lengths) {
+		length = current > length ? current : length;
+	}
+
+	return length;
+}
+} // namespace detail
+
+#undef ELOB_CODEC_MAX_LENGTH
+
+// length of the longest message in the schema
+const std::size_t max_message_length = detail::max_length();
+
+/**
+ * @brief Check that a buffer starts with a complete message of this
+ * schema whose block is long enough for the known fields.
+ *
+ * @param t_buffer the start of the message
+ * @param t_size the number of bytes available
+ * @return the length of the message, 0 if more bytes are needed, or
+ * SIZE_MAX if the message is malformed and the stream must be
+ * dropped.
+ */
+inline std::size_t check(const char *t_buffer, const std::size_t t_size);
+
+} // namespace codec
+} // namespace elob
+
+#define ELOB_CODEC_CHECK_BLOCK(NAME, ID, FIELDS)                               \
+	case ID:                                                               \
+		if (header.block_length() < NAME##_decoder::block_length) {   \
+			return SIZE_MAX;                                       \
+		}                                                              \
+		break;
+
+std::size_t elob::codec::check(const char *t_buffer, const std::size_t t_size) {
+	if (t_size < header_decoder::encoded_length) {
+		return 0;
+	}
+
+	const header_decoder header(t_buffer);
+
+	if (header.schema() != schema_id) {
+		return SIZE_MAX;
+	}
+
+	switch (header.template_id()) {
+		ELOB_CODEC_MESSAGES(ELOB_CODEC_CHECK_BLOCK)
+	default:
+		break;
+	}
+
+	return t_size < header.message_length() ? 0 : header.message_length();
+}
+
+#undef ELOB_CODEC_CHECK_BLOCK
+
+#endif // #ifndef CODEC_HPP
@@ -1,6 +1,7 @@
 #ifndef COMMON_HPP
 #define COMMON_HPP
 #include <cfloat>
+#include <cstddef>
 #include <memory>
 namespace elob {
 
@@ -8,6 +9,13 @@ enum side { bid = 0, ask };
 
 enum offset_type { abs = 0, pct };
 
+// the reference price of pegged orders
+enum peg_type { no_peg = 0, primary_peg, market_peg, mid_peg };
+const std::size_t peg_type_count = 3;
+
+// the allocation of inbound quantity among the orders of a level
+enum matching_policy { fifo = 0, pro_rata, top_pro_rata };
+
 const double max_price = DBL_MAX;
 const double min_price = 0.0;
 
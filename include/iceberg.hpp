@@ -0,0 +1,46 @@
+#ifndef ICEBERG_HPP
+#define ICEBERG_HPP
+#include "order.hpp"
+
+namespace elob {
+
+/**
+ * @brief An iceberg order displays at most its peak quantity. When the
+ * displayed quantity has been filled, it is replenished from the hidden
+ * quantity in place and loses time priority at its price level. On
+ * entry, the entire quantity is available to trade.
+ *
+ */
+class iceberg : public order {
+	public:
+	/**
+	 * @brief Construct a new iceberg object
+	 *
+	 * @param t_side the side at which the order will be inserted
+	 * @param t_price the price at which the order will be inserted
+	 * @param t_quantity the total quantity, displayed and hidden
+	 * @param t_peak_quantity the largest quantity displayed at a
+	 * time
+	 */
+	iceberg(const side t_side, const double t_price,
+	    const double t_quantity, const double t_peak_quantity);
+
+	/**
+	 * @brief Get the largest quantity displayed at a time.
+	 *
+	 * @return the peak quantity.
+	 */
+	inline double get_peak_quantity() const;
+};
+
+} // namespace elob
+
+elob::iceberg::iceberg(const elob::side t_side, const double t_price,
+    const double t_quantity, const double t_peak_quantity)
+    : elob::order(t_side, t_price, t_quantity) {
+	m_peak_quantity = t_peak_quantity;
+}
+
+double elob::iceberg::get_peak_quantity() const { return m_peak_quantity; }
+
+#endif // #ifndef ICEBERG_HPP
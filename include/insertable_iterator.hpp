@@ -1,6 +1,5 @@
 #ifndef INSERTABLE_ITERATOR_HPP
 #define INSERTABLE_ITERATOR_HPP
-#include <list>
 #include <map>
 
 namespace elob {
@@ -9,11 +8,11 @@ template <class Cmp, class Lim, class Ins> class insertable_iterator {
 	private:
 	std::map<double, Lim, Cmp> &m_side;
 	typename std::map<double, Lim, Cmp>::iterator m_limit_it;
-	typename std::list<Ins>::iterator m_insertable_it;
+	typename Lim::iterator m_insertable_it;
 
 	insertable_iterator(std::map<double, Lim, Cmp> &t_side,
 	    const typename std::map<double, Lim, Cmp>::iterator &t_limit_it,
-	    const typename std::list<Ins>::iterator &t_insertable_it);
+	    const typename Lim::iterator &t_insertable_it);
 
 	insertable_iterator(std::map<double, Lim, Cmp> &t_side,
 	    const typename std::map<double, Lim, Cmp>::iterator &t_limit_it);
@@ -28,8 +27,8 @@ template <class Cmp, class Lim, class Ins> class insertable_iterator {
 	insertable_iterator<Cmp, Lim, Ins> operator++();
 	insertable_iterator<Cmp, Lim, Ins> operator++(int);
 
-	typename std::list<Ins>::iterator operator->();
-	Ins &operator*();
+	typename Lim::iterator operator->();
+	const Ins &operator*();
 
 	friend book;
 };
@@ -43,7 +42,7 @@ template <class Cmp, class Lim, class Ins>
 elob::insertable_iterator<Cmp, Lim, Ins>::insertable_iterator(
     std::map<double, Lim, Cmp> &t_side,
     const typename std::map<double, Lim, Cmp>::iterator &t_limit_it,
-    const typename std::list<Ins>::iterator &t_insertable_it)
+    const typename Lim::iterator &t_insertable_it)
     : m_side(t_side), m_limit_it(t_limit_it), m_insertable_it(t_insertable_it) {}
 
 template <class Cmp, class Lim, class Ins>
@@ -109,13 +108,13 @@ elob::insertable_iterator<Cmp, Lim, Ins>::operator++(int) {
 }
 
 template <class Cmp, class Lim, class Ins>
-typename std::list<Ins>::iterator
+typename Lim::iterator
 elob::insertable_iterator<Cmp, Lim, Ins>::operator->() {
 	return m_insertable_it;
 }
 
 template <class Cmp, class Lim, class Ins>
-Ins &elob::insertable_iterator<Cmp, Lim, Ins>::operator*() {
+const Ins &elob::insertable_iterator<Cmp, Lim, Ins>::operator*() {
 	return *m_insertable_it;
 }
 
@@ -0,0 +1,84 @@
+#ifndef LEVEL_TABLE_HPP
+#define LEVEL_TABLE_HPP
+#include <cstdint>
+#include <vector>
+
+namespace elob {
+
+/**
+ * \internal
+ * @brief Maps 32 bit handles to the price levels of a book. Orders and
+ * triggers store the handle of their level instead of a map iterator.
+ * A handle stays valid while its level exists; the handles of erased
+ * levels are reused.
+ *
+ * @tparam Iterator the map iterator of a level
+ */
+template <class Iterator> class level_table {
+	private:
+	std::vector<Iterator> m_levels;
+	std::vector<std::uint32_t> m_free;
+
+	public:
+	/**
+	 * @brief Assign a handle to a new level. O(1) amortized.
+	 *
+	 * @param t_level the level
+	 * @return the handle of the level
+	 */
+	inline std::uint32_t acquire(const Iterator &t_level);
+
+	/**
+	 * @brief Release the handle of an erased level. O(1) amortized.
+	 *
+	 */
+	inline void release(const std::uint32_t t_handle);
+
+	/**
+	 * @brief Point a handle to a level in another map, e.g. to the
+	 * copy of the level in a fork.
+	 *
+	 */
+	inline void assign(
+	    const std::uint32_t t_handle, const Iterator &t_level);
+
+	/**
+	 * @brief Get the level of a handle. O(1).
+	 *
+	 */
+	inline const Iterator &operator[](const std::uint32_t t_handle) const;
+};
+
+} // namespace elob
+
+template <class Iterator>
+std::uint32_t elob::level_table<Iterator>::acquire(const Iterator &t_level) {
+	if (m_free.empty()) {
+		m_levels.push_back(t_level);
+		return static_cast<std::uint32_t>(m_levels.size() - 1);
+	}
+
+	const std::uint32_t handle = m_free.back();
+	m_free.pop_back();
+	m_levels[handle] = t_level;
+	return handle;
+}
+
+template <class Iterator>
+void elob::level_table<Iterator>::release(const std::uint32_t t_handle) {
+	m_free.push_back(t_handle);
+}
+
+template <class Iterator>
+void elob::level_table<Iterator>::assign(
+    const std::uint32_t t_handle, const Iterator &t_level) {
+	m_levels[t_handle] = t_level;
+}
+
+template <class Iterator>
+const Iterator &elob::level_table<Iterator>::operator[](
+    const std::uint32_t t_handle) const {
+	return m_levels[t_handle];
+}
+
+#endif // #ifndef LEVEL_TABLE_HPP
@@ -0,0 +1,69 @@
+#ifndef LISTENER_HPP
+#define LISTENER_HPP
+#include "common.hpp"
+#include <cstddef>
+
+namespace elob {
+
+/**
+ * @brief A listener receives market data from a book. Trades are
+ * reported as they occur. Price levels that changed during an outer
+ * operation (insertion, cancellation, quantity update) are reported
+ * once the operation has completed, followed by on_published. Override
+ * the virtual event methods to forward the data, e.g. to other
+ * processes.
+ *
+ */
+class listener {
+	public:
+	/**
+	 * @brief called after an inbound order traded against the
+	 * queued orders of a price level.
+	 *
+	 * @param t_side the side of the inbound (aggressing) order
+	 * @param t_price the price of the level traded against
+	 * @param t_quantity the quantity traded at this level
+	 */
+	virtual void on_trade(const side t_side, const double t_price,
+	    const double t_quantity){};
+
+	/**
+	 * @brief called with the aggregated state of a price level that
+	 * changed during the last operation. Removed levels are reported
+	 * with zero quantity and order count.
+	 *
+	 * @param t_side the side of the price level
+	 * @param t_price the price of the level
+	 * @param t_quantity the non-all-or-nothing quantity
+	 * @param t_aon_quantity the all-or-nothing quantity
+	 * @param t_order_count the number of queued orders
+	 */
+	virtual void on_level(const side t_side, const double t_price,
+	    const double t_quantity, const double t_aon_quantity,
+	    const std::size_t t_order_count){};
+
+	/**
+	 * @brief called once all changes of an operation have been
+	 * reported.
+	 *
+	 * @param t_market_price the market price after the operation
+	 */
+	virtual void on_published(const double t_market_price){};
+
+	/**
+	 * @brief called during an auction, before on_published, if
+	 * the indicative price or volume may have changed.
+	 *
+	 * @param t_price the price at which the auction would uncross,
+	 * -1.0 if the book is not crossed
+	 * @param t_volume the quantity that would execute
+	 */
+	virtual void on_indicative(
+	    const double t_price, const double t_volume){};
+
+	virtual ~listener() = default;
+};
+
+} // namespace elob
+
+#endif // #ifndef LISTENER_HPP
@@ -0,0 +1,42 @@
+#ifndef MARKET_IMPACT_HPP
+#define MARKET_IMPACT_HPP
+#include <cstddef>
+
+namespace elob {
+
+/**
+ * @brief The outcome of a hypothetical market order as computed by
+ * book::simulate_market_order. The book is not modified.
+ *
+ */
+struct market_impact {
+	// quantity that would have been traded
+	double filled_quantity = 0.0;
+
+	// quantity that could not have been traded
+	double remaining_quantity = 0.0;
+
+	// sum of price times quantity over all fills
+	double notional = 0.0;
+
+	// price of the last level traded against, 0.0 if none
+	double worst_price = 0.0;
+
+	// number of price levels traded against
+	std::size_t level_count = 0;
+
+	/**
+	 * @brief Get the volume weighted average fill price.
+	 *
+	 * @return double the average price or 0.0 if nothing would
+	 * have been filled.
+	 */
+	double get_vwap() const {
+		return filled_quantity > 0.0 ? notional / filled_quantity
+					     : 0.0;
+	}
+};
+
+} // namespace elob
+
+#endif // #ifndef MARKET_IMPACT_HPP
@@ -1,14 +1,20 @@
 #ifndef ORDER_HPP
 #define ORDER_HPP
 #include "common.hpp"
-#include <list>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 
 namespace elob {
 
 class order_limit;
+struct order_queue;
+struct quantity_index;
+struct order_layout;
 class book;
+class iceberg;
+class peg;
 
 /**
  * @brief the order class defines the fundamental properties of orders
@@ -17,28 +23,83 @@ class book;
  * orders with a price of zero (sell) or infinity (buy). Objects of this
  * class can be inserted into book objects. The behavior of orders can
  * be customized by overriding the virtual event methods: on_queued,
- * on_accepted, on_rejected, on_traded, and on_canceled.
+ * on_accepted, on_rejected, on_traded, on_replaced, and on_canceled.
  *
  */
 class order : public std::enable_shared_from_this<order> {
 	private:
-	const side m_side;
-	const double m_price;
+	/* the fields read when the order is matched follow the vtable
+		pointer and the weak reference of the base class, so that
+		they are loaded together with the start of the object. */
 	double m_quantity = 0.0;
+
+	/* iceberg orders display at most m_peak_quantity at a time. The
+		rest is held back in m_hidden_quantity and replenishes the
+		displayed quantity once it has been filled. */
+	double m_hidden_quantity = 0.0;
+	double m_price;
+	const side m_side;
+
+	/* pegged orders are priced at the reference price given by
+		m_peg plus m_offset rather than at m_price. */
+	peg_type m_peg = no_peg;
 	const bool m_immediate_or_cancel = false;
 	bool m_all_or_nothing = false;
 	bool m_queued = false;
 
+	/* set while the order is a leg of a fired group waiting to be
+		canceled. Its quantity no longer counts towards its level
+		and it is not matched. */
+	bool m_withdrawn = false;
+
+	// the handle of the one-cancels-other group, 0 if there is none
+	std::uint32_t m_group = 0;
+
+	/* keeps the order alive while it is queued. The book itself
+		stores plain pointers so that matching does not update
+		reference counts. */
+	order_ptr m_self;
+
 	/* pointer to the book into which the order was inserted.
 		it's guaranteed to be dereferencable in the virtual
 	   event methods. */
 	book *m_book = nullptr;
 
-	/* these iterators store the location of the order in the order
-		book. They are used to cancel the order in O(1). */
-	std::map<double, elob::order_limit>::iterator m_limit_it;
-	std::list<order_ptr>::iterator m_order_it;
-	std::list<std::list<order_ptr>::iterator>::iterator m_aon_order_its_it;
+	/* the participant that owns the order, 0 if there is none. It is
+		read whenever the order leaves its level. */
+	std::uint64_t m_owner = 0;
+
+	/* the handle of the level in its book, the slots of the order
+		in the queue and the all-or-nothing queue of the level and
+		its location in the quantity index of the level. They are
+		used to cancel the order in O(1). */
+	std::uint32_t m_level = 0;
+	std::uint32_t m_order_slot = 0;
+	std::uint32_t m_aon_slot = 0;
+	std::uint32_t m_slot = 0;
+
+	/* the queued orders of a participant are linked into the
+		participant index of their book. */
+	order *m_prev_owned = nullptr;
+	order *m_next_owned = nullptr;
+
+	double m_peak_quantity = 0.0;
+	double m_offset = 0.0;
+
+	/* orders with an expiry are canceled once the clock of their
+		book reaches it. m_timer is the expiry of the timer pending
+		in m_timer_book, 0 if there is none. */
+	std::uint64_t m_expiry = 0;
+	std::uint64_t m_timer = 0;
+	const book *m_timer_book = nullptr;
+
+	/**
+	 * \internal
+	 * @brief Remove the queued order from its price level.
+	 *
+	 * @return order_ptr the reference that kept the order queued
+	 */
+	inline order_ptr dequeue();
 
 	protected:
 	/**
@@ -72,10 +133,19 @@ class order : public std::enable_shared_from_this<order> {
 	 */
 	virtual void on_traded(c_order_ptr &t_order){};
 
+	/**
+	 * @brief called once book::replace has updated the price and
+	 * quantity of the order, before the order is matched at its
+	 * new price.
+	 *
+	 */
+	virtual void on_replaced(){};
+
 	/**
 	 * @brief called once the order got canceled. This may happen if
-	 * the order got canceled manually or if the order is immediate
-	 * or cancel and could not get filled immediately.
+	 * the order got canceled manually, if the order is immediate
+	 * or cancel and could not get filled immediately or if it
+	 * expired.
 	 *
 	 */
 	virtual void on_canceled(){};
@@ -127,27 +197,76 @@ class order : public std::enable_shared_from_this<order> {
 	inline side get_side() const;
 
 	/**
-	 * @brief Get the price of the order.
+	 * @brief Get the price of the order. For pegged orders this is
+	 * the current pegged price or, once dequeued, the price at
+	 * which they last traded or were canceled.
 	 *
 	 * @return double price of the order.
 	 */
 	inline double get_price() const;
 
 	/**
-	 * @brief Get the quantity of the order.
+	 * @brief Get the quantity of the order. For queued iceberg
+	 * orders this is the displayed quantity only.
 	 *
 	 * @return the quantity of the order.
 	 */
 	inline double get_quantity() const;
 
+	/**
+	 * @brief Get the quantity an iceberg order holds back.
+	 *
+	 * @return the hidden quantity, 0.0 for other orders.
+	 */
+	inline double get_hidden_quantity() const;
+
+	/**
+	 * @brief Check if the order is an iceberg order.
+	 *
+	 * @return true, displays only part of its quantity.
+	 * @return false, displays its entire quantity.
+	 */
+	inline bool is_iceberg() const;
+
+	/**
+	 * @brief Check if the order is pegged to a reference price.
+	 *
+	 * @return true, is pegged.
+	 * @return false, has a fixed price.
+	 */
+	inline bool is_pegged() const;
+
 	/**
 	 * @brief Update the quantity of the order. This operation is
 	 * O(1) in some cases but can be very inefficient if there are
 	 * lot of all or nothing orders in the book.
 	 *
 	 * @param t_quantity
+	 * @return false if the quantity is not positive or the increase
+	 * would exceed the risk limits of the owner of a queued order, in
+	 * which case the order is left unchanged
+	 */
+	inline bool set_quantity(const double t_quantity);
+
+	/**
+	 * @brief Get the time at which the order expires.
+	 *
+	 * @return the expiry on the clock of the book, 0 if the order
+	 * is good till canceled.
+	 */
+	inline std::uint64_t get_expiry() const;
+
+	/**
+	 * @brief Set the time at which the order expires. Once the
+	 * clock of the book (see book::advance_time) reaches the
+	 * expiry, the order is canceled and on_canceled is called.
+	 * Queued orders whose new expiry has passed expire
+	 * immediately.
+	 *
+	 * @param t_expiry the expiry on the clock of the book, 0 for
+	 * good till canceled
 	 */
-	inline void set_quantity(const double t_quantity);
+	inline void set_expiry(const std::uint64_t t_expiry);
 
 	/**
 	 * @brief Check if the order is immediate or cancel.
@@ -165,6 +284,24 @@ class order : public std::enable_shared_from_this<order> {
 	 */
 	inline bool is_all_or_nothing() const;
 
+	/**
+	 * @brief Get the participant that owns the order.
+	 *
+	 * @return the owner id, 0 if the order has no owner.
+	 */
+	inline std::uint64_t get_owner() const;
+
+	/**
+	 * @brief Set the participant that owns the order. The queued
+	 * orders of a participant can be canceled and replaced at once,
+	 * see book::mass_cancel and book::mass_quote.
+	 *
+	 * @param t_owner the owner id, 0 for no owner
+	 * @return false if a queued order would exceed the risk limits of
+	 * the new owner, in which case the owner is left unchanged
+	 */
+	inline bool set_owner(const std::uint64_t t_owner);
+
 	/**
 	 * @brief Update the order's all or nothing flag.
 	 *
@@ -184,6 +321,11 @@ class order : public std::enable_shared_from_this<order> {
 
 	friend book;
 	friend order_limit;
+	friend order_queue;
+	friend quantity_index;
+	friend order_layout;
+	friend iceberg;
+	friend peg;
 };
 
 } // namespace elob
@@ -195,23 +337,17 @@ class order : public std::enable_shared_from_this<order> {
 elob::order::order(const elob::side t_side, const double t_price,
     const double t_quantity, const bool t_immediate_or_cancel,
     const bool t_all_or_nothing)
-    : m_side(t_side), m_price(t_price), m_quantity(t_quantity),
+    : m_quantity(t_quantity), m_price(t_price), m_side(t_side),
       m_immediate_or_cancel(t_immediate_or_cancel),
       m_all_or_nothing(t_all_or_nothing) {}
 
 bool elob::order::cancel() {
 	if (m_queued) {
-		m_limit_it->second.erase(m_order_it);
-
-		if (m_limit_it->second.is_empty()) {
-			if (m_side == side::bid) {
-				m_book->m_bids.erase(m_limit_it);
-			} else {
-				m_book->m_asks.erase(m_limit_it);
-			}
-		}
-
+		book *const book_obj = m_book;
+		book_obj->begin_order_deferral();
+		const order_ptr self = dequeue();
 		m_book = nullptr;
+		book_obj->end_order_deferral();
 
 		return true;
 	}
@@ -219,8 +355,15 @@ bool elob::order::cancel() {
 	return false;
 }
 
+elob::order_ptr elob::order::dequeue() {
+	return m_side == side::bid ? m_book->dequeue<side::bid>(*this)
+				   : m_book->dequeue<side::ask>(*this);
+}
+
 void elob::order::set_all_or_nothing(const bool t_all_or_nothing) {
-	if (t_all_or_nothing == m_all_or_nothing) {
+	// iceberg and pegged orders cannot be all or nothing
+	if (t_all_or_nothing == m_all_or_nothing || is_iceberg() ||
+	    is_pegged()) {
 		return;
 	}
 
@@ -229,158 +372,139 @@ void elob::order::set_all_or_nothing(const bool t_all_or_nothing) {
 		return;
 	}
 
-	auto &limit_obj = m_limit_it->second;
-	auto &aon_order_its = limit_obj.m_aon_order_its;
+	auto &limit_obj = m_book->m_levels[m_level]->second;
+	limit_obj.unshare(m_book);
+	auto &orders = limit_obj.m_queue->m_orders;
+	auto &aon_orders = limit_obj.m_queue->m_aon_orders;
+	m_book->touch(m_side, m_price);
 
 	if (t_all_or_nothing) { // is queued and change from false to
 				// true
 		// to ensure price-TIME priority, one needs to find the
-		// orevious occurence in m_aon_order_its
-		limit_obj.m_aon_quantity += m_quantity;
-		limit_obj.m_quantity -= m_quantity;
-
-		auto order_it = m_order_it;
-		const auto first_order_it = m_limit_it->second.m_orders.begin();
-
-		while (order_it != first_order_it) {
-			--order_it;
-			if ((*order_it)->m_all_or_nothing) {
-				const auto insert_at_it =
-				    std::next((*order_it)->m_aon_order_its_it);
-				aon_order_its.insert(insert_at_it, m_order_it);
-				m_aon_order_its_it = insert_at_it;
-				return;
-			}
+		// previous occurence in m_aon_orders
+		if (!m_withdrawn) {
+			limit_obj.m_aon_quantity += m_quantity;
+			limit_obj.m_quantity -= m_quantity;
 		}
 
-		m_limit_it->second.m_aon_order_its.push_back(order_it);
-		m_aon_order_its_it =
-		    std::prev(m_limit_it->second.m_aon_order_its.end());
+		std::uint32_t insert_at = aon_orders.first();
+		std::uint32_t slot = orders.prev(m_order_slot);
+
+		for (; slot != no_slot; slot = orders.prev(slot)) {
+			if (orders[slot] && orders[slot]->m_all_or_nothing) {
+				insert_at =
+				    aon_orders.next(orders[slot]->m_aon_slot);
+				break;
+			}
+		}
 
+		m_aon_slot = aon_orders.insert(insert_at, m_order_slot);
 	} else { // is queued and change from true to false
-		limit_obj.m_aon_quantity -= m_quantity;
-		limit_obj.m_quantity += m_quantity;
-		aon_order_its.erase(m_aon_order_its_it);
+		if (!m_withdrawn) {
+			limit_obj.m_aon_quantity -= m_quantity;
+			limit_obj.m_quantity += m_quantity;
+		}
+
+		aon_orders.erase(m_aon_slot);
 	}
+
+	m_all_or_nothing = t_all_or_nothing;
+	limit_obj.update(this);
 }
 
-void elob::order::set_quantity(const double t_quantity) {
+bool elob::order::set_quantity(const double t_quantity) {
 	if (t_quantity <= 0) {
-		return;
+		return false;
 	}
 
 	if (!m_queued) {
 		m_quantity = t_quantity;
-		return;
+		return true;
 	}
 
-	// order is queued
-
-	if (m_all_or_nothing) {
+	// the book may release the order
+	const order_ptr order_obj = m_self;
 
-		m_limit_it->second.m_aon_quantity += t_quantity - m_quantity;
-		m_quantity = t_quantity;
-
-		if (m_side == side::bid &&
-		    m_book->bid_is_fillable(*m_order_it)) {
+	if (m_side == side::bid) {
+		return m_book->set_quantity<side::bid>(order_obj, t_quantity);
+	}
 
-			// attempt to execute itself against all orders
-			// todo remove itself from aon queue
-			m_book->begin_order_deferral();
-			m_book->execute_queued_bid(*m_order_it);
-			m_book->end_order_deferral();
-			m_limit_it->second.erase(m_order_it);
-			m_limit_it->second.m_aon_order_its.erase(
-			    m_aon_order_its_it);
+	return m_book->set_quantity<side::ask>(order_obj, t_quantity);
+}
 
-			if (m_limit_it->second.is_empty()) {
-				m_book->m_bids.erase(m_limit_it);
-			}
+std::uint64_t elob::order::get_expiry() const { return m_expiry; }
 
-			m_book = nullptr;
+void elob::order::set_expiry(const std::uint64_t t_expiry) {
+	m_expiry = t_expiry;
 
-			m_book->begin_order_deferral();
-			m_book->check_ask_aons(m_price);
-			m_book->end_order_deferral();
-		} else if (m_side == side::ask &&
-			   m_book->ask_is_fillable(*m_order_it)) {
+	if (m_queued) {
+		book *const book_obj = m_book;
+		const order_ptr self = m_self;
+		book_obj->begin_order_deferral();
+		book_obj->schedule_expiry(self);
+		book_obj->end_order_deferral();
+	}
+}
 
-			m_book->begin_order_deferral();
-			m_book->execute_queued_ask(*m_order_it);
-			m_book->end_order_deferral();
-			m_limit_it->second.erase(m_order_it);
-			m_limit_it->second.m_aon_order_its.erase(
-			    m_aon_order_its_it);
+elob::book *elob::order::get_book() const { return m_book; }
 
-			if (m_limit_it->second.is_empty()) {
-				m_book->m_asks.erase(m_limit_it);
-			}
+elob::side elob::order::get_side() const { return m_side; }
 
-			m_book = nullptr;
+double elob::order::get_price() const {
+	if (m_peg != no_peg && m_queued) {
+		return m_book->get_peg_price(m_side, m_peg, m_offset);
+	}
 
-			m_book->begin_order_deferral();
-			m_book->check_bid_aons(m_price);
-			m_book->end_order_deferral();
-		}
+	return m_price;
+}
 
-	} else { // good til canceled
-		m_limit_it->second.m_quantity += t_quantity - m_quantity;
-		m_quantity = t_quantity;
+double elob::order::get_quantity() const { return m_quantity; }
 
-		if (m_side == side::bid) {
-			m_book->begin_order_deferral();
-			m_book->execute_queued_bid(*m_order_it);
-			m_book->end_order_deferral();
+double elob::order::get_hidden_quantity() const { return m_hidden_quantity; }
 
-			if (m_quantity <= 0.0) {
-				m_limit_it->second.erase(m_order_it);
+bool elob::order::is_iceberg() const { return m_peak_quantity > 0.0; }
 
-				if (m_limit_it->second.is_empty()) {
-					m_book->m_bids.erase(m_limit_it);
-				}
+bool elob::order::is_pegged() const { return m_peg != no_peg; }
 
-				m_book = nullptr;
-			}
+bool elob::order::is_immediate_or_cancel() const {
+	return m_immediate_or_cancel;
+}
 
-			m_book->begin_order_deferral();
-			m_book->check_ask_aons(m_price);
-			m_book->end_order_deferral();
-		} else { // is ask
-			m_book->begin_order_deferral();
-			m_book->execute_queued_ask(*m_order_it);
-			m_book->end_order_deferral();
+bool elob::order::is_all_or_nothing() const { return m_all_or_nothing; }
 
-			if (m_quantity <= 0.0) {
-				m_limit_it->second.erase(m_order_it);
+std::uint64_t elob::order::get_owner() const { return m_owner; }
 
-				if (m_limit_it->second.is_empty()) {
-					m_book->m_asks.erase(m_limit_it);
-				}
+bool elob::order::set_owner(const std::uint64_t t_owner) {
+	if (!m_queued || t_owner == m_owner) {
+		m_owner = t_owner;
+		return true;
+	}
 
-				m_book = nullptr;
-			}
+	// the order is new to its owner
+	const double quantity = m_quantity + m_hidden_quantity;
 
-			m_book->begin_order_deferral();
-			m_book->check_bid_aons(m_price);
-			m_book->end_order_deferral();
-		}
+	if (t_owner != 0 &&
+	    !(m_side == side::bid
+		    ? m_book->is_within_limits<side::bid>(
+			  t_owner, *this, m_price, quantity, false)
+		    : m_book->is_within_limits<side::ask>(
+			  t_owner, *this, m_price, quantity, false))) {
+		return false;
 	}
-}
-
-elob::book *elob::order::get_book() const { return m_book; }
 
-elob::side elob::order::get_side() const { return m_side; }
+	if (m_owner != 0) {
+		m_book->unindex(*this);
+	}
 
-double elob::order::get_price() const { return m_price; }
+	m_owner = t_owner;
 
-double elob::order::get_quantity() const { return m_quantity; }
+	if (m_owner != 0) {
+		m_book->index(*this);
+	}
 
-bool elob::order::is_immediate_or_cancel() const {
-	return m_immediate_or_cancel;
+	return true;
 }
 
-bool elob::order::is_all_or_nothing() const { return m_all_or_nothing; }
-
 bool elob::order::is_queued() const { return m_queued; }
 
 #endif // #ifndef ORDER_HPP
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef ORDER_GROUP_HPP
+#define ORDER_GROUP_HPP
+#include "insertable.hpp"
+#include <vector>
+
+namespace elob {
+
+/**
+ * \internal
+ * @brief Orders and triggers that cancel each other, see
+ * book::insert_oco and book::insert_bracket. The members refer to
+ * their group by a 32 bit handle into the groups of their book.
+ *
+ */
+struct order_group {
+	// the legs that cancel each other or the entry of a bracket
+	std::vector<insertable> m_legs;
+
+	// the exits of a bracket, inserted once its entry has traded
+	std::vector<insertable> m_exits;
+
+	/* set once a leg has traded or fired. The other legs are
+		withdrawn from their levels and are canceled once the
+		operation has completed. */
+	bool m_fired = false;
+};
+
+} // namespace elob
+
+#endif // #ifndef ORDER_GROUP_HPP
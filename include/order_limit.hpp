@@ -1,36 +1,168 @@
 #ifndef ORDER_LIMIT_HPP
 #define ORDER_LIMIT_HPP
-#include <list>
+#include "common.hpp"
+#include "slot_list.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <vector>
 
 namespace elob {
 
 class order;
 class book;
+class order_limit;
+
+/**
+ * \internal
+ * @brief The resting quantities of a queue in contiguous arrays so that
+ * fillability can be checked without loading the orders. Each order
+ * holds its slot. Removed orders leave an empty slot behind until more
+ * than half of the slots are empty and the arrays are compacted.
+ *
+ */
+struct quantity_index {
+	// displayed quantity, 0 for empty slots
+	std::vector<double> m_quantities;
+	std::vector<unsigned char> m_all_or_nothing;
+	// nullptr for empty slots
+	std::vector<order *> m_orders;
+	std::size_t m_removed = 0;
+
+	inline void push_back(order *t_order);
+	inline void update(const order *t_order);
+	inline void remove(const order *t_order);
+
+	/**
+	 * @brief Same as order_limit::simulate_trade without the hidden
+	 * quantity, which trades behind all orders. The quantities are
+	 * summed in blocks and only a block that cannot be consumed as a
+	 * whole is scanned order by order.
+	 *
+	 */
+	inline double simulate_trade(const double t_quantity) const;
+
+	/**
+	 * \internal
+	 * @brief Sum the four quantities starting at t_quantities.
+	 *
+	 */
+	static inline double block_sum(const double *t_quantities);
+};
+
+/**
+ * \internal
+ * @brief The orders queued at a price level. Forked books share the
+ * queues of their parent until either of them modifies a level.
+ *
+ */
+struct order_queue {
+	~order_queue();
+
+	/* the book whose orders are stored in this queue. nullptr if
+		the queue holds copies left behind for forks. */
+	book *m_owner = nullptr;
 
-class order_limit {
-	private:
-	double m_quantity = 0.0;
-	double m_aon_quantity = 0.0;
 	/* orders are stored in a doubly-linked list to
-		allow for O(1) cancellation.*/
-	std::list<order_ptr> m_orders;
+		allow for O(1) cancellation. Each order holds its slot.*/
+	slot_list<order *> m_orders;
+
+	/* lazily canceled orders leave a nullptr behind in m_orders.
+		They are unlinked when a trade passes over them or the
+		level is compacted. */
+	std::size_t m_dead = 0;
 
-	/* The field m_aon_order_its stores
-	 * iterators to the all-or-nothing orders in m_orders so that
+	/* The field m_aon_orders stores
+	 * the slots of the all-or-nothing orders in m_orders so that
 	 * they can be quickly looked up. This is neccessary because
 	 * updating order quantities may render some all-or-nothing
 	 * orders executable. When all-or-nothing orders are executed or
-	 * canceled, their iterators must be deleted from this list.
+	 * canceled, their slots must be deleted from this list.
+	 */
+	slot_list<std::uint32_t> m_aon_orders;
+
+	/* built once the queue becomes deep while it is modified and
+		kept up to date with it afterwards. */
+	std::unique_ptr<quantity_index> m_index;
+};
+
+class order_limit {
+	private:
+	double m_quantity = 0.0;
+	double m_aon_quantity = 0.0;
+	double m_hidden_quantity = 0.0;
+	std::shared_ptr<order_queue> m_queue;
+
+	// the handle by which the orders of the level refer to it
+	std::uint32_t m_handle = 0;
+
+	// queues shorter than this are walked without an index
+	static constexpr std::size_t index_threshold = 16;
+
+	/**
+	 * \internal
+	 * @brief Make sure the queue is owned exclusively by t_book
+	 * before it is modified. If the queue is shared with a fork
+	 * and holds t_book's orders, the orders are moved to a new
+	 * queue and copies are left behind. If it holds another book's
+	 * orders, t_book continues with copies of them.
+	 *
+	 * @param t_book the book about to modify the level
+	 */
+	void unshare(book *t_book);
+
+	/**
+	 * \internal
+	 * @brief Fill t_to with plain copies of the orders in t_from. The
+	 * copies are queued in t_book at the level with handle t_level,
+	 * or detached if t_book is nullptr.
+	 *
 	 */
-	std::list<std::list<order_ptr>::iterator> m_aon_order_its;
+	static void copy_orders(const order_queue &t_from, order_queue &t_to,
+	    book *t_book, const std::uint32_t t_level);
 
-	std::list<elob::order_ptr>::iterator insert(c_order_ptr &t_order);
+	/**
+	 * \internal
+	 * @brief Detach the orders of t_book from this level when t_book
+	 * is destroyed.
+	 *
+	 */
+	void release(const book *t_book);
+
+	/**
+	 * \internal
+	 * @brief Reset an erased level for reuse at another price. The
+	 * queue is kept if t_book owns it exclusively and it is empty.
+	 *
+	 */
+	void recycle(const book *t_book);
+
+	/**
+	 * \internal
+	 * @brief Unlink the entries of lazily canceled orders. O(n).
+	 *
+	 */
+	void compact();
+
+	/**
+	 * \internal
+	 * @brief Build the index of the queue once it holds
+	 * index_threshold orders. The queue must be owned by the book
+	 * modifying the level.
+	 *
+	 */
+	void build_index();
+
+	std::uint32_t insert(c_order_ptr &t_order);
 
 	/**
 	 * @brief Simulates the execution of an order with t_quantity
 	 * and returns the amount of quantity remaining. This function
-	 * is used to test if all-or-nothing orders are fillable.
+	 * is used to test if all-or-nothing orders are fillable. Like
+	 * trade, it takes the hidden quantity of iceberg orders only once
+	 * their slices have been traded, i.e. behind all other orders.
 	 *
 	 * @param t_quantity the amount of quantity to be traded.
 	 * @return the amount of quantity remaining.
@@ -41,13 +173,171 @@ class order_limit {
 	 * @brief Execute an inbound order.
 	 *
 	 * @param t_order, the inbound order
+	 * @param t_price, the price of the level. Pegged orders store
+	 * it as the price at which they traded.
+	 * @return the traded quantity.
+	 */
+	double trade(elob::c_order_ptr &t_order, const double t_price);
+
+	/**
+	 * \internal
+	 * @brief Allocate an inbound order among the partially fillable
+	 * orders in proportion to their displayed quantity, in a single
+	 * pass over the queue. The running share is rounded up to whole
+	 * lots, so rounding favours older orders. With TopPriority the
+	 * oldest of these orders is filled first and the rest is
+	 * allocated among the others. Quantity left over, e.g. because
+	 * an order's share exceeded its quantity, is left for trade.
+	 *
+	 * @param t_order the inbound order. Its quantity must be less
+	 * than the displayed quantity of the level.
+	 * @param t_price the price of the level
+	 * @param t_lot_size the unit in which quantity is allocated
 	 * @return the traded quantity.
 	 */
-	double trade(elob::c_order_ptr &t_order);
-	inline bool is_empty() const { return m_orders.empty(); }
-	void erase(const std::list<order_ptr>::iterator &t_order_it);
+	template <bool TopPriority>
+	double trade_pro_rata(elob::c_order_ptr &t_order, const double t_price,
+	    const double t_lot_size);
+
+	/**
+	 * \internal
+	 * @brief Account for a trade between a queued order and t_order
+	 * in the risk of their owners. Does nothing for orders without
+	 * an owner.
+	 *
+	 */
+	static inline void account(const order &t_queued,
+	    const order &t_order, const double t_quantity,
+	    const double t_price);
+
+	/**
+	 * \internal
+	 * @brief Trade t_quantity of the queued order at t_slot
+	 * against t_order. Iceberg orders whose slice is used up are
+	 * replenished behind the other orders of the level.
+	 *
+	 */
+	void fill(const std::uint32_t t_slot, elob::c_order_ptr &t_order,
+	    const double t_quantity, const double t_price);
+	inline bool is_empty() const {
+		return !m_queue || m_queue->m_orders.size() == m_queue->m_dead;
+	}
+
+	/**
+	 * \internal
+	 * @brief Remove an order from the level.
+	 *
+	 * @param t_slot the slot of the order
+	 * @param t_lazy leave the entry of the order in the queue as a
+	 * nullptr instead of unlinking it. The totals of the level are
+	 * updated either way. All-or-nothing orders are always unlinked.
+	 * @return order_ptr the reference that kept the order alive
+	 * while it was queued. Hold on to it while the order is still
+	 * being accessed.
+	 */
+	order_ptr erase(const std::uint32_t t_slot, const bool t_lazy = false);
+
+	/**
+	 * \internal
+	 * @brief Take the quantity of a queued order out of the totals
+	 * and the index of the level without unlinking it, e.g. when its
+	 * group fires while the level may be in use. The order is
+	 * skipped by matching until it is erased.
+	 *
+	 */
+	void withdraw(order *t_order);
+
+	/**
+	 * \internal
+	 * @brief Move an order behind all other orders of the level,
+	 * e.g. when it loses time priority.
+	 *
+	 * @param t_slot the slot of the order
+	 */
+	void requeue(const std::uint32_t t_slot);
+
+	/**
+	 * \internal
+	 * @brief Propagate a change to the quantity or the all-or-nothing
+	 * flag of a queued order to the index of the level, if any.
+	 *
+	 */
+	inline void update(const order *t_order);
+
+	/**
+	 * \internal
+	 * @brief Get the queue of the level. The entries of lazily
+	 * canceled orders are unlinked first.
+	 *
+	 */
+	inline slot_list<order *> &orders();
+
+	/**
+	 * \internal
+	 * @brief Take a reference to a queued order that trades against
+	 * t_order if the event methods of either order may release it.
+	 * Only derived orders have event methods, so the reference is
+	 * empty for plain orders and their reference counts are left
+	 * alone.
+	 *
+	 */
+	static inline order_ptr hold(
+	    const order &t_queued, const order &t_order);
 
 	public:
+	/**
+	 * @brief Iterates over the orders of the level in time priority.
+	 * The level stores plain pointers, the iterator yields the
+	 * reference that keeps each order queued.
+	 *
+	 */
+	class iterator {
+		private:
+		slot_list<order *>::iterator m_order_it;
+
+		public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = order_ptr;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const order_ptr *;
+		using reference = const order_ptr &;
+
+		iterator() = default;
+
+		explicit iterator(
+		    const slot_list<order *>::iterator &t_order_it)
+		    : m_order_it(t_order_it) {}
+
+		inline reference operator*() const;
+		inline pointer operator->() const;
+
+		iterator &operator++() {
+			++m_order_it;
+			return *this;
+		}
+
+		iterator operator++(int) {
+			return iterator(m_order_it++);
+		}
+
+		iterator &operator--() {
+			--m_order_it;
+			return *this;
+		}
+
+		iterator operator--(int) {
+			return iterator(m_order_it--);
+		}
+
+		bool operator==(const iterator &t_other) const {
+			return m_order_it == t_other.m_order_it;
+		}
+
+		bool operator!=(const iterator &t_other) const {
+			return m_order_it != t_other.m_order_it;
+		}
+	};
+
 	/**
 	 * @brief Get the non-all-or-none quantity at this price level.
 	 * This quantity can be filled partially.
@@ -63,6 +353,14 @@ class order_limit {
 	 */
 	inline double get_aon_quantity() const;
 
+	/**
+	 * @brief Get the quantity held back by iceberg orders at this
+	 * price level. It is not included in get_quantity.
+	 *
+	 * @return the hidden quantity at this price level.
+	 */
+	inline double get_hidden_quantity() const;
+
 	/**
 	 * @brief Get the total number of orders (all-or-nothing
 	 * included) at this price level.
@@ -73,20 +371,21 @@ class order_limit {
 	inline std::size_t get_order_count() const;
 
 	/**
-	 * @brief Get an iterator to the first order in the queue.
+	 * @brief Get an iterator to the first order in the queue. The
+	 * entries of lazily canceled orders are unlinked first.
 	 *
-	 * @return std::list<elob::order_ptr>::iterator, iterator
-	 * to first order in the queue.
+	 * @return order_limit::iterator, iterator to first order in the
+	 * queue.
 	 */
-	inline std::list<order_ptr>::iterator begin();
+	inline iterator begin();
 
 	/**
 	 * @brief Get an iterator to the end of the order queue.
 	 *
-	 * @return std::list<elob::order_ptr>::iterator, iterator
-	 * to the end of the order queue.
+	 * @return order_limit::iterator, iterator to the end of the order
+	 * queue.
 	 */
-	inline std::list<order_ptr>::iterator end();
+	inline iterator end();
 
 	/**
 	 * @brief Get the number of orders (including all-or-nothing) at
@@ -108,141 +407,728 @@ class order_limit {
 
 	friend book;
 	friend order;
-
-	~order_limit();
 };
 
 } // namespace elob
 
 #include "order.hpp"
 #include <algorithm>
+#include <cmath>
+#include <typeinfo>
 
-std::list<elob::order_ptr>::iterator elob::order_limit::insert(
-    elob::c_order_ptr &t_order) {
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void elob::quantity_index::push_back(elob::order *const t_order) {
+	t_order->m_slot = m_orders.size();
+	m_quantities.push_back(t_order->m_quantity);
+	m_all_or_nothing.push_back(t_order->m_all_or_nothing);
 	m_orders.push_back(t_order);
-	const auto order_it = std::prev(m_orders.end());
+}
+
+void elob::quantity_index::update(const elob::order *const t_order) {
+	// the order's event methods may have removed it already
+	const std::size_t slot = t_order->m_slot;
+
+	if (slot >= m_orders.size() || m_orders[slot] != t_order) {
+		return;
+	}
+
+	m_quantities[slot] = t_order->m_quantity;
+	m_all_or_nothing[slot] = t_order->m_all_or_nothing;
+}
+
+void elob::quantity_index::remove(const elob::order *const t_order) {
+	const std::size_t slot = t_order->m_slot;
+
+	if (slot >= m_orders.size() || m_orders[slot] != t_order) {
+		return;
+	}
+
+	// empty slots are consumed by any quantity
+	m_quantities[slot] = 0.0;
+	m_all_or_nothing[slot] = false;
+	m_orders[slot] = nullptr;
+
+	if (++m_removed <= m_orders.size() / 2) {
+		return;
+	}
+
+	std::size_t size = 0;
+
+	for (std::size_t from = 0; from < m_orders.size(); ++from) {
+		if (m_orders[from] != nullptr) {
+			m_quantities[size] = m_quantities[from];
+			m_all_or_nothing[size] = m_all_or_nothing[from];
+			m_orders[size] = m_orders[from];
+			m_orders[size]->m_slot = size;
+			++size;
+		}
+	}
+
+	m_quantities.resize(size);
+	m_all_or_nothing.resize(size);
+	m_orders.resize(size);
+	m_removed = 0;
+}
+
+double elob::quantity_index::block_sum(const double *const t_quantities) {
+#if defined(__AVX__)
+	const __m256d quantities = _mm256_loadu_pd(t_quantities);
+	const __m128d pairs = _mm_add_pd(_mm256_castpd256_pd128(quantities),
+	    _mm256_extractf128_pd(quantities, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+#elif defined(__SSE2__)
+	const __m128d pairs = _mm_add_pd(
+	    _mm_loadu_pd(t_quantities), _mm_loadu_pd(t_quantities + 2));
+	return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+#else
+	return (t_quantities[0] + t_quantities[1]) +
+	       (t_quantities[2] + t_quantities[3]);
+#endif
+}
+
+double elob::quantity_index::simulate_trade(const double t_quantity) const {
+	const double *const quantities = m_quantities.data();
+	const std::size_t size = m_quantities.size();
+	double quantity_remaining = t_quantity;
+	std::size_t slot = 0;
+
+	while (slot < size) {
+		// skip blocks of orders that are filled completely
+		while (slot + 4 <= size) {
+			const double quantity = block_sum(quantities + slot);
+
+			if (quantity > quantity_remaining) {
+				break;
+			}
+
+			quantity_remaining -= quantity;
+			slot += 4;
+		}
+
+		// the fill boundary lies within the next block
+		const std::size_t block_end = std::min(slot + 4, size);
+
+		for (; slot < block_end; ++slot) {
+			if (quantity_remaining >= quantities[slot]) {
+				quantity_remaining -= quantities[slot];
+			} else if (!m_all_or_nothing[slot]) {
+				return 0.0; // consume non-AON order partially
+			}
+		}
+	}
+
+	return quantity_remaining;
+}
+
+elob::order_queue::~order_queue() {
+	// release the copies that only this queue refers to
+	for (const auto order : m_orders) {
+		if (order) {
+			order->m_self.reset();
+		}
+	}
+}
+
+void elob::order_limit::copy_orders(const elob::order_queue &t_from,
+    elob::order_queue &t_to, elob::book *t_book, const std::uint32_t t_level) {
+	for (const auto order_obj : t_from.m_orders) {
+		// withdrawn orders are not part of the totals being copied
+		if (!order_obj || order_obj->m_withdrawn) {
+			continue;
+		}
+
+		auto copy = std::make_shared<order>(
+		    static_cast<const order &>(*order_obj));
+		copy->m_book = t_book;
+		copy->m_queued = t_book != nullptr;
+		copy->m_group = 0;
+		copy->m_prev_owned = nullptr;
+		copy->m_next_owned = nullptr;
+		copy->m_level = t_level;
+		copy->m_order_slot = t_to.m_orders.push_back(copy.get());
+
+		if (copy->m_all_or_nothing) {
+			copy->m_aon_slot =
+			    t_to.m_aon_orders.push_back(copy->m_order_slot);
+		}
+
+		// the orders are already accounted for in the book
+		if (t_book && copy->m_owner != 0) {
+			t_book->link(*copy);
+		}
+
+		copy->m_self = std::move(copy);
+	}
+}
+
+void elob::order_limit::unshare(elob::book *t_book) {
+	if (!m_queue) {
+		m_queue = std::make_shared<order_queue>();
+		m_queue->m_owner = t_book;
+		return;
+	}
+
+	if (m_queue.use_count() == 1) {
+		if (m_queue->m_owner == t_book) {
+			return;
+		}
+
+		// copies no other book refers to can be adopted
+		if (m_queue->m_owner == nullptr) {
+			m_queue->m_owner = t_book;
+
+			for (auto &order_obj : m_queue->m_orders) {
+				order_obj->m_book = t_book;
+				order_obj->m_queued = true;
+				order_obj->m_level = m_handle;
+
+				if (order_obj->m_owner != 0) {
+					t_book->link(*order_obj);
+				}
+			}
+
+			build_index();
+			return;
+		}
+	}
+
+	auto queue = std::make_shared<order_queue>();
+	queue->m_owner = t_book;
+
+	if (m_queue->m_owner == t_book) {
+		// moving the lists keeps the slots stored in the orders valid
+		std::swap(queue->m_orders, m_queue->m_orders);
+		std::swap(queue->m_aon_orders, m_queue->m_aon_orders);
+		queue->m_index = std::move(m_queue->m_index);
+		queue->m_dead = m_queue->m_dead;
+		m_queue->m_dead = 0;
+		m_queue->m_owner = nullptr;
+		copy_orders(*queue, *m_queue, nullptr, m_handle);
+	} else {
+		copy_orders(*m_queue, *queue, t_book, m_handle);
+	}
+
+	m_queue = std::move(queue);
+	build_index();
+}
+
+void elob::order_limit::release(const elob::book *t_book) {
+	if (!m_queue || m_queue->m_owner != t_book) {
+		return;
+	}
+
+	compact();
+	order_queue released;
+	std::swap(released.m_orders, m_queue->m_orders);
+	m_queue->m_aon_orders.clear();
+	m_queue->m_index.reset();
+	m_queue->m_owner = nullptr;
+
+	// forks sharing the level keep copies of the orders
+	if (m_queue.use_count() > 1) {
+		copy_orders(released, *m_queue, nullptr, m_handle);
+	}
+
+	for (const auto order : released.m_orders) {
+		order->m_book = nullptr;
+		order->m_queued = false;
+		order->m_self.reset();
+	}
+
+	released.m_orders.clear();
+}
+
+void elob::order_limit::recycle(const elob::book *t_book) {
+	m_quantity = 0.0;
+	m_aon_quantity = 0.0;
+	m_hidden_quantity = 0.0;
+
+	if (!m_queue) {
+		return;
+	}
+
+	if (m_queue.use_count() == 1 && m_queue->m_owner == t_book &&
+	    is_empty()) {
+		m_queue->m_orders.clear();
+		m_queue->m_aon_orders.clear();
+		m_queue->m_dead = 0;
+		m_queue->m_index.reset();
+	} else {
+		m_queue.reset();
+	}
+}
+
+void elob::order_limit::compact() {
+	if (!m_queue || m_queue->m_dead == 0) {
+		return;
+	}
+
+	m_queue->m_orders.remove(nullptr);
+	m_queue->m_dead = 0;
+}
+
+void elob::order_limit::build_index() {
+	const auto &orders = m_queue->m_orders;
+
+	if (m_queue->m_index ||
+	    orders.size() - m_queue->m_dead < index_threshold) {
+		return;
+	}
+
+	m_queue->m_index = std::make_unique<quantity_index>();
+
+	for (const auto order_obj : orders) {
+		if (order_obj) {
+			m_queue->m_index->push_back(order_obj);
+		}
+	}
+}
+
+std::uint32_t elob::order_limit::insert(elob::c_order_ptr &t_order) {
+	const std::uint32_t slot = m_queue->m_orders.push_back(t_order.get());
+	t_order->m_self = t_order;
 
 	if (t_order->m_all_or_nothing) {
 		m_aon_quantity += t_order->m_quantity;
-		m_aon_order_its.push_back(order_it);
-		t_order->m_aon_order_its_it = std::prev(m_aon_order_its.end());
+		t_order->m_aon_slot = m_queue->m_aon_orders.push_back(slot);
 	} else {
+		// only the peak of an iceberg order is displayed
+		if (t_order->is_iceberg() &&
+		    t_order->m_quantity > t_order->m_peak_quantity) {
+			t_order->m_hidden_quantity +=
+			    t_order->m_quantity - t_order->m_peak_quantity;
+			t_order->m_quantity = t_order->m_peak_quantity;
+		}
+
 		m_quantity += t_order->m_quantity;
+		m_hidden_quantity += t_order->m_hidden_quantity;
+	}
+
+	if (m_queue->m_index) {
+		m_queue->m_index->push_back(t_order.get());
+	} else {
+		build_index();
 	}
 
-	return order_it;
+	return slot;
 }
 
-void elob::order_limit::erase(
-    const std::list<elob::order_ptr>::iterator &t_order_it) {
-	auto &order_obj = *t_order_it;
+elob::order_ptr elob::order_limit::erase(
+    const std::uint32_t t_slot, const bool t_lazy) {
+	elob::order *const order_obj = m_queue->m_orders[t_slot];
 
 	if (order_obj->m_all_or_nothing) {
-		m_aon_order_its.erase(order_obj->m_aon_order_its_it);
+		m_queue->m_aon_orders.erase(order_obj->m_aon_slot);
+	}
+
+	if (order_obj->m_withdrawn) {
+		order_obj->m_withdrawn = false;
+	} else if (order_obj->m_all_or_nothing) {
 		// avoid floating point issues
 		m_aon_quantity -= order_obj->m_quantity;
 	} else {
 		// avoid floating point issues
 		m_quantity -= order_obj->m_quantity;
+		m_hidden_quantity -= order_obj->m_hidden_quantity;
+	}
+
+	if (m_queue->m_index) {
+		m_queue->m_index->remove(order_obj);
+	}
+
+	if (order_obj->m_owner != 0) {
+		order_obj->m_book->unindex(*order_obj);
 	}
 
 	order_obj->m_queued = false;
-	m_orders.erase(t_order_it);
+
+	if (!t_lazy || order_obj->m_all_or_nothing) {
+		m_queue->m_orders.erase(t_slot);
+	} else {
+		m_queue->m_orders[t_slot] = nullptr;
+
+		// compact once the dead entries outnumber the orders
+		if (++m_queue->m_dead > m_queue->m_orders.size() / 2) {
+			compact();
+		}
+	}
+
+	return std::move(order_obj->m_self);
+}
+
+void elob::order_limit::requeue(const std::uint32_t t_slot) {
+	// moving keeps the slots stored in the order valid
+	elob::order *const order_obj = m_queue->m_orders[t_slot];
+	m_queue->m_orders.move_back(t_slot);
+
+	if (order_obj->m_all_or_nothing) {
+		m_queue->m_aon_orders.move_back(order_obj->m_aon_slot);
+	}
+
+	if (m_queue->m_index && !order_obj->m_withdrawn) {
+		m_queue->m_index->remove(order_obj);
+		m_queue->m_index->push_back(order_obj);
+	}
+}
+
+void elob::order_limit::withdraw(elob::order *const t_order) {
+	if (t_order->m_all_or_nothing) {
+		m_aon_quantity -= t_order->m_quantity;
+	} else {
+		m_quantity -= t_order->m_quantity;
+		m_hidden_quantity -= t_order->m_hidden_quantity;
+	}
+
+	if (m_queue->m_index) {
+		m_queue->m_index->remove(t_order);
+	}
+
+	t_order->m_withdrawn = true;
+}
+
+void elob::order_limit::update(const elob::order *const t_order) {
+	if (m_queue && m_queue->m_index) {
+		m_queue->m_index->update(t_order);
+	}
 }
 
 double elob::order_limit::simulate_trade(const double t_quantity) const {
 
 	// quick check if the order has a greater quantity than the entire limit
-	const double total_quantity = m_quantity + m_aon_quantity;
+	const double total_quantity =
+	    m_quantity + m_hidden_quantity + m_aon_quantity;
 
 	if (t_quantity >= total_quantity) {
 		return t_quantity - total_quantity;
 	}
 
-	// walk through the orders one by one
 	double quantity_remaining = t_quantity;
-	auto order_it = m_orders.begin();
 
-	for (const auto &order_obj : m_orders) {
-		const double order_quantity = order_obj->m_quantity;
+	if (m_queue->m_index) {
+		quantity_remaining =
+		    m_queue->m_index->simulate_trade(t_quantity);
+	} else {
+		// walk through the orders one by one
+		for (const auto order_obj : m_queue->m_orders) {
+			if (!order_obj || order_obj->m_withdrawn) {
+				continue;
+			}
 
-		if (quantity_remaining >= order_quantity) {
-			quantity_remaining -= order_quantity;
-			++order_it;
-		} else if (!order_obj->m_all_or_nothing) {
-			return 0.0; // consume non-AON order partially
+			const double order_quantity = order_obj->m_quantity;
+
+			if (quantity_remaining >= order_quantity) {
+				quantity_remaining -= order_quantity;
+			} else if (!order_obj->m_all_or_nothing) {
+				return 0.0; // consume non-AON order partially
+			}
 		}
 	}
 
-	return quantity_remaining;
+	// every slice has been traded, the replenished ones follow all
+	// other orders and can be traded partially
+	return std::max(quantity_remaining - m_hidden_quantity, 0.0);
 }
 
-double elob::order_limit::trade(elob::c_order_ptr &t_order) {
+double elob::order_limit::trade(
+    elob::c_order_ptr &t_order, const double t_price) {
 	double traded_quantity = 0.0;
 	double quantity_remaining = t_order->m_quantity;
-	auto queued_order_it = m_orders.begin();
+	auto &orders = m_queue->m_orders;
+	std::uint32_t queued_slot = orders.first();
+
+	while (queued_slot != no_slot) {
+		elob::order *const queued_order = orders[queued_slot];
+
+		// unlink the entries of lazily canceled orders on the way
+		if (!queued_order) {
+			const std::uint32_t next_slot =
+			    orders.next(queued_slot);
+			orders.erase(queued_slot);
+			--m_queue->m_dead;
+			queued_slot = next_slot;
+			continue;
+		}
+
+		// the other legs of a fired group are about to be canceled
+		if (queued_order->m_withdrawn) {
+			queued_slot = orders.next(queued_slot);
+			continue;
+		}
 
-	while (queued_order_it != m_orders.end()) {
-		const auto queued_order = (*queued_order_it);
 		const double queued_order_quantity = queued_order->m_quantity;
 
-		if (quantity_remaining >= queued_order_quantity) {
+		if (queued_order->m_peg != no_peg) {
+			queued_order->m_price = t_price;
+		}
+
+		// AON orders are skipped below unless they can be filled
+		if (queued_order->m_group != 0 &&
+		    (quantity_remaining >= queued_order_quantity ||
+			!queued_order->m_all_or_nothing)) {
+			queued_order->m_book->fire_group(queued_order->m_group);
+		}
+
+		if (quantity_remaining >= queued_order_quantity &&
+		    queued_order->m_hidden_quantity > 0.0) {
+			// replenish the iceberg order and move the new
+			// slice behind the other orders of the level
+			const order_ptr held = hold(*queued_order, *t_order);
+			c_order_ptr &iceberg_order =
+			    held ? held : queued_order->m_self;
+			const std::uint32_t next_slot =
+			    orders.next(queued_slot);
+			const double slice =
+			    std::min(queued_order->m_peak_quantity,
+				queued_order->m_hidden_quantity);
+			traded_quantity += queued_order_quantity;
+			quantity_remaining -= queued_order_quantity;
+			t_order->m_quantity = quantity_remaining;
+			queued_order->m_quantity = slice;
+			queued_order->m_hidden_quantity -= slice;
+			m_quantity += slice - queued_order_quantity;
+			m_hidden_quantity -= slice;
+			requeue(queued_slot);
+			account(*queued_order, *t_order, queued_order_quantity,
+			    t_price);
+
+			// the new slice may trade against the same order
+			if (next_slot != no_slot) {
+				queued_slot = next_slot;
+			}
+
+			queued_order->on_traded(t_order);
+			t_order->on_traded(iceberg_order);
+
+			if (quantity_remaining <= 0.0) {
+				break;
+			}
+		} else if (quantity_remaining >= queued_order_quantity) {
 			// incoming order has more or equal quantity
-			erase(queued_order_it++);
+			const std::uint32_t next_slot =
+			    orders.next(queued_slot);
+			const order_ptr filled_order = erase(queued_slot);
+			queued_slot = next_slot;
 			traded_quantity += queued_order_quantity;
 			quantity_remaining -= queued_order_quantity;
 			t_order->m_quantity = quantity_remaining;
 			queued_order->m_quantity = 0.0;
+			account(*queued_order, *t_order, queued_order_quantity,
+			    t_price);
 			queued_order->on_traded(t_order); // todo
-			t_order->on_traded(queued_order); // todo
+			t_order->on_traded(filled_order); // todo
 			queued_order->m_book = nullptr;
 		} else if (!queued_order->m_all_or_nothing) {
 			/// consume non-AON order partially
+			// the order stays queued but the event methods may
+			// cancel it
+			const order_ptr held = hold(*queued_order, *t_order);
+			c_order_ptr &partial_order =
+			    held ? held : queued_order->m_self;
 			traded_quantity += quantity_remaining;
 			queued_order->m_quantity -= quantity_remaining;
 			m_quantity -= quantity_remaining;
+			update(queued_order);
+			account(*queued_order, *t_order, quantity_remaining,
+			    t_price);
 			quantity_remaining = 0.0;
 			t_order->m_quantity = quantity_remaining;
 			queued_order->on_traded(t_order); // todo
-			t_order->on_traded(queued_order); // todo
+			t_order->on_traded(partial_order); // todo
 			break; // avoid quantity_remaining > 0.0 check in while
 			       // loop
 		} else {
 			// cannot fill AON orders partially
-			++queued_order_it;
+			queued_slot = orders.next(queued_slot);
 		}
 	}
 
 	return traded_quantity;
 }
 
+template <bool TopPriority>
+double elob::order_limit::trade_pro_rata(elob::c_order_ptr &t_order,
+    const double t_price, const double t_lot_size) {
+	const double quantity = t_order->m_quantity;
+	auto &orders = m_queue->m_orders;
+	std::uint32_t queued_slot = orders.first();
+
+	// replenished icebergs move behind the orders still to visit
+	std::size_t orders_remaining = orders.size();
+	bool top_order = TopPriority;
+	double allocation = quantity;
+	double total_quantity = m_quantity;
+	double passed_quantity = 0.0;
+	double allocated_quantity = 0.0;
+
+	while (orders_remaining-- > 0 && t_order->m_quantity > 0.0) {
+		const std::uint32_t next_slot = orders.next(queued_slot);
+		elob::order *const queued_order = orders[queued_slot];
+
+		if (!queued_order) {
+			orders.erase(queued_slot);
+			--m_queue->m_dead;
+			queued_slot = next_slot;
+			continue;
+		}
+
+		const double queued_order_quantity = queued_order->m_quantity;
+		double fill_quantity = 0.0;
+
+		// cannot fill AON orders partially
+		if (queued_order->m_all_or_nothing ||
+		    queued_order->m_withdrawn) {
+			queued_slot = next_slot;
+			continue;
+		}
+
+		if (top_order) {
+			top_order = false;
+			fill_quantity = std::min(
+			    queued_order_quantity, t_order->m_quantity);
+			allocation -= fill_quantity;
+			total_quantity -= queued_order_quantity;
+		} else {
+			passed_quantity += queued_order_quantity;
+			const double share =
+			    std::ceil(allocation * passed_quantity /
+				      total_quantity / t_lot_size) *
+			    t_lot_size;
+			fill_quantity = std::min({share - allocated_quantity,
+			    queued_order_quantity, t_order->m_quantity});
+			allocated_quantity += fill_quantity;
+		}
+
+		if (fill_quantity > 0.0) {
+			fill(queued_slot, t_order, fill_quantity, t_price);
+		}
+
+		queued_slot = next_slot;
+	}
+
+	return quantity - t_order->m_quantity;
+}
+
+void elob::order_limit::account(const elob::order &t_queued,
+    const elob::order &t_order, const double t_quantity,
+    const double t_price) {
+	// a single branch for orders without an owner
+	if ((t_queued.m_owner | t_order.m_owner) == 0) {
+		return;
+	}
+
+	if (t_queued.m_owner != 0) {
+		t_queued.m_book->fill_owned(t_queued, t_quantity, t_price);
+	}
+
+	if (t_order.m_owner != 0) {
+		t_queued.m_book->fill_owned(t_order, t_quantity, t_price);
+	}
+}
+
+void elob::order_limit::fill(const std::uint32_t t_slot,
+    elob::c_order_ptr &t_order, const double t_quantity,
+    const double t_price) {
+	elob::order *const queued_order = m_queue->m_orders[t_slot];
+	const bool filled = t_quantity >= queued_order->m_quantity &&
+			    queued_order->m_hidden_quantity <= 0.0;
+	t_order->m_quantity -= t_quantity;
+
+	if (queued_order->m_peg != no_peg) {
+		queued_order->m_price = t_price;
+	}
+
+	if (queued_order->m_group != 0) {
+		queued_order->m_book->fire_group(queued_order->m_group);
+	}
+
+	// erase hands back the reference of a filled order, the event
+	// methods may release one that stays queued
+	const order_ptr held =
+	    filled ? erase(t_slot) : hold(*queued_order, *t_order);
+	c_order_ptr &traded_order = held ? held : queued_order->m_self;
+
+	if (filled) {
+		queued_order->m_quantity = 0.0;
+	} else if (t_quantity >= queued_order->m_quantity) {
+		// replenish the iceberg order
+		const double slice = std::min(queued_order->m_peak_quantity,
+		    queued_order->m_hidden_quantity);
+		m_quantity += slice - queued_order->m_quantity;
+		m_hidden_quantity -= slice;
+		queued_order->m_quantity = slice;
+		queued_order->m_hidden_quantity -= slice;
+		requeue(t_slot);
+	} else {
+		queued_order->m_quantity -= t_quantity;
+		m_quantity -= t_quantity;
+		update(queued_order);
+	}
+
+	account(*queued_order, *t_order, t_quantity, t_price);
+	queued_order->on_traded(t_order);
+	t_order->on_traded(traded_order);
+
+	if (filled) {
+		queued_order->m_book = nullptr;
+	}
+}
+
 double elob::order_limit::get_quantity() const { return m_quantity; }
 
 double elob::order_limit::get_aon_quantity() const { return m_aon_quantity; }
 
+double elob::order_limit::get_hidden_quantity() const {
+	return m_hidden_quantity;
+}
+
 std::size_t elob::order_limit::get_order_count() const {
-	return m_orders.size();
+	return order_count();
 }
 
-std::list<elob::order_ptr>::iterator elob::order_limit::begin() {
-	return m_orders.begin();
+elob::slot_list<elob::order *> &elob::order_limit::orders() {
+	compact();
+	return m_queue->m_orders;
 }
 
-std::list<elob::order_ptr>::iterator elob::order_limit::end() {
-	return m_orders.end();
+elob::order_ptr elob::order_limit::hold(
+    const elob::order &t_queued, const elob::order &t_order) {
+	if (typeid(t_queued) == typeid(order) &&
+	    typeid(t_order) == typeid(order)) {
+		return nullptr;
+	}
+
+	return t_queued.m_self;
 }
 
-std::size_t elob::order_limit::order_count() const { return m_orders.size(); }
+elob::order_limit::iterator::reference
+elob::order_limit::iterator::operator*() const {
+	return (*m_order_it)->m_self;
+}
 
-std::size_t elob::order_limit::aon_order_count() const {
-	return m_aon_order_its.size();
+elob::order_limit::iterator::pointer
+elob::order_limit::iterator::operator->() const {
+	return &(*m_order_it)->m_self;
 }
 
-elob::order_limit::~order_limit() {
-	for (auto &order : m_orders) {
-		order->m_book = nullptr;
-		order->m_queued = false;
-	}
+elob::order_limit::iterator elob::order_limit::begin() {
+	return iterator(orders().begin());
+}
+
+elob::order_limit::iterator elob::order_limit::end() {
+	return iterator(m_queue->m_orders.end());
+}
+
+std::size_t elob::order_limit::order_count() const {
+	return m_queue ? m_queue->m_orders.size() - m_queue->m_dead : 0;
+}
+
+std::size_t elob::order_limit::aon_order_count() const {
+	return m_queue ? m_queue->m_aon_orders.size() : 0;
 }
 
 #endif // #ifndef ORDER_LIMIT_HPP
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef PARTICIPANT_HPP
+#define PARTICIPANT_HPP
+#include "common.hpp"
+#include <cstddef>
+#include <limits>
+
+namespace elob {
+
+/**
+ * @brief Pre-trade limits of a participant, see book::set_risk_limits.
+ * The book rejects orders that would exceed them. The defaults do not
+ * limit anything.
+ *
+ */
+struct risk_limits {
+	// the largest quantity of a single order
+	double max_order_quantity = max_price;
+
+	// the largest quantity the queued orders of one side may add up to
+	double max_open_quantity = max_price;
+
+	// the largest position, long or short, once all queued orders of
+	// one side and the new order were filled
+	double max_position = max_price;
+
+	// the largest notional of the fills and the new order
+	double max_notional = max_price;
+
+	// the largest number of queued orders
+	std::size_t max_order_count = std::numeric_limits<std::size_t>::max();
+};
+
+/**
+ * @brief The open orders and fills of a participant, see
+ * book::get_participant_risk. The book updates them incrementally as
+ * orders of the participant are queued, traded and canceled.
+ *
+ */
+struct participant_risk {
+	// the quantity of the queued bids, including hidden quantities
+	double open_bid_quantity = 0.0;
+
+	// the quantity of the queued asks, including hidden quantities
+	double open_ask_quantity = 0.0;
+
+	// the quantity bought less the quantity sold
+	double position = 0.0;
+
+	// the sum of price times quantity of all fills
+	double notional = 0.0;
+
+	// the number of queued orders
+	std::size_t order_count = 0;
+};
+
+/**
+ * \internal
+ * @brief An entry of the participant index of a book.
+ *
+ */
+struct participant {
+	// the first queued order, the others are linked through the orders
+	order *m_first = nullptr;
+
+	participant_risk m_risk;
+	risk_limits m_limits;
+};
+
+} // namespace elob
+
+#endif // #ifndef PARTICIPANT_HPP
@@ -0,0 +1,62 @@
+#ifndef PEG_HPP
+#define PEG_HPP
+#include "order.hpp"
+
+namespace elob {
+
+/**
+ * @brief A pegged order is priced at a reference price plus an offset.
+ * Primary pegs reference the best price of their own side, market pegs
+ * the best price of the opposite side and mid pegs the midpoint of
+ * both. Reference prices are taken from ordinary price levels only.
+ * Pegged orders are passive: they are queued on entry and only trade
+ * against inbound orders. Orders with the same peg and offset form a
+ * group that keeps time priority and is repriced as a whole whenever
+ * the reference price changes. Pegged orders cannot be all-or-nothing
+ * and cannot be replaced. An order whose reference price is
+ * unavailable stays queued but does not trade.
+ *
+ */
+class peg : public order {
+	public:
+	/**
+	 * @brief Construct a new peg object
+	 *
+	 * @param t_side the side at which the order will be inserted
+	 * @param t_peg the reference price of the order
+	 * @param t_offset the offset from the reference price. Must not
+	 * be positive for bids and not be negative for asks.
+	 * @param t_quantity the quantity of the order
+	 */
+	peg(const side t_side, const peg_type t_peg, const double t_offset,
+	    const double t_quantity);
+
+	/**
+	 * @brief Get the reference price of the order.
+	 *
+	 * @return the peg type.
+	 */
+	inline peg_type get_peg() const;
+
+	/**
+	 * @brief Get the offset from the reference price.
+	 *
+	 * @return the offset.
+	 */
+	inline double get_offset() const;
+};
+
+} // namespace elob
+
+elob::peg::peg(const elob::side t_side, const elob::peg_type t_peg,
+    const double t_offset, const double t_quantity)
+    : elob::order(t_side, 0.0, t_quantity) {
+	m_peg = t_peg;
+	m_offset = t_offset;
+}
+
+elob::peg_type elob::peg::get_peg() const { return m_peg; }
+
+double elob::peg::get_offset() const { return m_offset; }
+
+#endif // #ifndef PEG_HPP
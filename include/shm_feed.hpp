@@ -0,0 +1,418 @@
+#ifndef SHM_FEED_HPP
+#define SHM_FEED_HPP
+#include "codec.hpp"
+#include "common.hpp"
+#include "listener.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace elob {
+
+/**
+ * @brief A record of the ring holds one codec message: a fill_message
+ * per trade (with token 0), a level_message per modified price level
+ * and a batch_message at the end of every operation. All messages of
+ * one operation share the same batch number. Records are padded to
+ * feed_record_length bytes.
+ *
+ */
+struct alignas(8) feed_record {
+	char data[(codec::max_message_length + 7) / 8 * 8];
+};
+
+const std::size_t feed_record_length = sizeof(feed_record);
+
+/**
+ * \internal
+ * @brief A slot of the ring. The sequence number is written last and
+ * identifies the message currently stored in the slot.
+ *
+ */
+struct alignas(64) feed_slot {
+	static constexpr std::size_t word_count =
+	    sizeof(feed_record) / sizeof(std::uint64_t);
+
+	std::atomic<std::uint64_t> sequence;
+	std::atomic<std::uint64_t> words[word_count];
+};
+
+/**
+ * \internal
+ * @brief Header at the start of the shared memory segment followed by
+ * capacity slots.
+ *
+ */
+struct alignas(64) feed_header {
+	std::atomic<std::uint64_t> magic;
+	std::uint32_t version;
+	std::uint32_t slot_size;
+	std::uint64_t capacity;
+	alignas(64) std::atomic<std::uint64_t> write_sequence;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+    "the ring requires lock-free 64 bit atomics");
+
+const std::uint64_t feed_magic = 0x656c6f6266656564; // "elobfeed"
+const std::uint32_t feed_version = 2;
+
+/**
+ * @brief shm_publisher is a listener that writes the market data of a
+ * book into a single-producer ring in POSIX shared memory (e.g.
+ * /dev/shm/<name>). Any number of shm_subscriber objects in other
+ * processes can read the ring without copying or system calls.
+ *
+ */
+class shm_publisher : public listener {
+	private:
+	std::string m_name;
+	feed_header *m_header = nullptr;
+	feed_slot *m_slots = nullptr;
+	std::size_t m_mapped_size = 0;
+	std::uint64_t m_capacity = 0;
+	std::uint64_t m_sequence = 0;
+	std::uint64_t m_batch = 1;
+
+	feed_record m_record;
+
+	inline void write();
+
+	public:
+	/**
+	 * @brief Create (or replace) the shared memory segment.
+	 *
+	 * @param t_name the name of the segment, e.g. "/elob_feed"
+	 * @param t_capacity the number of messages in the ring. Must be
+	 * a power of two.
+	 * @throws std::system_error if the segment cannot be created.
+	 */
+	shm_publisher(const std::string &t_name, const std::size_t t_capacity);
+
+	shm_publisher(const shm_publisher &) = delete;
+	shm_publisher &operator=(const shm_publisher &) = delete;
+
+	void on_trade(const side t_side, const double t_price,
+	    const double t_quantity) override;
+
+	void on_level(const side t_side, const double t_price,
+	    const double t_quantity, const double t_aon_quantity,
+	    const std::size_t t_order_count) override;
+
+	void on_published(const double t_market_price) override;
+
+	/**
+	 * @brief Get the sequence number of the last message written.
+	 *
+	 * @return the number of messages written so far.
+	 */
+	inline std::uint64_t get_sequence() const;
+
+	/**
+	 * @brief Unmaps and unlinks the segment. Subscribers that are
+	 * still attached keep their mapping.
+	 *
+	 */
+	~shm_publisher();
+};
+
+enum class feed_status { ok = 0, empty, overrun };
+
+/**
+ * @brief shm_subscriber attaches to a segment created by an
+ * shm_publisher and reads its messages in order. Overruns, i.e.
+ * messages overwritten before they were read, are detected by sequence
+ * number.
+ *
+ */
+class shm_subscriber {
+	private:
+	const feed_header *m_header = nullptr;
+	const feed_slot *m_slots = nullptr;
+	std::size_t m_mapped_size = 0;
+	std::uint64_t m_capacity = 0;
+	std::uint64_t m_next = 1;
+	std::uint64_t m_dropped = 0;
+
+	public:
+	/**
+	 * @brief Attach to an existing segment. Reading starts with the
+	 * next message written.
+	 *
+	 * @param t_name the name of the segment
+	 * @throws std::system_error if the segment cannot be opened.
+	 * @throws std::runtime_error if the segment is not a feed.
+	 */
+	shm_subscriber(const std::string &t_name);
+
+	shm_subscriber(const shm_subscriber &) = delete;
+	shm_subscriber &operator=(const shm_subscriber &) = delete;
+
+	/**
+	 * @brief Read the next message. Decode it with the codec views,
+	 * e.g. codec::header_decoder(t_record.data).
+	 *
+	 * @param t_record the object the message is copied into
+	 * @return feed_status::ok, t_record holds the next message.
+	 * feed_status::empty, no new message has been written.
+	 * feed_status::overrun, messages were overwritten before they
+	 * could be read. Reading resumes with the oldest message still in
+	 * the ring; the number of lost messages is added to
+	 * get_dropped().
+	 */
+	inline feed_status poll(feed_record &t_record);
+
+	/**
+	 * @brief Get the sequence number of the next message to be
+	 * read.
+	 *
+	 * @return the next sequence number.
+	 */
+	inline std::uint64_t get_next_sequence() const;
+
+	/**
+	 * @brief Get the number of messages lost to overruns.
+	 *
+	 * @return the number of messages lost.
+	 */
+	inline std::uint64_t get_dropped() const;
+
+	~shm_subscriber();
+};
+
+} // namespace elob
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+elob::shm_publisher::shm_publisher(
+    const std::string &t_name, const std::size_t t_capacity)
+    : m_name(t_name), m_capacity(t_capacity) {
+	if (t_capacity == 0 || (t_capacity & (t_capacity - 1)) != 0) {
+		throw std::invalid_argument("capacity must be a power of two");
+	}
+
+	const int fd = shm_open(t_name.c_str(), O_CREAT | O_RDWR, 0600);
+
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), t_name);
+	}
+
+	m_mapped_size = sizeof(feed_header) + t_capacity * sizeof(feed_slot);
+
+	if (ftruncate(fd, m_mapped_size) != 0) {
+		const int error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), t_name);
+	}
+
+	void *const address = mmap(nullptr, m_mapped_size,
+	    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	const int error = errno;
+	close(fd);
+
+	if (address == MAP_FAILED) {
+		throw std::system_error(error, std::generic_category(), t_name);
+	}
+
+	m_header = new (address) feed_header();
+	m_header->magic.store(0, std::memory_order_relaxed);
+	m_slots = reinterpret_cast<feed_slot *>(
+	    static_cast<char *>(address) + sizeof(feed_header));
+
+	for (std::size_t i = 0; i < t_capacity; ++i) {
+		new (m_slots + i) feed_slot();
+		m_slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+
+	m_header->capacity = t_capacity;
+	m_header->slot_size = sizeof(feed_slot);
+	m_header->version = feed_version;
+	m_header->write_sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	// written last, subscribers check it before trusting the header
+	m_header->magic.store(feed_magic, std::memory_order_release);
+}
+
+void elob::shm_publisher::write() {
+	std::uint64_t words[feed_slot::word_count];
+	std::memcpy(words, m_record.data, sizeof(feed_record));
+
+	const std::uint64_t sequence = ++m_sequence;
+	auto &slot = m_slots[sequence & (m_capacity - 1)];
+
+	// invalidate the slot before overwriting its payload
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (std::size_t i = 0; i < feed_slot::word_count; ++i) {
+		slot.words[i].store(words[i], std::memory_order_relaxed);
+	}
+
+	slot.sequence.store(sequence, std::memory_order_release);
+	m_header->write_sequence.store(sequence, std::memory_order_release);
+}
+
+void elob::shm_publisher::on_trade(
+    const elob::side t_side, const double t_price, const double t_quantity) {
+	codec::fill_message_encoder(m_record.data)
+	    .encode_header()
+	    .token(0)
+	    .batch(m_batch)
+	    .price(t_price)
+	    .quantity(t_quantity)
+	    .side(t_side);
+	write();
+}
+
+void elob::shm_publisher::on_level(const elob::side t_side,
+    const double t_price, const double t_quantity, const double t_aon_quantity,
+    const std::size_t t_order_count) {
+	codec::level_message_encoder(m_record.data)
+	    .encode_header()
+	    .batch(m_batch)
+	    .price(t_price)
+	    .quantity(t_quantity)
+	    .aon_quantity(t_aon_quantity)
+	    .order_count(static_cast<std::uint32_t>(t_order_count))
+	    .side(t_side);
+	write();
+}
+
+void elob::shm_publisher::on_published(const double t_market_price) {
+	codec::batch_message_encoder(m_record.data)
+	    .encode_header()
+	    .batch(m_batch++)
+	    .market_price(t_market_price);
+	write();
+}
+
+std::uint64_t elob::shm_publisher::get_sequence() const { return m_sequence; }
+
+elob::shm_publisher::~shm_publisher() {
+	munmap(m_header, m_mapped_size);
+	shm_unlink(m_name.c_str());
+}
+
+elob::shm_subscriber::shm_subscriber(const std::string &t_name) {
+	const int fd = shm_open(t_name.c_str(), O_RDONLY, 0);
+
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), t_name);
+	}
+
+	struct stat status;
+
+	if (fstat(fd, &status) != 0) {
+		const int error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), t_name);
+	}
+
+	m_mapped_size = static_cast<std::size_t>(status.st_size);
+
+	if (m_mapped_size < sizeof(feed_header)) {
+		close(fd);
+		throw std::runtime_error(t_name + " is not a feed");
+	}
+
+	void *const address =
+	    mmap(nullptr, m_mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+	const int error = errno;
+	close(fd);
+
+	if (address == MAP_FAILED) {
+		throw std::system_error(error, std::generic_category(), t_name);
+	}
+
+	m_header = static_cast<const feed_header *>(address);
+	const auto magic = m_header->magic.load(std::memory_order_acquire);
+
+	if (magic != feed_magic || m_header->version != feed_version ||
+	    m_header->slot_size != sizeof(feed_slot) ||
+	    m_mapped_size < sizeof(feed_header) +
+				m_header->capacity * sizeof(feed_slot)) {
+		munmap(address, m_mapped_size);
+		throw std::runtime_error(t_name + " is not a compatible feed");
+	}
+
+	m_capacity = m_header->capacity;
+	m_slots = reinterpret_cast<const feed_slot *>(
+	    static_cast<const char *>(address) + sizeof(feed_header));
+	m_next =
+	    m_header->write_sequence.load(std::memory_order_acquire) + 1;
+}
+
+elob::feed_status elob::shm_subscriber::poll(elob::feed_record &t_record) {
+	const auto &slot = m_slots[m_next & (m_capacity - 1)];
+
+	for (bool retried = false;; retried = true) {
+		const std::uint64_t before =
+		    slot.sequence.load(std::memory_order_acquire);
+
+		if (before == m_next) {
+			std::uint64_t words[feed_slot::word_count];
+
+			for (std::size_t i = 0; i < feed_slot::word_count; ++i) {
+				words[i] =
+				    slot.words[i].load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (slot.sequence.load(std::memory_order_relaxed) ==
+			    m_next) {
+				std::memcpy(
+				    t_record.data, words, sizeof(feed_record));
+				++m_next;
+				return feed_status::ok;
+			}
+		}
+
+		const std::uint64_t written =
+		    m_header->write_sequence.load(std::memory_order_acquire);
+
+		if (written < m_next) {
+			return feed_status::empty;
+		}
+
+		// the message was written after the slot was read. If it
+		// is still missing, the next lap is being written into the
+		// slot.
+		if (written - m_next < m_capacity) {
+			if (retried) {
+				return feed_status::empty;
+			}
+
+			continue;
+		}
+
+		// the slot has been (or is being) overwritten by a later
+		// lap. The oldest message still in the ring may be
+		// overwritten as well, which the next poll detects.
+		const std::uint64_t oldest = written - m_capacity + 1;
+		m_dropped += oldest - m_next;
+		m_next = oldest;
+		return feed_status::overrun;
+	}
+}
+
+std::uint64_t elob::shm_subscriber::get_next_sequence() const {
+	return m_next;
+}
+
+std::uint64_t elob::shm_subscriber::get_dropped() const { return m_dropped; }
+
+elob::shm_subscriber::~shm_subscriber() {
+	munmap(const_cast<feed_header *>(m_header), m_mapped_size);
+}
+
+#endif // #ifndef SHM_FEED_HPP
@@ -0,0 +1,308 @@
+#ifndef SLOT_LIST_HPP
+#define SLOT_LIST_HPP
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace elob {
+
+// the slot of no element, e.g. the successor of the last one
+const std::uint32_t no_slot = UINT32_MAX;
+
+/**
+ * \internal
+ * @brief A doubly-linked list whose nodes are stored in one array and
+ * linked by 32 bit slots. Elements refer to their node by its slot
+ * instead of an iterator. A slot stays valid until its element is
+ * erased, also when the list is moved; the slots of erased elements
+ * are reused.
+ *
+ * @tparam T the type of the elements
+ */
+template <class T> class slot_list {
+	private:
+	struct node {
+		T m_value;
+		std::uint32_t m_prev;
+		std::uint32_t m_next;
+	};
+
+	// erased nodes are chained through m_next starting at m_free
+	std::vector<node> m_nodes;
+	std::uint32_t m_first = no_slot;
+	std::uint32_t m_last = no_slot;
+	std::uint32_t m_free = no_slot;
+	std::size_t m_size = 0;
+
+	/**
+	 * \internal
+	 * @brief Link the node at t_slot in front of the node at
+	 * t_before, or at the end if t_before is no_slot.
+	 *
+	 */
+	inline void link(
+	    const std::uint32_t t_slot, const std::uint32_t t_before);
+
+	/**
+	 * \internal
+	 * @brief Unlink the node at t_slot without freeing it.
+	 *
+	 */
+	inline void unlink(const std::uint32_t t_slot);
+
+	public:
+	template <bool Const> class basic_iterator {
+		private:
+		using list_type =
+		    std::conditional_t<Const, const slot_list, slot_list>;
+
+		list_type *m_list = nullptr;
+		std::uint32_t m_slot = no_slot;
+
+		public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<Const, const T *, T *>;
+		using reference = std::conditional_t<Const, const T &, T &>;
+
+		basic_iterator() = default;
+
+		basic_iterator(list_type *t_list, const std::uint32_t t_slot)
+		    : m_list(t_list), m_slot(t_slot) {}
+
+		std::uint32_t slot() const { return m_slot; }
+
+		reference operator*() const { return (*m_list)[m_slot]; }
+
+		pointer operator->() const { return &(*m_list)[m_slot]; }
+
+		basic_iterator &operator++() {
+			m_slot = m_list->next(m_slot);
+			return *this;
+		}
+
+		basic_iterator operator++(int) {
+			auto pre_increment_copy = *this;
+			++*this;
+			return pre_increment_copy;
+		}
+
+		// the end of the list steps back to the last element
+		basic_iterator &operator--() {
+			m_slot = m_slot == no_slot ? m_list->last()
+						   : m_list->prev(m_slot);
+			return *this;
+		}
+
+		basic_iterator operator--(int) {
+			auto pre_decrement_copy = *this;
+			--*this;
+			return pre_decrement_copy;
+		}
+
+		bool operator==(const basic_iterator &t_other) const {
+			return m_slot == t_other.m_slot;
+		}
+
+		bool operator!=(const basic_iterator &t_other) const {
+			return m_slot != t_other.m_slot;
+		}
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+	/**
+	 * @brief Append an element. O(1) amortized.
+	 *
+	 * @return the slot of the element
+	 */
+	inline std::uint32_t push_back(const T &t_value);
+
+	/**
+	 * @brief Insert an element in front of the element at t_before, or
+	 * at the end if t_before is no_slot. O(1) amortized.
+	 *
+	 * @return the slot of the element
+	 */
+	inline std::uint32_t insert(
+	    const std::uint32_t t_before, const T &t_value);
+
+	/**
+	 * @brief Erase the element at t_slot. O(1).
+	 *
+	 */
+	inline void erase(const std::uint32_t t_slot);
+
+	/**
+	 * @brief Erase all elements equal to t_value. O(n).
+	 *
+	 */
+	inline void remove(const T &t_value);
+
+	/**
+	 * @brief Move the element at t_slot to the end of the list. Its
+	 * slot does not change. O(1).
+	 *
+	 */
+	inline void move_back(const std::uint32_t t_slot);
+
+	/**
+	 * @brief Erase all elements. The array keeps its capacity.
+	 *
+	 */
+	inline void clear();
+
+	inline T &operator[](const std::uint32_t t_slot);
+	inline const T &operator[](const std::uint32_t t_slot) const;
+
+	/**
+	 * @brief Get the slot of the first, last, next or previous
+	 * element, no_slot if there is none.
+	 *
+	 */
+	inline std::uint32_t first() const { return m_first; }
+	inline std::uint32_t last() const { return m_last; }
+	inline std::uint32_t next(const std::uint32_t t_slot) const;
+	inline std::uint32_t prev(const std::uint32_t t_slot) const;
+
+	inline std::size_t size() const { return m_size; }
+	inline bool empty() const { return m_size == 0; }
+
+	inline iterator begin() { return iterator(this, m_first); }
+	inline iterator end() { return iterator(this, no_slot); }
+	inline const_iterator begin() const {
+		return const_iterator(this, m_first);
+	}
+	inline const_iterator end() const {
+		return const_iterator(this, no_slot);
+	}
+};
+
+} // namespace elob
+
+template <class T>
+void elob::slot_list<T>::link(
+    const std::uint32_t t_slot, const std::uint32_t t_before) {
+	node &node_obj = m_nodes[t_slot];
+	node_obj.m_next = t_before;
+	node_obj.m_prev =
+	    t_before == no_slot ? m_last : m_nodes[t_before].m_prev;
+
+	if (node_obj.m_prev == no_slot) {
+		m_first = t_slot;
+	} else {
+		m_nodes[node_obj.m_prev].m_next = t_slot;
+	}
+
+	if (t_before == no_slot) {
+		m_last = t_slot;
+	} else {
+		m_nodes[t_before].m_prev = t_slot;
+	}
+
+	++m_size;
+}
+
+template <class T> void elob::slot_list<T>::unlink(const std::uint32_t t_slot) {
+	const node &node_obj = m_nodes[t_slot];
+
+	if (node_obj.m_prev == no_slot) {
+		m_first = node_obj.m_next;
+	} else {
+		m_nodes[node_obj.m_prev].m_next = node_obj.m_next;
+	}
+
+	if (node_obj.m_next == no_slot) {
+		m_last = node_obj.m_prev;
+	} else {
+		m_nodes[node_obj.m_next].m_prev = node_obj.m_prev;
+	}
+
+	--m_size;
+}
+
+template <class T>
+std::uint32_t elob::slot_list<T>::push_back(const T &t_value) {
+	return insert(no_slot, t_value);
+}
+
+template <class T>
+std::uint32_t elob::slot_list<T>::insert(
+    const std::uint32_t t_before, const T &t_value) {
+	std::uint32_t slot = m_free;
+
+	if (slot == no_slot) {
+		slot = static_cast<std::uint32_t>(m_nodes.size());
+		m_nodes.push_back(node{t_value, no_slot, no_slot});
+	} else {
+		m_free = m_nodes[slot].m_next;
+		m_nodes[slot].m_value = t_value;
+	}
+
+	link(slot, t_before);
+	return slot;
+}
+
+template <class T> void elob::slot_list<T>::erase(const std::uint32_t t_slot) {
+	unlink(t_slot);
+	m_nodes[t_slot].m_next = m_free;
+	m_free = t_slot;
+}
+
+template <class T> void elob::slot_list<T>::remove(const T &t_value) {
+	std::uint32_t slot = m_first;
+
+	while (slot != no_slot) {
+		const std::uint32_t next_slot = m_nodes[slot].m_next;
+
+		if (m_nodes[slot].m_value == t_value) {
+			erase(slot);
+		}
+
+		slot = next_slot;
+	}
+}
+
+template <class T>
+void elob::slot_list<T>::move_back(const std::uint32_t t_slot) {
+	if (t_slot == m_last) {
+		return;
+	}
+
+	unlink(t_slot);
+	link(t_slot, no_slot);
+}
+
+template <class T> void elob::slot_list<T>::clear() {
+	m_nodes.clear();
+	m_first = no_slot;
+	m_last = no_slot;
+	m_free = no_slot;
+	m_size = 0;
+}
+
+template <class T>
+T &elob::slot_list<T>::operator[](const std::uint32_t t_slot) {
+	return m_nodes[t_slot].m_value;
+}
+
+template <class T>
+const T &elob::slot_list<T>::operator[](const std::uint32_t t_slot) const {
+	return m_nodes[t_slot].m_value;
+}
+
+template <class T>
+std::uint32_t elob::slot_list<T>::next(const std::uint32_t t_slot) const {
+	return m_nodes[t_slot].m_next;
+}
+
+template <class T>
+std::uint32_t elob::slot_list<T>::prev(const std::uint32_t t_slot) const {
+	return m_nodes[t_slot].m_prev;
+}
+
+#endif // #ifndef SLOT_LIST_HPP
@@ -0,0 +1,196 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+#include "common.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace elob {
+
+class book;
+
+// number of price levels per side published in a snapshot
+const std::size_t snapshot_depth = 10;
+
+/**
+ * @brief A single aggregated price level as published in a snapshot.
+ *
+ */
+struct depth_level {
+	double price = 0.0;
+	double quantity = 0.0;
+	double aon_quantity = 0.0;
+	std::uint64_t order_count = 0;
+};
+
+/**
+ * @brief Plain copy of the top of the book taken by snapshot::read.
+ * Levels are ordered from the best price outwards; only the first
+ * bid_count and ask_count entries are valid.
+ *
+ */
+struct snapshot_data {
+	std::uint64_t sequence = 0;
+	double market_price = -1.0;
+	double last_trade_quantity = 0.0;
+	std::uint64_t bid_count = 0;
+	std::uint64_t ask_count = 0;
+	depth_level bids[snapshot_depth];
+	depth_level asks[snapshot_depth];
+
+	/**
+	 * @brief Get the best bid price at the time of publication.
+	 *
+	 * @return double the best bid price
+	 */
+	inline double get_bid_price() const;
+
+	/**
+	 * @brief Get the best ask price at the time of publication.
+	 *
+	 * @return double the best ask price
+	 */
+	inline double get_ask_price() const;
+
+	/**
+	 * @brief Get the price at which the last trade occured.
+	 *
+	 * @return double the market price at the time of publication
+	 */
+	inline double get_market_price() const;
+};
+
+static_assert(std::is_trivially_copyable<snapshot_data>::value,
+    "snapshot_data is copied word by word");
+
+/**
+ * @brief snapshot is a seqlock-protected block into which a book
+ * publishes its top-of-book after every outer operation. The book is
+ * the only writer; any number of threads can call read concurrently
+ * without locking and without writing to the shared cache lines.
+ *
+ */
+class alignas(64) snapshot {
+	private:
+	static constexpr std::size_t word_count =
+	    (sizeof(snapshot_data) + sizeof(std::uint64_t) - 1) /
+	    sizeof(std::uint64_t);
+
+	/* odd while a publication is in progress. Kept on its own cache
+		line so readers polling it do not share a line with the
+		payload being written. */
+	alignas(64) std::atomic<std::uint64_t> m_sequence{0};
+
+	/* the payload is stored as relaxed atomic words so that
+		concurrent reads are well-defined. */
+	alignas(64) std::atomic<std::uint64_t> m_words[word_count];
+
+	/**
+	 * \internal
+	 * @brief Publish a new snapshot. Must only be called by the
+	 * owning book.
+	 *
+	 * @param t_data the snapshot to be published
+	 */
+	inline void write(const snapshot_data &t_data);
+
+	public:
+	snapshot();
+
+	/**
+	 * @brief Take a consistent copy of the most recently published
+	 * snapshot. Spins while a publication is in progress.
+	 *
+	 * @param t_data the object the snapshot is copied into
+	 */
+	inline void read(snapshot_data &t_data) const;
+
+	/**
+	 * @brief Try to take a consistent copy of the most recently
+	 * published snapshot without spinning.
+	 *
+	 * @param t_data the object the snapshot is copied into
+	 * @return true, t_data holds a consistent snapshot.
+	 * @return false, a publication was in progress.
+	 */
+	inline bool try_read(snapshot_data &t_data) const;
+
+	/**
+	 * @brief Get the number of snapshots published so far, including
+	 * the empty snapshot written on construction.
+	 *
+	 * @return the number of publications.
+	 */
+	inline std::uint64_t get_sequence() const;
+
+	friend book;
+};
+
+} // namespace elob
+
+#include <cstring>
+
+double elob::snapshot_data::get_bid_price() const {
+	return bid_count > 0 ? bids[0].price : min_price;
+}
+
+double elob::snapshot_data::get_ask_price() const {
+	return ask_count > 0 ? asks[0].price : max_price;
+}
+
+double elob::snapshot_data::get_market_price() const { return market_price; }
+
+elob::snapshot::snapshot() {
+	const snapshot_data empty;
+	write(empty);
+}
+
+void elob::snapshot::write(const elob::snapshot_data &t_data) {
+	std::uint64_t words[word_count] = {};
+	std::memcpy(words, &t_data, sizeof(snapshot_data));
+
+	const std::uint64_t sequence =
+	    m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (std::size_t i = 0; i < word_count; ++i) {
+		m_words[i].store(words[i], std::memory_order_relaxed);
+	}
+
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool elob::snapshot::try_read(elob::snapshot_data &t_data) const {
+	std::uint64_t words[word_count];
+	const std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+
+	if (before & 1) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < word_count; ++i) {
+		words[i] = m_words[i].load(std::memory_order_relaxed);
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	if (m_sequence.load(std::memory_order_relaxed) != before) {
+		return false;
+	}
+
+	std::memcpy(&t_data, words, sizeof(snapshot_data));
+	return true;
+}
+
+void elob::snapshot::read(elob::snapshot_data &t_data) const {
+	while (!try_read(t_data)) {
+	}
+}
+
+std::uint64_t elob::snapshot::get_sequence() const {
+	return m_sequence.load(std::memory_order_acquire) / 2;
+}
+
+#endif // #ifndef SNAPSHOT_HPP
@@ -0,0 +1,181 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace elob {
+
+/**
+ * @brief A hierarchical timer wheel over a 64 bit logical clock. Each
+ * level has 64 slots; a slot of level n spans 64^n ticks. A timer is
+ * placed at the level of the highest 6 bit digit in which its expiry
+ * differs from the current time, so scheduling is O(1). When the clock
+ * reaches a slot of a higher level, its timers cascade to lower levels
+ * and each timer cascades at most once per level before it fires.
+ * Empty slots are skipped with one bit scan per level, so advancing
+ * the clock does not depend on the distance advanced.
+ *
+ * @tparam T the value stored with each timer
+ */
+template <class T> class timer_wheel {
+	private:
+	static constexpr std::size_t slot_bits = 6;
+	static constexpr std::size_t slot_count = 64;
+	static constexpr std::size_t level_count = 11; // 66 bits
+
+	struct timer {
+		std::uint64_t expiry;
+		T value;
+	};
+
+	std::uint64_t m_time = 0;
+
+	// bit i is set if slot i of the level holds timers
+	std::uint64_t m_occupied[level_count] = {};
+	std::vector<timer> m_slots[level_count][slot_count];
+
+	// the timers of the slot being processed
+	std::vector<timer> m_due;
+
+	/**
+	 * \internal
+	 * @brief Place a timer that expires after the current time.
+	 *
+	 */
+	inline void place(timer &&t_timer);
+
+	/**
+	 * \internal
+	 * @brief Find the next non-empty slot.
+	 *
+	 * @return true a slot was found and its level, index and start
+	 * time are stored in the arguments
+	 */
+	inline bool next_slot(std::size_t &t_level, std::size_t &t_slot,
+	    std::uint64_t &t_start) const;
+
+	public:
+	/**
+	 * @brief Construct a new timer wheel starting at t_time.
+	 *
+	 * @param t_time the current time
+	 */
+	explicit timer_wheel(const std::uint64_t t_time) : m_time(t_time) {}
+
+	/**
+	 * @brief Schedule a timer. O(1).
+	 *
+	 * @param t_expiry the time at which the timer fires. Must be
+	 * later than the current time.
+	 * @param t_value the value passed to the callback
+	 */
+	inline void schedule(const std::uint64_t t_expiry, T t_value);
+
+	/**
+	 * @brief Advance the clock to t_time and call t_function with
+	 * the expiry and the value of every timer due by then, in the
+	 * order of their expiry. While t_function runs, get_time
+	 * returns the expiry of the timer. t_function may schedule
+	 * timers that expire later but must not advance the wheel.
+	 *
+	 * @param t_time the new time. Earlier times are ignored.
+	 * @param t_function called as t_function(expiry, value)
+	 */
+	template <class Function>
+	inline void advance(const std::uint64_t t_time, Function t_function);
+
+	/**
+	 * @brief Get the current time.
+	 *
+	 * @return the current time
+	 */
+	inline std::uint64_t get_time() const;
+};
+
+} // namespace elob
+
+template <class T> void elob::timer_wheel<T>::place(timer &&t_timer) {
+	const std::uint64_t difference = t_timer.expiry ^ m_time;
+	const std::size_t level =
+	    (63 - __builtin_clzll(difference)) / slot_bits;
+	const std::size_t slot =
+	    (t_timer.expiry >> (level * slot_bits)) & (slot_count - 1);
+	m_slots[level][slot].push_back(std::move(t_timer));
+	m_occupied[level] |= std::uint64_t(1) << slot;
+}
+
+template <class T>
+bool elob::timer_wheel<T>::next_slot(std::size_t &t_level,
+    std::size_t &t_slot, std::uint64_t &t_start) const {
+	// the slots of a level all start before those of the next one
+	for (std::size_t level = 0; level < level_count; ++level) {
+		const std::size_t shift = level * slot_bits;
+		const std::size_t digit = (m_time >> shift) & (slot_count - 1);
+
+		// timers are always placed in slots after the current one
+		const std::uint64_t after =
+		    digit == slot_count - 1 ? 0
+					    : ~std::uint64_t(0) << (digit + 1);
+		const std::uint64_t pending = m_occupied[level] & after;
+
+		if (pending == 0) {
+			continue;
+		}
+
+		const std::size_t span_bits = shift + slot_bits;
+		const std::uint64_t span_mask =
+		    span_bits >= 64 ? ~std::uint64_t(0)
+				    : (std::uint64_t(1) << span_bits) - 1;
+
+		t_level = level;
+		t_slot = __builtin_ctzll(pending);
+		t_start =
+		    (m_time & ~span_mask) | (std::uint64_t(t_slot) << shift);
+		return true;
+	}
+
+	return false;
+}
+
+template <class T>
+void elob::timer_wheel<T>::schedule(const std::uint64_t t_expiry, T t_value) {
+	place(timer{t_expiry, std::move(t_value)});
+}
+
+template <class T>
+template <class Function>
+void elob::timer_wheel<T>::advance(
+    const std::uint64_t t_time, Function t_function) {
+	std::size_t level = 0;
+	std::size_t slot = 0;
+	std::uint64_t start = 0;
+
+	while (next_slot(level, slot, start) && start <= t_time) {
+		m_time = start;
+		m_due.swap(m_slots[level][slot]);
+		m_occupied[level] &= ~(std::uint64_t(1) << slot);
+
+		for (auto &due : m_due) {
+			if (due.expiry == m_time) {
+				t_function(due.expiry, due.value);
+			} else {
+				// cascade to a lower level
+				place(std::move(due));
+			}
+		}
+
+		m_due.clear();
+	}
+
+	if (t_time > m_time) {
+		m_time = t_time;
+	}
+}
+
+template <class T> std::uint64_t elob::timer_wheel<T>::get_time() const {
+	return m_time;
+}
+
+#endif // #ifndef TIMER_WHEEL_HPP
@@ -1,6 +1,6 @@
 #ifndef TRIGGER_HPP
 #define TRIGGER_HPP
-#include <list>
+#include <cstdint>
 #include <map>
 #include <memory>
 
@@ -25,6 +25,15 @@ class book;
 class trigger : public std::enable_shared_from_this<trigger> {
 	private:
 	const side m_side;
+
+	/* the handle of the level in the book and the slot of the
+		trigger in it. They are used to cancel the trigger in O(1). */
+	std::uint32_t m_level = 0;
+	std::uint32_t m_slot = 0;
+
+	// the handle of the one-cancels-other group, 0 if there is none
+	std::uint32_t m_group = 0;
+
 	double m_price;
 	bool m_queued = false;
 
@@ -33,10 +42,16 @@ class trigger : public std::enable_shared_from_this<trigger> {
 	   event methods. */
 	book *m_book = nullptr;
 
-	/* these iterators store the location of the order in the order
-		book. They are used to cancel the order in O(1). */
-	std::map<double, trigger_limit>::iterator m_limit_it;
-	std::list<trigger_ptr>::iterator m_trigger_it;
+	/* keeps the trigger alive while it is queued. The book itself
+		stores plain pointers. */
+	trigger_ptr m_self;
+
+	/* triggers with an expiry are canceled once the clock of their
+		book reaches it. m_timer is the expiry of the timer pending
+		in m_timer_book, 0 if there is none. */
+	std::uint64_t m_expiry = 0;
+	std::uint64_t m_timer = 0;
+	const book *m_timer_book = nullptr;
 
 	protected:
 	/**
@@ -91,6 +106,25 @@ class trigger : public std::enable_shared_from_this<trigger> {
 	 */
 	inline void set_price(double t_price);
 
+	/**
+	 * @brief Get the time at which the trigger expires.
+	 *
+	 * @return the expiry on the clock of the book, 0 if the
+	 * trigger does not expire.
+	 */
+	inline std::uint64_t get_expiry() const;
+
+	/**
+	 * @brief Set the time at which the trigger expires. Once the
+	 * clock of the book (see book::advance_time) reaches the
+	 * expiry, the trigger is canceled. Queued triggers whose new
+	 * expiry has passed expire immediately.
+	 *
+	 * @param t_expiry the expiry on the clock of the book, 0 if
+	 * the trigger does not expire
+	 */
+	inline void set_expiry(const std::uint64_t t_expiry);
+
 	/**
 	 * @brief Get the side of the trigger.
 	 *
@@ -152,15 +186,17 @@ elob::trigger::trigger(elob::side t_side, double t_price)
 
 bool elob::trigger::cancel() {
 	if (m_queued) {
+		auto &limit_obj = m_book->m_trigger_levels[m_level]->second;
+		const trigger_ptr self = limit_obj.erase(m_slot);
 
-		m_limit_it->second.erase(m_trigger_it);
+		if (m_side == side::bid) {
+			m_book->erase_if_empty<side::bid>(*this);
+		} else {
+			m_book->erase_if_empty<side::ask>(*this);
+		}
 
-		if (m_limit_it->second.is_empty()) {
-			if (m_side == side::bid) {
-				m_book->m_bid_triggers.erase(m_limit_it);
-			} else {
-				m_book->m_ask_triggers.erase(m_limit_it);
-			}
+		if (m_group != 0) {
+			m_book->leave_group(m_group);
 		}
 
 		on_canceled();
@@ -180,24 +216,35 @@ void elob::trigger::set_price(double t_price) {
 		return;
 	}
 
+	const trigger_ptr self = shared_from_this();
+
 	if (m_queued) {
-		m_limit_it->second.erase(m_trigger_it);
-
-		if (m_limit_it->second.is_empty()) {
-			if (m_side == side::bid) {
-				m_book->m_bid_triggers.erase(m_limit_it);
-			} else {
-				m_book->m_ask_triggers.erase(m_limit_it);
-			}
+		m_book->m_trigger_levels[m_level]->second.erase(m_slot);
+
+		if (m_side == side::bid) {
+			m_book->erase_if_empty<side::bid>(*this);
+		} else {
+			m_book->erase_if_empty<side::ask>(*this);
 		}
 	}
 
 	m_price = t_price;
-	m_book->insert(shared_from_this());
+	m_book->insert(self);
 }
 
 double elob::trigger::get_price() const { return m_price; }
 
+std::uint64_t elob::trigger::get_expiry() const { return m_expiry; }
+
+void elob::trigger::set_expiry(const std::uint64_t t_expiry) {
+	m_expiry = t_expiry;
+
+	if (m_queued) {
+		const trigger_ptr self = shared_from_this();
+		m_book->schedule_expiry(self);
+	}
+}
+
 elob::side elob::trigger::get_side() const { return m_side; }
 
 elob::book *elob::trigger::get_book() const { return m_book; }
@@ -1,7 +1,8 @@
 #ifndef TRIGGER_LIMIT_HPP
 #define TRIGGER_LIMIT_HPP
-#include <list>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace elob {
 class trigger;
@@ -9,31 +10,76 @@ class book;
 
 class trigger_limit {
 	private:
-	std::list<trigger_ptr> m_triggers;
+	/* triggers are stored in one array per level so that a level
+		fires in a single pass and is freed at once. Each trigger
+		holds its slot. Canceled triggers leave a nullptr behind
+		until they outnumber the others or the level fires. */
+	std::vector<trigger *> m_triggers;
+	std::size_t m_dead = 0;
 
-	std::list<trigger_ptr>::iterator insert(c_trigger_ptr &t_trigger);
+	// the slots are not compacted while the level fires
+	bool m_firing = false;
 
-	inline bool is_empty() const { return m_triggers.empty(); }
+	// the handle by which the triggers of the level refer to it
+	std::uint32_t m_handle = 0;
 
-	void erase(const std::list<trigger_ptr>::iterator &t_trigger_it);
-	void trigger_all();
+	void insert(c_trigger_ptr &t_trigger);
+
+	inline bool is_empty() const {
+		return m_triggers.size() == m_dead;
+	}
+
+	/**
+	 * \internal
+	 * @brief Remove a trigger from the level.
+	 *
+	 * @param t_slot the slot of the trigger
+	 * @return trigger_ptr the reference that kept the trigger alive
+	 * while it was queued.
+	 */
+	trigger_ptr erase(const std::uint32_t t_slot);
+
+	/**
+	 * \internal
+	 * @brief Fire the triggers of the level in the order in which
+	 * they were queued.
+	 *
+	 * @return the number of triggers fired
+	 */
+	std::size_t trigger_all();
+
+	/**
+	 * \internal
+	 * @brief Remove the slots of canceled triggers. O(n).
+	 *
+	 */
+	void compact();
+
+	/**
+	 * \internal
+	 * @brief Reset an erased level for reuse at another price. The
+	 * array keeps its capacity.
+	 *
+	 */
+	inline void recycle();
 
 	public:
 	/**
-	 * @brief Get an iterator to the first trigger in the queue.
+	 * @brief Get an iterator to the first trigger in the queue. The
+	 * slots of canceled triggers are removed first.
 	 *
-	 * @return std::list<elob::trigger_ptr>::iterator,
+	 * @return std::vector<elob::trigger *>::iterator,
 	 * iterator to first trigger in the queue.
 	 */
-	inline std::list<trigger_ptr>::iterator begin();
+	inline std::vector<trigger *>::iterator begin();
 
 	/**
 	 * @brief Get an iterator to the end of the trigger queue.
 	 *
-	 * @return std::list<elob::trigger_ptr>::iterator,
+	 * @return std::vector<elob::trigger *>::iterator,
 	 * iterator to the end of the trigger queue.
 	 */
-	inline std::list<trigger_ptr>::iterator end();
+	inline std::vector<trigger *>::iterator end();
 
 	/**
 	 * @brief Get the number of triggers at this price level.
@@ -50,25 +96,46 @@ class trigger_limit {
 
 } // namespace elob
 
-std::list<elob::trigger_ptr>::iterator elob::trigger_limit::insert(
-    elob::c_trigger_ptr &t_trigger) {
-	m_triggers.push_back(t_trigger);
-	return std::prev(m_triggers.end());
+void elob::trigger_limit::insert(elob::c_trigger_ptr &t_trigger) {
+	t_trigger->m_slot = static_cast<std::uint32_t>(m_triggers.size());
+	m_triggers.push_back(t_trigger.get());
+	t_trigger->m_self = t_trigger;
 }
 
-void elob::trigger_limit::erase(
-    const std::list<elob::trigger_ptr>::iterator &t_trigger_it) {
-	auto trigger_obj = *t_trigger_it;
+elob::trigger_ptr elob::trigger_limit::erase(const std::uint32_t t_slot) {
+	elob::trigger *const trigger_obj = m_triggers[t_slot];
 	trigger_obj->m_queued = false;
-	m_triggers.erase(t_trigger_it);
+	m_triggers[t_slot] = nullptr;
+
+	if (++m_dead > m_triggers.size() / 2 && !m_firing) {
+		compact();
+	}
+
+	return std::move(trigger_obj->m_self);
 }
 
-void elob::trigger_limit::trigger_all() {
+std::size_t elob::trigger_limit::trigger_all() {
+	std::size_t fired = 0;
+	m_firing = true;
 
-	while (!m_triggers.empty()) {
-		auto trigger_obj = m_triggers.front();
-		m_triggers.pop_front();
+	// on_triggered may cancel triggers that have not fired yet
+	for (std::size_t slot = 0; slot < m_triggers.size(); ++slot) {
+		elob::trigger *const trigger_obj = m_triggers[slot];
+
+		if (!trigger_obj) {
+			continue;
+		}
+
+		m_triggers[slot] = nullptr;
+		++m_dead;
+		++fired;
+		const trigger_ptr self = std::move(trigger_obj->m_self);
 		trigger_obj->m_queued = false;
+
+		if (trigger_obj->m_group != 0) {
+			trigger_obj->m_book->fire_group(trigger_obj->m_group);
+		}
+
 		trigger_obj->on_triggered();
 
 		if (!trigger_obj
@@ -76,25 +143,59 @@ void elob::trigger_limit::trigger_all() {
 			trigger_obj->m_book = nullptr;
 		}
 	}
+
+	m_firing = false;
+
+	if (is_empty()) {
+		recycle();
+	}
+
+	return fired;
+}
+
+void elob::trigger_limit::compact() {
+	std::size_t size = 0;
+
+	for (const auto trigger_obj : m_triggers) {
+		if (trigger_obj) {
+			trigger_obj->m_slot = static_cast<std::uint32_t>(size);
+			m_triggers[size++] = trigger_obj;
+		}
+	}
+
+	m_triggers.resize(size);
+	m_dead = 0;
+}
+
+void elob::trigger_limit::recycle() {
+	m_triggers.clear();
+	m_dead = 0;
 }
 
 elob::trigger_limit::~trigger_limit() {
-	for (const auto &trigger : m_triggers) {
-		trigger->m_book = nullptr;
-		trigger->m_queued = false;
+	for (const auto trigger : m_triggers) {
+		if (trigger) {
+			trigger->m_book = nullptr;
+			trigger->m_queued = false;
+			trigger->m_self.reset();
+		}
 	}
 }
 
-std::list<elob::trigger_ptr>::iterator elob::trigger_limit::begin() {
+std::vector<elob::trigger *>::iterator elob::trigger_limit::begin() {
+	if (m_dead > 0 && !m_firing) {
+		compact();
+	}
+
 	return m_triggers.begin();
 }
 
-inline std::list<elob::trigger_ptr>::iterator elob::trigger_limit::end() {
+std::vector<elob::trigger *>::iterator elob::trigger_limit::end() {
 	return m_triggers.end();
 }
 
-inline std::size_t elob::trigger_limit::trigger_count() const {
-	return m_triggers.size();
+std::size_t elob::trigger_limit::trigger_count() const {
+	return m_triggers.size() - m_dead;
 }
 
-#endif // #ifndef TRIGGER_LIMIT_HPP
\ No newline at end of file
+#endif // #ifndef TRIGGER_LIMIT_HPP
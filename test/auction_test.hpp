@@ -0,0 +1,107 @@
+#ifndef AUCTION_TEST_HPP
+#define AUCTION_TEST_HPP
+#include "test.hpp"
+
+class auction_test : public test {
+	inline static bool queue_without_matching();
+	inline static bool indicative_price();
+	inline static bool uncross_at_single_price();
+	inline static bool cancel_immediate_or_cancel();
+
+	public:
+	auction_test();
+};
+
+#include "../include/book.hpp"
+
+auction_test::auction_test() : test("auction_test") {
+	add("queue_without_matching", queue_without_matching);
+	add("indicative_price", indicative_price);
+	add("uncross_at_single_price", uncross_at_single_price);
+	add("cancel_immediate_or_cancel", cancel_immediate_or_cancel);
+}
+
+bool auction_test::queue_without_matching() {
+	elob::book book;
+	book.begin_auction();
+	const auto bid = book.insert<elob::order>(elob::side::bid, 101.0, 1.0);
+	const auto ask = book.insert<elob::order>(elob::side::ask, 99.0, 1.0);
+
+	return book.is_auction() && bid->is_queued() && ask->is_queued() &&
+	       book.get_bid_price() == 101.0 && book.get_ask_price() == 99.0 &&
+	       book.get_market_price() == -1.0;
+}
+
+bool auction_test::indicative_price() {
+	elob::book book;
+	book.begin_auction();
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+
+	if (book.get_indicative_price() != -1.0 ||
+	    book.get_indicative_volume() != 0.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 102.0, 3.0);
+	book.insert<elob::order>(elob::side::ask, 100.0, 2.0);
+
+	// 3.0 executes at 101.0 and 102.0; 101.0 is closer to the midpoint
+	if (book.get_indicative_price() != 101.0 ||
+	    book.get_indicative_volume() != 3.0) {
+		return false;
+	}
+
+	// 103.0 leaves the smallest imbalance
+	const auto bid = book.insert<elob::order>(elob::side::bid, 103.0, 5.0);
+
+	if (book.get_indicative_price() != 103.0 ||
+	    book.get_indicative_volume() != 3.0) {
+		return false;
+	}
+
+	bid->cancel();
+
+	return book.get_indicative_price() == 101.0 &&
+	       book.get_indicative_volume() == 3.0;
+}
+
+bool auction_test::uncross_at_single_price() {
+	elob::book book;
+	book.begin_auction();
+	const auto first =
+	    book.insert<elob::order>(elob::side::bid, 103.0, 2.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::bid, 101.0, 2.0);
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 101.0, 2.0);
+	const auto rest = book.insert<elob::order>(elob::side::ask, 102.0, 4.0);
+
+	book.uncross();
+
+	// 3.0 executes at 101.0; the second bid keeps 1.0
+	if (book.is_auction() || book.get_market_price() != 101.0 ||
+	    book.get_indicative_price() != -1.0 || first->is_queued() ||
+	    !second->is_queued() || second->get_quantity() != 1.0 ||
+	    book.get_ask_price() != 102.0 || rest->get_quantity() != 4.0) {
+		return false;
+	}
+
+	// continuous matching resumes
+	book.insert<elob::order>(elob::side::bid, 102.0, 1.0);
+
+	return rest->get_quantity() == 3.0 && book.get_market_price() == 102.0;
+}
+
+bool auction_test::cancel_immediate_or_cancel() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.begin_auction();
+	const auto ioc =
+	    book.insert<elob::order>(elob::side::bid, 100.0, 1.0, true);
+
+	return !ioc->is_queued() && ioc->get_quantity() == 1.0 &&
+	       book.get_ask_price() == 100.0;
+}
+
+#endif // #ifndef AUCTION_TEST_HPP
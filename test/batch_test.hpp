@@ -0,0 +1,134 @@
+#ifndef BATCH_TEST_HPP
+#define BATCH_TEST_HPP
+#include "test.hpp"
+
+class batch_test : public test {
+	inline static bool clear_at_boundary();
+	inline static bool skip_empty_batches();
+	inline static bool cancel_immediate_or_cancel();
+	inline static bool cancel_resting_immediate_or_cancel();
+	inline static bool resume_continuous_matching();
+
+	public:
+	batch_test();
+};
+
+#include "../include/book.hpp"
+
+batch_test::batch_test() : test("batch_test") {
+	add("clear_at_boundary", clear_at_boundary);
+	add("skip_empty_batches", skip_empty_batches);
+	add("cancel_immediate_or_cancel", cancel_immediate_or_cancel);
+	add("cancel_resting_immediate_or_cancel",
+	    cancel_resting_immediate_or_cancel);
+	add("resume_continuous_matching", resume_continuous_matching);
+}
+
+bool batch_test::clear_at_boundary() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 101.0, 2.0);
+	book.set_batch_interval(100);
+	const auto bid = book.insert<elob::order>(elob::side::bid, 102.0, 3.0);
+	const auto ask = book.insert<elob::order>(elob::side::ask, 100.0, 2.0);
+	book.advance_time(99);
+
+	if (!bid->is_queued() || !ask->is_queued() ||
+	    book.get_market_price() != -1.0 ||
+	    book.get_indicative_price() != -1.0) {
+		return false;
+	}
+
+	book.advance_time(100);
+
+	// the resting ask and the batch clear at a uniform price
+	return book.get_market_price() == 101.0 && !bid->is_queued() &&
+	       !ask->is_queued() && book.get_ask_price() == 101.0 &&
+	       book.ask_limit_at(101.0)->second.get_quantity() == 1.0 &&
+	       book.is_auction() && book.get_time() == 100;
+}
+
+bool batch_test::skip_empty_batches() {
+	elob::book book;
+	book.set_batch_interval(10);
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.advance_time(1000000000);
+
+	if (book.get_market_price() != 100.0 ||
+	    book.get_bid_price() != elob::min_price) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 101.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	book.advance_time(1000000009);
+
+	if (book.get_market_price() != 100.0) {
+		return false;
+	}
+
+	book.advance_time(1000000010);
+
+	return book.get_market_price() == 101.0;
+}
+
+bool batch_test::cancel_immediate_or_cancel() {
+	elob::book book;
+	book.set_batch_interval(10);
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	const auto ioc =
+	    book.insert<elob::order>(elob::side::bid, 100.0, 3.0, true);
+
+	if (!ioc->is_queued()) {
+		return false;
+	}
+
+	book.advance_time(10);
+
+	return !ioc->is_queued() && ioc->get_quantity() == 2.0 &&
+	       book.get_bid_price() == elob::min_price &&
+	       book.get_market_price() == 100.0;
+}
+
+bool batch_test::cancel_resting_immediate_or_cancel() {
+	elob::book book;
+	book.set_batch_interval(10);
+	book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	book.advance_time(10);
+
+	// the order does not cross, but is canceled all the same
+	const auto ioc =
+	    book.insert<elob::order>(elob::side::bid, 100.0, 1.0, true);
+	book.advance_time(25);
+
+	if (ioc->is_queued() || book.get_bid_price() != elob::min_price) {
+		return false;
+	}
+
+	const auto ask = book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.advance_time(500);
+	return ask->is_queued() && ask->get_quantity() == 1.0 &&
+	       book.get_market_price() == -1.0;
+}
+
+bool batch_test::resume_continuous_matching() {
+	elob::book book;
+	book.set_batch_interval(10);
+	const auto bid = book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 99.0, 2.0);
+
+	// the pending batch is cleared at once
+	book.set_batch_interval(0);
+
+	if (book.is_auction() || bid->is_queued() ||
+	    book.get_market_price() != 99.0 ||
+	    book.ask_limit_at(99.0)->second.get_quantity() != 1.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+
+	return book.get_ask_price() == elob::max_price;
+}
+
+#endif // #ifndef BATCH_TEST_HPP
@@ -0,0 +1,110 @@
+#ifndef CASCADE_TEST_HPP
+#define CASCADE_TEST_HPP
+#include "test.hpp"
+
+class cascade_test : public test {
+	inline static bool run_deep_cascade();
+	inline static bool chain_triggers_iteratively();
+	inline static bool keep_price_time_order();
+
+	public:
+	cascade_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/stop.hpp"
+#include <vector>
+
+cascade_test::cascade_test() : test("cascade_test") {
+	add("run_deep_cascade", run_deep_cascade);
+	add("chain_triggers_iteratively", chain_triggers_iteratively);
+	add("keep_price_time_order", keep_price_time_order);
+}
+
+bool cascade_test::run_deep_cascade() {
+	constexpr int depth = 2000;
+	elob::book book;
+	std::vector<elob::trigger_ptr> stops;
+
+	// every stop sells into the next bid, which fires the next stop
+	for (int i = 0; i <= depth; ++i) {
+		book.insert<elob::order>(elob::side::bid, 5000.0 - i, 1.0);
+	}
+
+	for (int i = 1; i <= depth; ++i) {
+		stops.push_back(std::make_shared<elob::stop_order>(
+		    elob::side::bid, 5001.0 - i,
+		    std::make_shared<elob::order>(
+			elob::side::ask, 5000.0 - i, 1.0)));
+		book.insert(stops.back());
+	}
+
+	book.insert<elob::order>(elob::side::ask, 5000.0, 1.0);
+	const auto &stats = book.get_cascade_stats();
+
+	return stats.wave_count == depth && stats.max_wave_size == 1 &&
+	       stats.order_count == depth && stats.trigger_count == depth &&
+	       book.get_market_price() == 5000.0 - depth &&
+	       book.bid_limits_begin() == book.bid_limits_end();
+}
+
+bool cascade_test::chain_triggers_iteratively() {
+	constexpr int length = 50000;
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 90.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 90.0, 1.0);
+
+	// every stop inserts the next one, which fires on insertion
+	elob::trigger_ptr chain =
+	    std::make_shared<elob::trigger>(elob::side::bid, 100.0);
+	const auto last = chain;
+
+	for (int i = 0; i < length; ++i) {
+		chain = std::make_shared<elob::stop_trigger>(
+		    elob::side::bid, 100.0, chain);
+	}
+
+	book.insert(chain);
+	const auto &stats = book.get_cascade_stats();
+
+	return stats.wave_count == length && stats.max_wave_size == 1 &&
+	       stats.order_count == 0 && stats.trigger_count == length + 1 &&
+	       !last->is_queued() && last->get_book() == nullptr;
+}
+
+bool cascade_test::keep_price_time_order() {
+	elob::book book;
+	std::vector<elob::order_ptr> orders;
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 98.0, 1.0);
+
+	// the better priced stops fire first and each level in the order
+	// in which its stops were inserted
+	for (int i = 0; i < 10; ++i) {
+		orders.push_back(
+		    std::make_shared<elob::order>(elob::side::ask, 110.0, 1.0));
+		book.insert(std::make_shared<elob::stop_order>(
+		    elob::side::bid, i % 2 == 0 ? 98.0 : 99.0, orders.back()));
+	}
+
+	book.insert<elob::order>(elob::side::ask, 98.0, 2.0);
+	const auto &stats = book.get_cascade_stats();
+
+	if (stats.wave_count != 1 || stats.max_wave_size != 10 ||
+	    stats.trigger_count != 10) {
+		return false;
+	}
+
+	auto &limit = book.ask_limit_at(110.0)->second;
+	auto order_it = limit.begin();
+
+	for (const int i : {1, 3, 5, 7, 9, 0, 2, 4, 6, 8}) {
+		if (*(order_it++) != orders[i]) {
+			return false;
+		}
+	}
+
+	return limit.order_count() == 10;
+}
+
+#endif // #ifndef CASCADE_TEST_HPP
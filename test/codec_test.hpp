@@ -0,0 +1,66 @@
+#ifndef CODEC_TEST_HPP
+#define CODEC_TEST_HPP
+#include "test.hpp"
+
+class codec_test : public test {
+	inline static bool round_trip();
+	inline static bool check_partial_message();
+	inline static bool check_malformed_message();
+
+	public:
+	codec_test();
+};
+
+#include "../include/codec.hpp"
+
+codec_test::codec_test() : test("codec_test") {
+	add("round_trip", round_trip);
+	add("check_partial_message", check_partial_message);
+	add("check_malformed_message", check_malformed_message);
+}
+
+bool codec_test::round_trip() {
+	char buffer[elob::codec::max_message_length];
+	elob::codec::level_message_encoder(buffer)
+	    .encode_header()
+	    .batch(7)
+	    .price(101.5)
+	    .quantity(3.0)
+	    .aon_quantity(1.0)
+	    .order_count(4)
+	    .side(1);
+
+	const elob::codec::header_decoder header(buffer);
+	const elob::codec::level_message_decoder message(buffer);
+
+	return header.template_id() ==
+		   elob::codec::level_message_decoder::template_id &&
+	       header.message_length() ==
+		   elob::codec::level_message_decoder::encoded_length &&
+	       message.batch() == 7 && message.price() == 101.5 &&
+	       message.quantity() == 3.0 && message.aon_quantity() == 1.0 &&
+	       message.order_count() == 4 && message.side() == 1;
+}
+
+bool codec_test::check_partial_message() {
+	char buffer[elob::codec::max_message_length];
+	elob::codec::cancel_message_encoder(buffer).encode_header().token(1);
+	const std::size_t length =
+	    elob::codec::cancel_message_encoder::encoded_length;
+
+	return elob::codec::check(buffer, 4) == 0 &&
+	       elob::codec::check(buffer, length - 1) == 0 &&
+	       elob::codec::check(buffer, length) == length;
+}
+
+bool codec_test::check_malformed_message() {
+	char buffer[elob::codec::max_message_length];
+	elob::codec::insert_message_encoder(buffer).encode_header();
+	// shorter block than the schema requires
+	elob::codec::header_encoder(buffer).encode(
+	    4, elob::codec::insert_message_encoder::template_id);
+
+	return elob::codec::check(buffer, sizeof(buffer)) == SIZE_MAX;
+}
+
+#endif // #ifndef CODEC_TEST_HPP
@@ -0,0 +1,166 @@
+#ifndef EXPIRY_TEST_HPP
+#define EXPIRY_TEST_HPP
+#include "test.hpp"
+
+class expiry_test : public test {
+	inline static bool expire_in_order();
+	inline static bool change_expiry();
+	inline static bool reject_expired();
+	inline static bool expire_all_levels();
+
+	public:
+	expiry_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/trigger.hpp"
+#include <vector>
+
+namespace {
+
+class expiring_order : public elob::order {
+	public:
+	std::vector<std::uint64_t> *m_canceled_at;
+
+	expiring_order(const elob::side t_side, const double t_price,
+	    const double t_quantity, const std::uint64_t t_expiry,
+	    std::vector<std::uint64_t> *t_canceled_at)
+	    : elob::order(t_side, t_price, t_quantity),
+	      m_canceled_at(t_canceled_at) {
+		set_expiry(t_expiry);
+	}
+
+	void on_canceled() override {
+		m_canceled_at->push_back(get_book()->get_time());
+	}
+};
+
+} // namespace
+
+expiry_test::expiry_test() : test("expiry_test") {
+	add("expire_in_order", expire_in_order);
+	add("change_expiry", change_expiry);
+	add("reject_expired", reject_expired);
+	add("expire_all_levels", expire_all_levels);
+}
+
+bool expiry_test::expire_in_order() {
+	elob::book book;
+	std::vector<std::uint64_t> canceled_at;
+
+	// the expiries span several levels of the timer wheel
+	const auto late = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 300000, &canceled_at);
+	const auto early = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 5, &canceled_at);
+	const auto middle = book.insert<expiring_order>(
+	    elob::side::ask, 101.0, 1.0, 4100, &canceled_at);
+	const auto gtc = book.insert<elob::order>(elob::side::ask, 102.0, 1.0);
+	const auto trigger =
+	    std::make_shared<elob::trigger>(elob::side::bid, 90.0);
+	trigger->set_expiry(70);
+	book.insert(trigger);
+
+	book.advance_time(4);
+
+	if (!canceled_at.empty() || !early->is_queued() ||
+	    !trigger->is_queued()) {
+		return false;
+	}
+
+	book.advance_time(4100);
+
+	if (canceled_at != std::vector<std::uint64_t>{5, 4100} ||
+	    early->is_queued() || middle->is_queued() ||
+	    trigger->is_queued() || !late->is_queued() ||
+	    book.ask_limit_at(101.0) != book.ask_limits_end()) {
+		return false;
+	}
+
+	book.advance_time(1000000);
+
+	return canceled_at == std::vector<std::uint64_t>{5, 4100, 300000} &&
+	       !late->is_queued() && late->get_book() == nullptr &&
+	       book.bid_limit_at(99.0) == book.bid_limits_end() &&
+	       gtc->is_queued() && book.get_time() == 1000000;
+}
+
+bool expiry_test::change_expiry() {
+	elob::book book;
+	std::vector<std::uint64_t> canceled_at;
+	const auto order = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 10, &canceled_at);
+	const auto other = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 50, &canceled_at);
+
+	order->set_expiry(20);
+	other->set_expiry(30);
+	book.advance_time(15);
+
+	if (!order->is_queued() || !canceled_at.empty()) {
+		return false;
+	}
+
+	book.advance_time(25);
+
+	if (order->is_queued() || canceled_at.size() != 1) {
+		return false;
+	}
+
+	// the expiry has passed already
+	other->set_expiry(25);
+
+	return !other->is_queued() && canceled_at.size() == 2 &&
+	       book.bid_limit_at(99.0) == book.bid_limits_end();
+}
+
+bool expiry_test::reject_expired() {
+	elob::book book;
+	std::vector<std::uint64_t> canceled_at;
+	book.advance_time(50);
+
+	const auto expired = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 50, &canceled_at);
+	const auto order = book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 51, &canceled_at);
+
+	if (expired->is_queued() || !order->is_queued()) {
+		return false;
+	}
+
+	// filled orders do not expire
+	book.insert<elob::order>(elob::side::ask, 99.0, 1.0);
+	book.advance_time(60);
+
+	return canceled_at.empty() && !order->is_queued();
+}
+
+bool expiry_test::expire_all_levels() {
+	elob::book book;
+	std::vector<std::uint64_t> canceled_at;
+	book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 1.0, 100, &canceled_at);
+	book.insert<expiring_order>(
+	    elob::side::bid, 99.0, 2.0, 200, &canceled_at);
+	book.insert<expiring_order>(
+	    elob::side::ask, 101.0, 1.0, 100, &canceled_at);
+	const auto gtc = book.insert<elob::order>(elob::side::ask, 101.0, 2.0);
+	book.insert<expiring_order>(
+	    elob::side::ask, 101.0, 3.0, 100, &canceled_at);
+
+	book.expire_all();
+
+	if (canceled_at.size() != 4 ||
+	    book.bid_limit_at(99.0) != book.bid_limits_end() ||
+	    book.ask_limit_at(101.0)->second.get_quantity() != 2.0 ||
+	    book.ask_limit_at(101.0)->second.order_count() != 1) {
+		return false;
+	}
+
+	// the timers of the expired orders have no effect
+	book.advance_time(1000);
+
+	return canceled_at.size() == 4 && gtc->is_queued();
+}
+
+#endif // #ifndef EXPIRY_TEST_HPP
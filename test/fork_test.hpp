@@ -0,0 +1,85 @@
+#ifndef FORK_TEST_HPP
+#define FORK_TEST_HPP
+#include "test.hpp"
+
+class fork_test : public test {
+	inline static bool fork_leaves_book_unchanged();
+	inline static bool book_leaves_fork_unchanged();
+	inline static bool fork_outlives_book();
+
+	public:
+	fork_test();
+};
+
+#include "../include/book.hpp"
+
+fork_test::fork_test() : test("fork_test") {
+	add("fork_leaves_book_unchanged", fork_leaves_book_unchanged);
+	add("book_leaves_fork_unchanged", book_leaves_fork_unchanged);
+	add("fork_outlives_book", fork_outlives_book);
+}
+
+bool fork_test::fork_leaves_book_unchanged() {
+	elob::book book;
+	const auto ask = book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+	book.insert<elob::order>(elob::side::ask, 102.0, 5.0);
+	book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+
+	auto fork = book.fork();
+	fork->insert<elob::order>(elob::side::bid, 102.0, 7.0);
+
+	return fork->get_ask_price() == 102.0 &&
+	       fork->ask_limit_at(102.0)->second.get_quantity() == 3.0 &&
+	       fork->get_market_price() == 102.0 &&
+	       book.get_ask_price() == 101.0 &&
+	       book.ask_limit_at(101.0)->second.get_quantity() == 5.0 &&
+	       book.get_market_price() == -1.0 && ask->is_queued() &&
+	       ask->get_quantity() == 5.0 && ask->get_book() == &book;
+}
+
+bool fork_test::book_leaves_fork_unchanged() {
+	elob::book book;
+	const auto bid = book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	book.insert<elob::order>(elob::side::bid, 99.0, 2.0, false, true);
+
+	auto fork = book.fork();
+	bid->set_quantity(3.0);
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+
+	const auto &limit = fork->bid_limit_at(99.0)->second;
+
+	if (limit.get_quantity() != 5.0 || limit.get_aon_quantity() != 2.0 ||
+	    limit.order_count() != 2) {
+		return false;
+	}
+
+	bid->cancel();
+
+	// the fork executes against its copies of the orders
+	fork->insert<elob::order>(elob::side::ask, 99.0, 7.0);
+
+	return fork->bid_limit_at(99.0) == fork->bid_limits_end() &&
+	       fork->get_market_price() == 99.0 &&
+	       book.bid_limit_at(99.0)->second.get_quantity() == 1.0 &&
+	       book.bid_limit_at(99.0)->second.get_aon_quantity() == 2.0 &&
+	       !bid->is_queued() && bid->get_quantity() == 3.0;
+}
+
+bool fork_test::fork_outlives_book() {
+	auto book = std::make_unique<elob::book>();
+	const auto ask = book->insert<elob::order>(elob::side::ask, 101.0, 5.0);
+
+	auto fork = book->fork();
+	book.reset();
+
+	if (ask->is_queued() || ask->get_book() != nullptr) {
+		return false;
+	}
+
+	fork->insert<elob::order>(elob::side::bid, 101.0, 2.0);
+
+	return fork->ask_limit_at(101.0)->second.get_quantity() == 3.0 &&
+	       ask->get_quantity() == 5.0;
+}
+
+#endif // #ifndef FORK_TEST_HPP
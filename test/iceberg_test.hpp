@@ -0,0 +1,123 @@
+#ifndef ICEBERG_TEST_HPP
+#define ICEBERG_TEST_HPP
+#include "test.hpp"
+
+class iceberg_test : public test {
+	inline static bool replenish_in_place();
+	inline static bool trade_several_slices();
+	inline static bool trade_entire_quantity_on_entry();
+	inline static bool fill_all_or_nothing_from_hidden();
+	inline static bool hide_behind_all_or_nothing();
+
+	public:
+	iceberg_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/iceberg.hpp"
+
+iceberg_test::iceberg_test() : test("iceberg_test") {
+	add("replenish_in_place", replenish_in_place);
+	add("trade_several_slices", trade_several_slices);
+	add("trade_entire_quantity_on_entry", trade_entire_quantity_on_entry);
+	add("fill_all_or_nothing_from_hidden",
+	    fill_all_or_nothing_from_hidden);
+	add("hide_behind_all_or_nothing", hide_behind_all_or_nothing);
+}
+
+bool iceberg_test::replenish_in_place() {
+	elob::book book;
+	const auto iceberg =
+	    book.insert<elob::iceberg>(elob::side::ask, 101.0, 10.0, 3.0);
+	const auto order =
+	    book.insert<elob::order>(elob::side::ask, 101.0, 2.0);
+	auto &limit = book.ask_limit_at(101.0)->second;
+
+	if (limit.get_quantity() != 5.0 || limit.get_hidden_quantity() != 7.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 101.0, 3.0);
+
+	if (limit.get_quantity() != 5.0 || limit.get_hidden_quantity() != 4.0 ||
+	    limit.order_count() != 2 || *limit.begin() != order) {
+		return false;
+	}
+
+	// the replenished slice queues behind the other order
+	book.insert<elob::order>(elob::side::bid, 101.0, 2.0);
+
+	return !order->is_queued() && iceberg->get_quantity() == 3.0 &&
+	       iceberg->get_hidden_quantity() == 4.0;
+}
+
+bool iceberg_test::trade_several_slices() {
+	elob::book book;
+	const auto iceberg =
+	    book.insert<elob::iceberg>(elob::side::ask, 101.0, 10.0, 3.0);
+	const auto order =
+	    book.insert<elob::order>(elob::side::bid, 101.0, 9.0);
+
+	const auto &limit = book.ask_limit_at(101.0)->second;
+
+	return order->get_quantity() == 0.0 &&
+	       iceberg->get_quantity() == 1.0 &&
+	       iceberg->get_hidden_quantity() == 0.0 &&
+	       limit.get_quantity() == 1.0 &&
+	       limit.get_hidden_quantity() == 0.0;
+}
+
+bool iceberg_test::trade_entire_quantity_on_entry() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 101.0, 4.0);
+	const auto iceberg =
+	    book.insert<elob::iceberg>(elob::side::bid, 101.0, 10.0, 3.0);
+
+	const auto &limit = book.bid_limit_at(101.0)->second;
+
+	return book.ask_limit_at(101.0) == book.ask_limits_end() &&
+	       iceberg->get_quantity() == 3.0 &&
+	       iceberg->get_hidden_quantity() == 3.0 &&
+	       limit.get_quantity() == 3.0 &&
+	       limit.get_hidden_quantity() == 3.0;
+}
+
+bool iceberg_test::fill_all_or_nothing_from_hidden() {
+	elob::book book;
+	const auto iceberg =
+	    book.insert<elob::iceberg>(elob::side::ask, 101.0, 10.0, 3.0);
+	const auto order = book.insert<elob::order>(
+	    elob::side::bid, 101.0, 6.0, false, true);
+
+	return !order->is_queued() && order->get_quantity() == 0.0 &&
+	       iceberg->get_quantity() == 3.0 &&
+	       iceberg->get_hidden_quantity() == 1.0;
+}
+
+bool iceberg_test::hide_behind_all_or_nothing() {
+	elob::book book;
+	book.insert<elob::iceberg>(elob::side::ask, 100.0, 50.0, 10.0);
+	const auto aon = book.insert<elob::order>(
+	    elob::side::ask, 100.0, 45.0, false, true);
+
+	// the first slice, the all-or-nothing order and the hidden
+	// quantity trade in this order
+	const auto impact =
+	    book.simulate_market_order(elob::side::bid, 60.0, 100.0);
+
+	if (impact.filled_quantity != 60.0) {
+		return false;
+	}
+
+	const auto bid = book.insert<elob::order>(
+	    elob::side::bid, 100.0, 60.0, false, true);
+
+	return !bid->is_queued() && bid->get_quantity() == 0.0 &&
+	       !aon->is_queued() &&
+	       book.ask_limit_at(100.0)->second.get_hidden_quantity() +
+		       book.ask_limit_at(100.0)->second.get_quantity() ==
+		   35.0 &&
+	       book.get_bid_price() == elob::min_price;
+}
+
+#endif // #ifndef ICEBERG_TEST_HPP
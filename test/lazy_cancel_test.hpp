@@ -0,0 +1,190 @@
+#ifndef LAZY_CANCEL_TEST_HPP
+#define LAZY_CANCEL_TEST_HPP
+#include "test.hpp"
+
+class lazy_cancel_test : public test {
+	inline static bool match_eager_fifo();
+	inline static bool match_eager_pro_rata();
+	inline static bool compact_levels();
+
+	public:
+	lazy_cancel_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/iceberg.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// compares the levels in [t_eager, t_eager_end) with those of the lazy book
+template <class Iterator>
+bool same_levels(Iterator t_eager, const Iterator t_eager_end,
+    Iterator t_lazy, const Iterator t_lazy_end) {
+	for (; t_eager != t_eager_end; ++t_eager, ++t_lazy) {
+		if (t_lazy == t_lazy_end || t_eager->first != t_lazy->first ||
+		    t_eager->second.get_quantity() !=
+			t_lazy->second.get_quantity() ||
+		    t_eager->second.get_aon_quantity() !=
+			t_lazy->second.get_aon_quantity() ||
+		    t_eager->second.get_hidden_quantity() !=
+			t_lazy->second.get_hidden_quantity() ||
+		    t_eager->second.order_count() !=
+			t_lazy->second.order_count()) {
+			return false;
+		}
+	}
+
+	return t_lazy == t_lazy_end;
+}
+
+// runs the same cancel-heavy flow against an eager and a lazy book
+bool match_eager(const elob::matching_policy t_policy) {
+	elob::book eager(t_policy);
+	elob::book lazy(t_policy);
+	lazy.set_lazy_cancel(true);
+	std::vector<elob::order_ptr> eager_orders;
+	std::vector<elob::order_ptr> lazy_orders;
+	std::uint32_t seed = 12345;
+
+	const auto next = [&seed](const std::uint32_t t_range) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % t_range;
+	};
+
+	for (int step = 0; step < 4000; ++step) {
+		const std::uint32_t action = next(20);
+
+		if (action < 12 || eager_orders.empty()) {
+			const auto side =
+			    next(2) == 0 ? elob::side::bid : elob::side::ask;
+			const double offset = 1.0 + next(4);
+			const double price =
+			    side == elob::side::bid ? 100.0 - offset
+						    : 100.0 + offset;
+			const double quantity = 1.0 + next(5);
+
+			if (next(8) == 0) {
+				eager_orders.push_back(
+				    eager.insert<elob::iceberg>(side, price,
+					quantity * 3.0, quantity));
+				lazy_orders.push_back(
+				    lazy.insert<elob::iceberg>(side, price,
+					quantity * 3.0, quantity));
+			} else {
+				const bool aon = next(10) == 0;
+				eager_orders.push_back(
+				    eager.insert<elob::order>(
+					side, price, quantity, false, aon));
+				lazy_orders.push_back(
+				    lazy.insert<elob::order>(
+					side, price, quantity, false, aon));
+			}
+		} else if (action < 19) {
+			const std::size_t i = next(eager_orders.size());
+
+			if (eager_orders[i]->cancel() !=
+			    lazy_orders[i]->cancel()) {
+				return false;
+			}
+		} else {
+			// trades pass over the entries of canceled orders
+			const auto side =
+			    next(2) == 0 ? elob::side::bid : elob::side::ask;
+			const double price =
+			    side == elob::side::bid ? 103.0 : 97.0;
+			const double quantity = 1.0 + next(12);
+			eager_orders.push_back(eager.insert<elob::order>(
+			    side, price, quantity, true));
+			lazy_orders.push_back(lazy.insert<elob::order>(
+			    side, price, quantity, true));
+		}
+
+		if (eager.get_market_price() != lazy.get_market_price() ||
+		    !same_levels(eager.bid_limits_begin(),
+			eager.bid_limits_end(), lazy.bid_limits_begin(),
+			lazy.bid_limits_end()) ||
+		    !same_levels(eager.ask_limits_begin(),
+			eager.ask_limits_end(), lazy.ask_limits_begin(),
+			lazy.ask_limits_end())) {
+			return false;
+		}
+	}
+
+	for (std::size_t i = 0; i < eager_orders.size(); ++i) {
+		if (eager_orders[i]->get_quantity() !=
+			lazy_orders[i]->get_quantity() ||
+		    eager_orders[i]->is_queued() !=
+			lazy_orders[i]->is_queued()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+lazy_cancel_test::lazy_cancel_test() : test("lazy_cancel_test") {
+	add("match_eager_fifo", match_eager_fifo);
+	add("match_eager_pro_rata", match_eager_pro_rata);
+	add("compact_levels", compact_levels);
+}
+
+bool lazy_cancel_test::match_eager_fifo() { return match_eager(elob::fifo); }
+
+bool lazy_cancel_test::match_eager_pro_rata() {
+	return match_eager(elob::pro_rata);
+}
+
+bool lazy_cancel_test::compact_levels() {
+	elob::book book;
+	book.set_lazy_cancel(true);
+	std::vector<elob::order_ptr> orders;
+
+	for (int i = 0; i < 10; ++i) {
+		orders.push_back(
+		    book.insert<elob::order>(elob::side::bid, 100.0, 1.0 + i));
+	}
+
+	orders[1]->cancel();
+	orders[4]->cancel();
+	orders[5]->cancel();
+	const auto fork = book.fork();
+	auto &limit = book.bid_limit_at(100.0)->second;
+
+	if (limit.order_count() != 7 || limit.get_quantity() != 42.0 ||
+	    fork->bid_limit_at(100.0)->second.order_count() != 7) {
+		return false;
+	}
+
+	book.compact();
+	std::size_t walked = 0;
+
+	for (const auto &order_obj : limit) {
+		if (order_obj == nullptr) {
+			return false;
+		}
+
+		++walked;
+	}
+
+	// a level is erased once its last order is canceled
+	for (const int i : {0, 2, 3, 6, 7, 8}) {
+		orders[i]->cancel();
+	}
+
+	if (walked != 7 || limit.order_count() != 1 || !orders[9]->cancel() ||
+	    book.bid_limit_at(100.0) != book.bid_limits_end()) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 100.0, 2.0);
+	return book.bid_limit_at(100.0)->second.order_count() == 1 &&
+	       book.bid_limit_at(100.0)->second.get_quantity() == 2.0 &&
+	       fork->bid_limit_at(100.0)->second.get_quantity() == 42.0 &&
+	       book.is_lazy_cancel() && fork->is_lazy_cancel();
+}
+
+#endif // #ifndef LAZY_CANCEL_TEST_HPP
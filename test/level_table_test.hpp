@@ -0,0 +1,143 @@
+#ifndef LEVEL_TABLE_TEST_HPP
+#define LEVEL_TABLE_TEST_HPP
+#include "test.hpp"
+
+class level_table_test : public test {
+	inline static bool reuse_handles();
+	inline static bool keep_handles_in_forks();
+	inline static bool recycle_levels();
+
+	public:
+	level_table_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/peg.hpp"
+#include "../include/trigger.hpp"
+#include <vector>
+
+level_table_test::level_table_test() : test("level_table_test") {
+	add("reuse_handles", reuse_handles);
+	add("keep_handles_in_forks", keep_handles_in_forks);
+	add("recycle_levels", recycle_levels);
+}
+
+bool level_table_test::reuse_handles() {
+	elob::book book;
+	std::vector<elob::order_ptr> orders;
+	std::vector<elob::trigger_ptr> triggers;
+
+	for (int i = 0; i < 10; ++i) {
+		orders.push_back(
+		    book.insert<elob::order>(elob::side::bid, 90.0 + i, 1.0));
+		triggers.push_back(std::make_shared<elob::trigger>(
+		    elob::side::ask, 110.0 + i));
+		book.insert(triggers.back());
+	}
+
+	// the handles of the erased levels are given to new ones
+	for (int i = 0; i < 10; i += 2) {
+		orders[i]->cancel();
+		triggers[i]->cancel();
+	}
+
+	for (int i = 0; i < 5; ++i) {
+		orders.push_back(
+		    book.insert<elob::order>(elob::side::ask, 120.0 + i, 1.0));
+		triggers.push_back(std::make_shared<elob::trigger>(
+		    elob::side::bid, 80.0 + i));
+		book.insert(triggers.back());
+	}
+
+	orders[3]->set_quantity(4.0);
+	orders[12]->set_quantity(2.0);
+	triggers[5]->set_price(130.0);
+
+	if (!orders[5]->cancel() || !orders[14]->cancel() ||
+	    !triggers[7]->cancel() || !triggers[13]->cancel() ||
+	    !triggers[5]->is_queued()) {
+		return false;
+	}
+
+	return book.bid_limit_at(93.0)->second.get_quantity() == 4.0 &&
+	       book.ask_limit_at(122.0)->second.get_quantity() == 2.0 &&
+	       book.bid_limit_at(95.0) == book.bid_limits_end() &&
+	       book.ask_limit_at(124.0) == book.ask_limits_end();
+}
+
+bool level_table_test::keep_handles_in_forks() {
+	elob::book book;
+	const auto bid = book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	const auto ask = book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	const auto fork = book.fork();
+
+	// both books create levels with the same handles
+	bid->cancel();
+	const auto other =
+	    book.insert<elob::order>(elob::side::bid, 98.0, 2.0);
+	fork->insert<elob::order>(elob::side::bid, 97.0, 3.0);
+	fork->insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	const elob::order_ptr copy = *fork->ask_limit_at(101.0)->second.begin();
+	copy->set_quantity(5.0);
+	ask->set_quantity(4.0);
+
+	if (!copy->cancel() || !other->cancel()) {
+		return false;
+	}
+
+	return book.bid_limit_at(98.0) == book.bid_limits_end() &&
+	       book.ask_limit_at(101.0)->second.get_quantity() == 4.0 &&
+	       fork->ask_limit_at(101.0)->second.get_quantity() == 1.0 &&
+	       fork->bid_limit_at(99.0)->second.get_quantity() == 1.0 &&
+	       fork->bid_limit_at(97.0)->second.get_quantity() == 3.0;
+}
+
+bool level_table_test::recycle_levels() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 102.0, 1.0);
+
+	// the touch empties and refills, leaving rounding residues in
+	// the quantity of the level before it is emptied
+	for (int i = 0; i < 100; ++i) {
+		const auto bid =
+		    book.insert<elob::order>(elob::side::bid, 100.0, 0.3);
+		const auto other =
+		    book.insert<elob::order>(elob::side::bid, 100.0, 0.1);
+		other->cancel();
+		bid->cancel();
+		book.insert<elob::order>(elob::side::ask, 101.0 + i % 2, 0.7)
+		    ->cancel();
+	}
+
+	const auto refill =
+	    book.insert<elob::order>(elob::side::bid, 100.0, 0.1);
+
+	if (book.bid_limit_at(100.0)->second.get_quantity() != 0.1) {
+		return false;
+	}
+
+	refill->cancel();
+
+	// spare nodes move between the sides and the peg groups
+	const auto peg = book.insert<elob::peg>(
+	    elob::side::bid, elob::primary_peg, -1.0, 2.0);
+	book.insert<elob::order>(elob::side::bid, 99.0, 0.1);
+	book.insert<elob::order>(elob::side::bid, 98.0, 0.2);
+	book.insert<elob::order>(elob::side::ask, 99.0, 0.1);
+
+	if (book.bid_limits_begin()->first != 98.0 ||
+	    book.bid_limits_begin()->second.get_quantity() != 0.2 ||
+	    std::next(book.bid_limits_begin()) != book.bid_limits_end() ||
+	    book.ask_limits_begin()->first != 102.0 ||
+	    std::next(book.ask_limits_begin()) != book.ask_limits_end() ||
+	    peg->get_price() != 97.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 100.0, 0.1);
+	return book.get_bid_price() == 100.0 &&
+	       book.bid_limit_at(100.0)->second.get_quantity() == 0.1 &&
+	       book.bid_limit_at(100.0)->second.order_count() == 1;
+}
+
+#endif // #ifndef LEVEL_TABLE_TEST_HPP
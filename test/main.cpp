@@ -1,4 +1,27 @@
+#include "auction_test.hpp"
+#include "batch_test.hpp"
+#include "cascade_test.hpp"
+#include "codec_test.hpp"
+#include "expiry_test.hpp"
+#include "fork_test.hpp"
 #include "gtc_test.hpp"
+#include "iceberg_test.hpp"
+#include "lazy_cancel_test.hpp"
+#include "level_table_test.hpp"
+#include "market_impact_test.hpp"
+#include "matching_policy_test.hpp"
+#include "order_group_test.hpp"
+#include "ownership_test.hpp"
+#include "participant_test.hpp"
+#include "peg_test.hpp"
+#include "quantity_index_test.hpp"
+#include "replace_test.hpp"
+#include "risk_test.hpp"
+#include "shm_feed_test.hpp"
+#include "side_test.hpp"
+#include "slot_list_test.hpp"
+#include "snapshot_test.hpp"
+#include "trigger_ladder_test.hpp"
 
 int main() {
 	gtc_test gtc_test_obj;
@@ -7,5 +30,74 @@ int main() {
 	gtc_test gtc_test_ob2;
 	gtc_test_ob2.run();
 
+	snapshot_test snapshot_test_obj;
+	snapshot_test_obj.run();
+
+	shm_feed_test shm_feed_test_obj;
+	shm_feed_test_obj.run();
+
+	codec_test codec_test_obj;
+	codec_test_obj.run();
+
+	fork_test fork_test_obj;
+	fork_test_obj.run();
+
+	market_impact_test market_impact_test_obj;
+	market_impact_test_obj.run();
+
+	ownership_test ownership_test_obj;
+	ownership_test_obj.run();
+
+	replace_test replace_test_obj;
+	replace_test_obj.run();
+
+	iceberg_test iceberg_test_obj;
+	iceberg_test_obj.run();
+
+	peg_test peg_test_obj;
+	peg_test_obj.run();
+
+	expiry_test expiry_test_obj;
+	expiry_test_obj.run();
+
+	auction_test auction_test_obj;
+	auction_test_obj.run();
+
+	batch_test batch_test_obj;
+	batch_test_obj.run();
+
+	matching_policy_test matching_policy_test_obj;
+	matching_policy_test_obj.run();
+
+	side_test side_test_obj;
+	side_test_obj.run();
+
+	quantity_index_test quantity_index_test_obj;
+	quantity_index_test_obj.run();
+
+	level_table_test level_table_test_obj;
+	level_table_test_obj.run();
+
+	slot_list_test slot_list_test_obj;
+	slot_list_test_obj.run();
+
+	lazy_cancel_test lazy_cancel_test_obj;
+	lazy_cancel_test_obj.run();
+
+	trigger_ladder_test trigger_ladder_test_obj;
+	trigger_ladder_test_obj.run();
+
+	cascade_test cascade_test_obj;
+	cascade_test_obj.run();
+
+	order_group_test order_group_test_obj;
+	order_group_test_obj.run();
+
+	participant_test participant_test_obj;
+	participant_test_obj.run();
+
+	risk_test risk_test_obj;
+	risk_test_obj.run();
+
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,67 @@
+#ifndef MARKET_IMPACT_TEST_HPP
+#define MARKET_IMPACT_TEST_HPP
+#include "test.hpp"
+
+class market_impact_test : public test {
+	inline static bool simulate_market_order();
+	inline static bool simulate_market_orders();
+
+	public:
+	market_impact_test();
+};
+
+#include "../include/book.hpp"
+
+market_impact_test::market_impact_test() : test("market_impact_test") {
+	add("simulate_market_order", simulate_market_order);
+	add("simulate_market_orders", simulate_market_orders);
+}
+
+bool market_impact_test::simulate_market_order() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+	book.insert<elob::order>(elob::side::ask, 102.0, 4.0, false, true);
+	book.insert<elob::order>(elob::side::ask, 102.0, 2.0);
+	book.insert<elob::order>(elob::side::ask, 103.0, 10.0);
+
+	// the all-or-nothing ask at 102.0 is too large to be filled
+	const auto impact =
+	    book.simulate_market_order(elob::side::bid, 8.0, elob::max_price);
+
+	// the book is left untouched and trades the same way
+	auto fork = book.fork();
+	fork->insert<elob::order>(elob::side::bid, elob::max_price, 8.0);
+
+	return impact.filled_quantity == 8.0 &&
+	       impact.remaining_quantity == 0.0 &&
+	       impact.notional == 5.0 * 101.0 + 2.0 * 102.0 + 103.0 &&
+	       impact.worst_price == 103.0 && impact.level_count == 3 &&
+	       book.get_ask_price() == 101.0 &&
+	       book.get_market_price() == -1.0 &&
+	       fork->ask_limit_at(102.0)->second.get_aon_quantity() == 4.0 &&
+	       fork->ask_limit_at(103.0)->second.get_quantity() == 9.0;
+}
+
+bool market_impact_test::simulate_market_orders() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	book.insert<elob::order>(elob::side::bid, 98.0, 4.0, false, true);
+	book.insert<elob::order>(elob::side::bid, 98.0, 2.0);
+	book.insert<elob::order>(elob::side::bid, 97.0, 10.0);
+
+	const std::vector<double> quantities = {3.0, 8.0, 100.0};
+	std::vector<elob::market_impact> impacts;
+	book.simulate_market_orders(
+	    elob::side::ask, quantities, impacts, 98.0);
+
+	return impacts.size() == 3 && impacts[0].filled_quantity == 3.0 &&
+	       impacts[0].get_vwap() == 99.0 && impacts[0].level_count == 1 &&
+	       impacts[1].filled_quantity == 7.0 &&
+	       impacts[1].remaining_quantity == 1.0 &&
+	       impacts[1].worst_price == 98.0 &&
+	       impacts[2].filled_quantity == 11.0 &&
+	       impacts[2].remaining_quantity == 89.0 &&
+	       impacts[2].level_count == 2;
+}
+
+#endif // #ifndef MARKET_IMPACT_TEST_HPP
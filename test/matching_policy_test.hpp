@@ -0,0 +1,89 @@
+#ifndef MATCHING_POLICY_TEST_HPP
+#define MATCHING_POLICY_TEST_HPP
+#include "test.hpp"
+
+class matching_policy_test : public test {
+	inline static bool allocate_pro_rata();
+	inline static bool round_to_lots();
+	inline static bool prioritize_top_order();
+	inline static bool sweep_in_time_priority();
+
+	public:
+	matching_policy_test();
+};
+
+#include "../include/book.hpp"
+
+matching_policy_test::matching_policy_test() : test("matching_policy_test") {
+	add("allocate_pro_rata", allocate_pro_rata);
+	add("round_to_lots", round_to_lots);
+	add("prioritize_top_order", prioritize_top_order);
+	add("sweep_in_time_priority", sweep_in_time_priority);
+}
+
+bool matching_policy_test::allocate_pro_rata() {
+	elob::book book(elob::pro_rata);
+	const auto first =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 10.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 30.0);
+	const auto third =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 60.0);
+	book.insert<elob::order>(elob::side::bid, 100.0, 50.0);
+
+	if (first->get_quantity() != 5.0 || second->get_quantity() != 15.0 ||
+	    third->get_quantity() != 30.0) {
+		return false;
+	}
+
+	// rounding up favours the older orders
+	book.insert<elob::order>(elob::side::bid, 100.0, 7.0);
+
+	return first->get_quantity() == 4.0 && second->get_quantity() == 13.0 &&
+	       third->get_quantity() == 26.0 &&
+	       book.ask_limit_at(100.0)->second.get_quantity() == 43.0 &&
+	       book.fork()->get_matching_policy() == elob::pro_rata;
+}
+
+bool matching_policy_test::round_to_lots() {
+	elob::book book(elob::pro_rata, 5.0);
+	const auto first =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 10.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 10.0);
+	const auto third =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 10.0);
+	book.insert<elob::order>(elob::side::bid, 100.0, 10.0);
+
+	return first->get_quantity() == 5.0 && second->get_quantity() == 5.0 &&
+	       third->get_quantity() == 10.0 && book.get_lot_size() == 5.0;
+}
+
+bool matching_policy_test::prioritize_top_order() {
+	elob::book book(elob::top_pro_rata);
+	const auto aon = book.insert<elob::order>(
+	    elob::side::ask, 100.0, 5.0, false, true);
+	const auto top = book.insert<elob::order>(elob::side::ask, 100.0, 10.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 30.0);
+	const auto third =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 60.0);
+	book.insert<elob::order>(elob::side::bid, 100.0, 40.0);
+
+	return aon->get_quantity() == 5.0 && !top->is_queued() &&
+	       second->get_quantity() == 20.0 && third->get_quantity() == 40.0;
+}
+
+bool matching_policy_test::sweep_in_time_priority() {
+	elob::book book(elob::pro_rata);
+	const auto first =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 2.0);
+	const auto bid = book.insert<elob::order>(elob::side::bid, 100.0, 4.0);
+
+	return !first->is_queued() && !second->is_queued() &&
+	       bid->is_queued() && bid->get_quantity() == 1.0;
+}
+
+#endif // #ifndef MATCHING_POLICY_TEST_HPP
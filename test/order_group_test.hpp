@@ -0,0 +1,249 @@
+#ifndef ORDER_GROUP_TEST_HPP
+#define ORDER_GROUP_TEST_HPP
+#include "test.hpp"
+
+class order_group_test : public test {
+	inline static bool cancel_other_leg();
+	inline static bool fill_one_leg_per_sweep();
+	inline static bool withdraw_other_legs();
+	inline static bool fire_one_stop();
+	inline static bool insert_exits_on_fill();
+	inline static bool drop_exits_on_cancel();
+
+	public:
+	order_group_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/stop.hpp"
+#include <vector>
+
+namespace {
+
+// resizes another order when it trades
+class resizing_order : public elob::order {
+	public:
+	elob::order_ptr m_other;
+	double m_other_quantity;
+
+	resizing_order(const elob::side t_side, const double t_price,
+	    const double t_quantity, elob::order_ptr t_other,
+	    const double t_other_quantity)
+	    : order(t_side, t_price, t_quantity), m_other(std::move(t_other)),
+	      m_other_quantity(t_other_quantity) {}
+
+	protected:
+	void on_traded(elob::c_order_ptr &) override {
+		m_other->set_quantity(m_other_quantity);
+	}
+};
+
+} // namespace
+
+order_group_test::order_group_test() : test("order_group_test") {
+	add("cancel_other_leg", cancel_other_leg);
+	add("fill_one_leg_per_sweep", fill_one_leg_per_sweep);
+	add("withdraw_other_legs", withdraw_other_legs);
+	add("fire_one_stop", fire_one_stop);
+	add("insert_exits_on_fill", insert_exits_on_fill);
+	add("drop_exits_on_cancel", drop_exits_on_cancel);
+}
+
+bool order_group_test::cancel_other_leg() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 95.0, 1.0);
+	const auto target =
+	    std::make_shared<elob::order>(elob::side::ask, 110.0, 1.0);
+	const auto pending =
+	    std::make_shared<elob::order>(elob::side::ask, 90.0, 1.0);
+	const elob::trigger_ptr stop = std::make_shared<elob::stop_order>(
+	    elob::side::bid, 95.0, pending);
+	book.insert_oco({target, stop});
+
+	// the fill of the target cancels the stop
+	book.insert<elob::order>(elob::side::bid, 110.0, 1.0);
+
+	if (target->is_queued() || stop->is_queued() ||
+	    pending->get_book() != nullptr) {
+		return false;
+	}
+
+	// the stop cancels the target when it fires
+	const auto other =
+	    std::make_shared<elob::order>(elob::side::ask, 110.0, 1.0);
+	const elob::trigger_ptr next = std::make_shared<elob::stop_order>(
+	    elob::side::bid, 95.0,
+	    std::make_shared<elob::order>(elob::side::ask, 90.0, 1.0));
+	book.insert_oco({other, next});
+	book.insert<elob::order>(elob::side::ask, 95.0, 1.0);
+
+	return !other->is_queued() && !next->is_queued() &&
+	       book.ask_limit_at(110.0) == book.ask_limits_end() &&
+	       book.ask_limit_at(90.0)->second.get_quantity() == 1.0;
+}
+
+bool order_group_test::fill_one_leg_per_sweep() {
+	elob::book book;
+	const auto first =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+	const auto second =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+	const auto third =
+	    std::make_shared<elob::order>(elob::side::bid, 99.0, 1.0);
+	book.insert_oco({first, second, third});
+	const auto other = book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+
+	// the sweep passes over the other legs of the group
+	const auto sweep =
+	    book.insert<elob::order>(elob::side::ask, 98.0, 3.0);
+
+	if (first->get_quantity() != 0.0 || second->is_queued() ||
+	    third->is_queued() || other->is_queued() ||
+	    sweep->get_quantity() != 1.0 ||
+	    book.bid_limits_begin() != book.bid_limits_end()) {
+		return false;
+	}
+
+	// a leg that trades on insertion keeps the others out of the book
+	book.insert<elob::order>(elob::side::bid, 98.0, 2.0);
+	const auto crossing =
+	    std::make_shared<elob::order>(elob::side::ask, 97.0, 2.0);
+	const auto resting =
+	    std::make_shared<elob::order>(elob::side::ask, 120.0, 1.0);
+	book.insert_oco({crossing, resting});
+
+	return crossing->get_quantity() == 1.0 && crossing->is_queued() &&
+	       !resting->is_queued() && resting->get_book() == nullptr &&
+	       book.ask_limit_at(120.0) == book.ask_limits_end();
+}
+
+bool order_group_test::withdraw_other_legs() {
+	elob::book book;
+	const auto resting =
+	    book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	const auto aon =
+	    book.insert<elob::order>(elob::side::ask, 99.0, 5.0, false, true);
+	const elob::order_ptr target = std::make_shared<resizing_order>(
+	    elob::side::ask, 100.0, 2.0, aon, 3.0);
+	const auto other =
+	    std::make_shared<elob::order>(elob::side::bid, 99.0, 2.0);
+	book.insert_oco({target, other});
+
+	// the all-or-nothing order is resized while the other leg is
+	// still queued, but it no longer counts towards its level
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+
+	return target->get_quantity() == 1.0 && !other->is_queued() &&
+	       resting->is_queued() && aon->is_queued() &&
+	       aon->get_quantity() == 3.0 &&
+	       book.bid_limit_at(99.0)->second.get_quantity() == 1.0;
+}
+
+bool order_group_test::fire_one_stop() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 95.0, 1.0);
+	const auto first_order =
+	    std::make_shared<elob::order>(elob::side::ask, 120.0, 1.0);
+	const auto second_order =
+	    std::make_shared<elob::order>(elob::side::ask, 121.0, 1.0);
+	const elob::trigger_ptr first = std::make_shared<elob::stop_order>(
+	    elob::side::bid, 95.0, first_order);
+	const elob::trigger_ptr second = std::make_shared<elob::stop_order>(
+	    elob::side::bid, 95.0, second_order);
+	book.insert_oco({first, second});
+
+	// both stops are due, but only the first fires
+	book.insert<elob::order>(elob::side::ask, 95.0, 1.0);
+
+	return first_order->is_queued() && !second_order->is_queued() &&
+	       second_order->get_book() == nullptr && !first->is_queued() &&
+	       !second->is_queued();
+}
+
+bool order_group_test::insert_exits_on_fill() {
+	elob::book book;
+	const auto entry =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 2.0);
+	const auto target =
+	    std::make_shared<elob::order>(elob::side::ask, 105.0, 2.0);
+	const auto pending =
+	    std::make_shared<elob::order>(elob::side::ask, 90.0, 2.0);
+	const elob::trigger_ptr stop = std::make_shared<elob::stop_order>(
+	    elob::side::bid, 95.0, pending);
+	book.insert_bracket(entry, {target, stop});
+
+	if (!entry->is_queued() || target->is_queued() || stop->is_queued()) {
+		return false;
+	}
+
+	// a partial fill of the entry inserts the exits
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+
+	if (!entry->is_queued() || !target->is_queued() ||
+	    !stop->is_queued()) {
+		return false;
+	}
+
+	// the rest of the entry does not insert them again and a partial
+	// fill of the target cancels the stop
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 105.0, 1.0);
+
+	if (entry->is_queued() || stop->is_queued() ||
+	    target->get_quantity() != 1.0 ||
+	    book.ask_limit_at(105.0)->second.order_count() != 1) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::ask, 94.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 94.0, 1.0);
+	return target->cancel() && pending->get_book() == nullptr &&
+	       book.ask_limits_begin() == book.ask_limits_end();
+}
+
+bool order_group_test::drop_exits_on_cancel() {
+	elob::book book;
+	std::vector<elob::order_ptr> targets;
+
+	// the handles of the dropped groups are reused
+	for (int i = 0; i < 100; ++i) {
+		const auto entry =
+		    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+		targets.push_back(
+		    std::make_shared<elob::order>(elob::side::ask, 105.0, 1.0));
+		book.insert_bracket(entry, {targets.back()});
+
+		if (!entry->cancel()) {
+			return false;
+		}
+
+		const auto first =
+		    std::make_shared<elob::order>(elob::side::bid, 90.0, 1.0);
+		const auto second =
+		    std::make_shared<elob::order>(elob::side::bid, 91.0, 1.0);
+		book.insert_oco({first, second});
+
+		if (!first->cancel() || !second->cancel()) {
+			return false;
+		}
+	}
+
+	const auto entry =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+	const auto target =
+	    std::make_shared<elob::order>(elob::side::ask, 105.0, 1.0);
+	book.insert_bracket(entry, {target});
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+
+	for (const auto &dropped : targets) {
+		if (dropped->get_book() != nullptr) {
+			return false;
+		}
+	}
+
+	return target->is_queued() &&
+	       book.ask_limit_at(105.0)->second.order_count() == 1 &&
+	       book.bid_limits_begin() == book.bid_limits_end();
+}
+
+#endif // #ifndef ORDER_GROUP_TEST_HPP
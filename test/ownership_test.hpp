@@ -0,0 +1,111 @@
+#ifndef OWNERSHIP_TEST_HPP
+#define OWNERSHIP_TEST_HPP
+#include "test.hpp"
+
+class ownership_test : public test {
+	inline static bool book_keeps_queued_orders_alive();
+	inline static bool cancel_from_event_method();
+	inline static bool cancel_from_inbound_event_method();
+	inline static bool book_keeps_queued_triggers_alive();
+
+	public:
+	ownership_test();
+};
+
+#include "../include/book.hpp"
+
+ownership_test::ownership_test() : test("ownership_test") {
+	add("book_keeps_queued_orders_alive", book_keeps_queued_orders_alive);
+	add("cancel_from_event_method", cancel_from_event_method);
+	add("cancel_from_inbound_event_method",
+	    cancel_from_inbound_event_method);
+	add("book_keeps_queued_triggers_alive",
+	    book_keeps_queued_triggers_alive);
+}
+
+bool ownership_test::book_keeps_queued_orders_alive() {
+	elob::book book;
+	std::weak_ptr<elob::order> filled =
+	    book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+	std::weak_ptr<elob::order> canceled =
+	    book.insert<elob::order>(elob::side::ask, 102.0, 5.0);
+
+	if (filled.expired() || canceled.expired()) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 101.0, 5.0);
+	canceled.lock()->cancel();
+
+	return filled.expired() && canceled.expired();
+}
+
+class self_canceling_order : public elob::order {
+	public:
+	using elob::order::order;
+
+	protected:
+	void on_traded(elob::c_order_ptr &t_order) override { cancel(); }
+};
+
+bool ownership_test::cancel_from_event_method() {
+	elob::book book;
+	std::weak_ptr<elob::order> queued =
+	    book.insert<self_canceling_order>(elob::side::ask, 101.0, 5.0);
+	book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+	book.insert<elob::order>(elob::side::bid, 101.0, 2.0);
+
+	return queued.expired() &&
+	       book.ask_limit_at(101.0)->second.get_quantity() == 5.0;
+}
+
+class canceling_order : public elob::order {
+	public:
+	using elob::order::order;
+	double m_traded_quantity = 0.0;
+
+	protected:
+	void on_traded(elob::c_order_ptr &t_order) override {
+		t_order->cancel();
+		m_traded_quantity += t_order->get_quantity();
+	}
+};
+
+bool ownership_test::cancel_from_inbound_event_method() {
+	// the partially filled order stays alive for the inbound order's
+	// event method, also under pro-rata allocation
+	for (const auto policy : {elob::fifo, elob::pro_rata}) {
+		elob::book book(policy);
+		std::weak_ptr<elob::order> queued =
+		    book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+		book.insert<elob::order>(
+		    elob::side::ask, 101.0, 5.0, false, true);
+		const auto inbound = book.insert<canceling_order>(
+		    elob::side::bid, 101.0, 2.0);
+
+		if (!queued.expired() || inbound->m_traded_quantity != 3.0 ||
+		    book.ask_limit_at(101.0)->second.get_quantity() != 0.0 ||
+		    book.ask_limit_at(101.0)->second.get_aon_quantity() !=
+			5.0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ownership_test::book_keeps_queued_triggers_alive() {
+	elob::book book;
+	std::weak_ptr<elob::trigger> trigger =
+	    book.insert<elob::trigger>(elob::side::ask, 100.0);
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+
+	if (trigger.expired()) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	return trigger.expired();
+}
+
+#endif // #ifndef OWNERSHIP_TEST_HPP
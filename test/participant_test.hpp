@@ -0,0 +1,252 @@
+#ifndef PARTICIPANT_TEST_HPP
+#define PARTICIPANT_TEST_HPP
+#include "test.hpp"
+
+class participant_test : public test {
+	inline static bool cancel_all_orders();
+	inline static bool cancel_price_range();
+	inline static bool follow_trades();
+	inline static bool replace_quotes();
+	inline static bool quote_outside_cascade();
+	inline static bool index_forks();
+
+	public:
+	participant_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/peg.hpp"
+#include "../include/stop.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// counts the orders canceled by the book
+class owned_order : public elob::order {
+	public:
+	int &m_canceled;
+
+	owned_order(const elob::side t_side, const double t_price,
+	    const double t_quantity, const std::uint64_t t_owner,
+	    int &t_canceled)
+	    : order(t_side, t_price, t_quantity), m_canceled(t_canceled) {
+		set_owner(t_owner);
+	}
+
+	protected:
+	void on_canceled() override { ++m_canceled; }
+};
+
+} // namespace
+
+participant_test::participant_test() : test("participant_test") {
+	add("cancel_all_orders", cancel_all_orders);
+	add("cancel_price_range", cancel_price_range);
+	add("follow_trades", follow_trades);
+	add("replace_quotes", replace_quotes);
+	add("quote_outside_cascade", quote_outside_cascade);
+	add("index_forks", index_forks);
+}
+
+bool participant_test::cancel_all_orders() {
+	elob::book book;
+	book.set_lazy_cancel(true);
+	int canceled = 0;
+	std::vector<elob::order_ptr> orders;
+
+	// the orders of both participants share levels
+	for (int i = 0; i < 20; ++i) {
+		orders.push_back(book.insert<owned_order>(elob::side::bid,
+		    95.0 + i % 5, 1.0, 1 + i % 2, canceled));
+		orders.push_back(book.insert<owned_order>(elob::side::ask,
+		    105.0 + i % 5, 1.0, 1 + i % 2, canceled));
+	}
+
+	const auto other = book.insert<elob::order>(elob::side::bid, 90.0, 1.0);
+	const auto peg = book.insert<elob::peg>(
+	    elob::side::bid, elob::primary_peg, -1.0, 1.0);
+	peg->set_owner(1);
+
+	if (book.mass_cancel(1) != 21 || canceled != 20 ||
+	    peg->is_queued() || !other->is_queued() ||
+	    book.mass_cancel(1) != 0) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < orders.size(); ++i) {
+		if (orders[i]->is_queued() != (i % 4 >= 2) ||
+		    (orders[i]->get_book() == nullptr) != (i % 4 < 2)) {
+			return false;
+		}
+	}
+
+	// emptied levels are erased
+	if (book.mass_cancel(2) != 20 ||
+	    book.ask_limits_begin() != book.ask_limits_end()) {
+		return false;
+	}
+
+	return book.bid_limits_begin()->first == 90.0 &&
+	       std::next(book.bid_limits_begin()) == book.bid_limits_end();
+}
+
+bool participant_test::cancel_price_range() {
+	elob::book book;
+	int canceled = 0;
+	std::vector<elob::order_ptr> orders;
+
+	for (int i = 0; i < 5; ++i) {
+		orders.push_back(book.insert<owned_order>(
+		    elob::side::bid, 95.0 + i, 1.0, 7, canceled));
+		orders.push_back(book.insert<owned_order>(
+		    elob::side::ask, 101.0 + i, 1.0, 7, canceled));
+	}
+
+	if (book.mass_cancel(7, elob::side::bid, 97.0, 98.0) != 2 ||
+	    book.mass_cancel(7, elob::side::ask, 104.0) != 2 ||
+	    book.mass_cancel(8, elob::side::bid) != 0 || canceled != 4) {
+		return false;
+	}
+
+	for (int i = 0; i < 5; ++i) {
+		if (orders[2 * i]->is_queued() == (i == 2 || i == 3) ||
+		    orders[2 * i + 1]->is_queued() == (i >= 3)) {
+			return false;
+		}
+	}
+
+	return book.bid_limit_at(97.0) == book.bid_limits_end() &&
+	       book.ask_limit_at(104.0) == book.ask_limits_end() &&
+	       book.mass_cancel(7) == 6;
+}
+
+bool participant_test::follow_trades() {
+	elob::book book;
+	int canceled = 0;
+	const auto first =
+	    book.insert<owned_order>(elob::side::ask, 101.0, 1.0, 3, canceled);
+	const auto second =
+	    book.insert<owned_order>(elob::side::ask, 102.0, 2.0, 3, canceled);
+	const auto third =
+	    book.insert<owned_order>(elob::side::ask, 103.0, 1.0, 3, canceled);
+
+	// filled orders leave the index, partially filled ones stay
+	book.insert<elob::order>(elob::side::bid, 102.0, 2.0);
+
+	// and so do orders that change their owner
+	third->set_owner(4);
+
+	if (first->is_queued() || second->get_quantity() != 1.0 ||
+	    book.mass_cancel(3) != 1 || second->is_queued() ||
+	    !third->is_queued()) {
+		return false;
+	}
+
+	return book.mass_cancel(4) == 1 && canceled == 2 &&
+	       book.ask_limits_begin() == book.ask_limits_end();
+}
+
+bool participant_test::replace_quotes() {
+	elob::book book;
+	int canceled = 0;
+	std::vector<elob::order_ptr> ladder;
+
+	for (int i = 0; i < 3; ++i) {
+		ladder.push_back(book.insert<owned_order>(
+		    elob::side::bid, 99.0 - i, 1.0, 5, canceled));
+		ladder.push_back(book.insert<owned_order>(
+		    elob::side::ask, 101.0 + i, 1.0, 5, canceled));
+	}
+
+	const auto resting =
+	    book.insert<elob::order>(elob::side::ask, 102.0, 1.0);
+	std::vector<elob::order_ptr> quotes;
+
+	// the old ladder does not trade against the new one
+	for (int i = 0; i < 3; ++i) {
+		quotes.push_back(std::make_shared<elob::order>(
+		    elob::side::bid, 102.0 - i, 2.0));
+		quotes.push_back(std::make_shared<elob::order>(
+		    elob::side::ask, 103.0 + i, 2.0));
+	}
+
+	if (book.mass_quote(5, quotes) != 6 || canceled != 6) {
+		return false;
+	}
+
+	for (const auto &order_obj : ladder) {
+		if (order_obj->is_queued()) {
+			return false;
+		}
+	}
+
+	// the first bid fills the resting ask only
+	if (resting->is_queued() || quotes[0]->get_quantity() != 1.0 ||
+	    book.get_market_price() != 102.0) {
+		return false;
+	}
+
+	for (const auto &quote : quotes) {
+		if (!quote->is_queued() || quote->get_owner() != 5) {
+			return false;
+		}
+	}
+
+	return book.mass_cancel(5) == 6 &&
+	       book.bid_limits_begin() == book.bid_limits_end();
+}
+
+bool participant_test::quote_outside_cascade() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	const auto pending =
+	    std::make_shared<elob::order>(elob::side::ask, 101.0, 1.0);
+	book.insert(std::make_shared<elob::stop_order>(
+	    elob::side::bid, 100.0, pending));
+	const std::vector<elob::order_ptr> quotes = {
+	    std::make_shared<elob::order>(elob::side::bid, 98.0, 1.0),
+	    std::make_shared<elob::order>(elob::side::ask, 100.0, 1.0),
+	    std::make_shared<elob::order>(elob::side::ask, 102.0, 1.0)};
+
+	// only the order of the stop fired by the quotes is deferred
+	if (book.mass_quote(6, quotes) != 0 || !pending->is_queued()) {
+		return false;
+	}
+
+	const auto &stats = book.get_cascade_stats();
+	return stats.wave_count == 1 && stats.max_wave_size == 1 &&
+	       stats.order_count == 1 && stats.trigger_count == 1;
+}
+
+bool participant_test::index_forks() {
+	elob::book book;
+	int canceled = 0;
+	const auto bid =
+	    book.insert<owned_order>(elob::side::bid, 99.0, 1.0, 9, canceled);
+	book.insert<owned_order>(elob::side::ask, 101.0, 1.0, 9, canceled);
+	book.insert<elob::order>(elob::side::ask, 102.0, 1.0);
+	const auto fork = book.fork();
+
+	// the fork cancels its copies of the orders only
+	if (fork->mass_cancel(9) != 2 || !bid->is_queued() ||
+	    fork->bid_limits_begin() != fork->bid_limits_end() ||
+	    fork->ask_limits_begin()->first != 102.0) {
+		return false;
+	}
+
+	fork->insert<owned_order>(elob::side::bid, 98.0, 1.0, 9, canceled);
+
+	if (book.mass_cancel(9) != 2 || bid->is_queued() ||
+	    fork->bid_limits_begin()->first != 98.0) {
+		return false;
+	}
+
+	// forks of forks index the copies they take, which do not count
+	// their cancellation
+	const auto other = fork->fork();
+	return other->mass_cancel(9, elob::side::bid) == 1 &&
+	       fork->mass_cancel(9, elob::side::bid) == 1 && canceled == 3;
+}
+
+#endif // #ifndef PARTICIPANT_TEST_HPP
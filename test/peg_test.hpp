@@ -0,0 +1,120 @@
+#ifndef PEG_TEST_HPP
+#define PEG_TEST_HPP
+#include "test.hpp"
+
+class peg_test : public test {
+	inline static bool track_best_prices();
+	inline static bool merge_with_price_levels();
+	inline static bool keep_time_priority();
+	inline static bool cancel_pegged_order();
+
+	public:
+	peg_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/peg.hpp"
+
+peg_test::peg_test() : test("peg_test") {
+	add("track_best_prices", track_best_prices);
+	add("merge_with_price_levels", merge_with_price_levels);
+	add("keep_time_priority", keep_time_priority);
+	add("cancel_pegged_order", cancel_pegged_order);
+}
+
+bool peg_test::track_best_prices() {
+	elob::book book;
+	const auto primary = book.insert<elob::peg>(
+	    elob::side::bid, elob::primary_peg, -1.0, 5.0);
+	const auto market = book.insert<elob::peg>(
+	    elob::side::ask, elob::market_peg, 2.0, 5.0);
+	const auto mid =
+	    book.insert<elob::peg>(elob::side::bid, elob::mid_peg, 0.0, 5.0);
+
+	// the reference prices are unavailable
+	if (!primary->is_queued() || primary->get_price() != -1.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 103.0, 1.0);
+
+	if (primary->get_price() != 98.0 || market->get_price() != 101.0 ||
+	    mid->get_price() != 101.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+
+	return primary->get_price() == 99.0 && market->get_price() == 102.0 &&
+	       mid->get_price() == 101.5 && book.get_bid_price() == 100.0;
+}
+
+bool peg_test::merge_with_price_levels() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 103.0, 2.0);
+	const auto peg = book.insert<elob::peg>(
+	    elob::side::ask, elob::primary_peg, 1.0, 3.0);
+
+	const auto impact =
+	    book.simulate_market_order(elob::side::bid, 5.0, elob::max_price);
+
+	if (impact.filled_quantity != 5.0 || impact.level_count != 3 ||
+	    impact.notional != 101.0 + 3.0 * 102.0 + 103.0) {
+		return false;
+	}
+
+	// the pegged price is fixed when the inbound order is inserted
+	book.insert<elob::order>(elob::side::bid, 103.0, 5.0);
+
+	return !peg->is_queued() && peg->get_price() == 102.0 &&
+	       book.get_market_price() == 103.0 &&
+	       book.ask_limit_at(103.0)->second.get_quantity() == 1.0;
+}
+
+bool peg_test::keep_time_priority() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::bid, 99.0, 1.0);
+	const auto first = book.insert<elob::peg>(
+	    elob::side::bid, elob::primary_peg, 0.0, 2.0);
+	const auto second = book.insert<elob::peg>(
+	    elob::side::bid, elob::primary_peg, 0.0, 2.0);
+
+	// the group is repriced as a whole
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+
+	if (first->get_price() != 100.0 || second->get_price() != 100.0) {
+		return false;
+	}
+
+	// the ordinary level precedes the group at the same price
+	book.insert<elob::order>(elob::side::ask, 100.0, 3.0);
+
+	return !first->is_queued() && first->get_price() == 100.0 &&
+	       second->is_queued() && second->get_quantity() == 2.0 &&
+	       second->get_price() == 99.0 && book.get_market_price() == 100.0;
+}
+
+bool peg_test::cancel_pegged_order() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 101.0, 1.0);
+	const auto peg = book.insert<elob::peg>(
+	    elob::side::ask, elob::primary_peg, 0.0, 2.0);
+	const auto rejected = book.insert<elob::peg>(
+	    elob::side::ask, elob::primary_peg, -1.0, 2.0);
+
+	if (rejected->is_queued() || !peg->cancel() || peg->is_queued() ||
+	    book.replace(peg, 101.0, 1.0)) {
+		return false;
+	}
+
+	// only the ordinary order is left
+	book.insert<elob::order>(elob::side::bid, 101.0, 3.0);
+
+	return book.get_bid_price() == 101.0 &&
+	       book.bid_limit_at(101.0)->second.get_quantity() == 2.0;
+}
+
+#endif // #ifndef PEG_TEST_HPP
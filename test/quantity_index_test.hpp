@@ -0,0 +1,162 @@
+#ifndef QUANTITY_INDEX_TEST_HPP
+#define QUANTITY_INDEX_TEST_HPP
+#include "test.hpp"
+
+class quantity_index_test : public test {
+	inline static bool scan_deep_queue();
+	inline static bool follow_level_changes();
+	inline static bool keep_forks_apart();
+
+	public:
+	quantity_index_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/iceberg.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// walks the orders of the bid level at t_price one by one
+double expected_fill(elob::book &t_book, const double t_price,
+    const double t_quantity) {
+	double quantity_remaining = t_quantity;
+	double hidden_quantity = 0.0;
+
+	for (const auto &order_obj : t_book.bid_limit_at(t_price)->second) {
+		const double quantity = order_obj->get_quantity();
+		hidden_quantity += order_obj->get_hidden_quantity();
+
+		if (quantity_remaining >= quantity) {
+			quantity_remaining -= quantity;
+		} else if (!order_obj->is_all_or_nothing()) {
+			return t_quantity;
+		}
+	}
+
+	// the hidden quantity trades behind all orders
+	return t_quantity - std::max(quantity_remaining - hidden_quantity, 0.0);
+}
+
+// compares the sweep of every quantity up to t_max against the walk
+bool matches_walk(
+    elob::book &t_book, const double t_price, const double t_max) {
+	for (double quantity = 0.5; quantity <= t_max; quantity += 0.5) {
+		const auto impact = t_book.simulate_market_order(
+		    elob::side::ask, quantity, t_price);
+
+		if (impact.filled_quantity !=
+		    expected_fill(t_book, t_price, quantity)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+quantity_index_test::quantity_index_test() : test("quantity_index_test") {
+	add("scan_deep_queue", scan_deep_queue);
+	add("follow_level_changes", follow_level_changes);
+	add("keep_forks_apart", keep_forks_apart);
+}
+
+bool quantity_index_test::scan_deep_queue() {
+	elob::book book;
+
+	for (int i = 0; i < 21; ++i) {
+		book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	}
+
+	book.insert<elob::order>(elob::side::bid, 100.0, 30.0, false, true);
+
+	for (int i = 0; i < 19; ++i) {
+		book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+	}
+
+	// the all-or-nothing order is skipped unless it fits
+	const auto skipped =
+	    book.simulate_market_order(elob::side::ask, 45.0, 100.0);
+	const auto filled =
+	    book.simulate_market_order(elob::side::ask, 55.0, 100.0);
+
+	return skipped.filled_quantity == 40.0 &&
+	       filled.filled_quantity == 55.0 &&
+	       matches_walk(book, 100.0, 75.0);
+}
+
+bool quantity_index_test::follow_level_changes() {
+	elob::book book;
+	std::vector<elob::order_ptr> orders;
+	const auto iceberg =
+	    book.insert<elob::iceberg>(elob::side::bid, 100.0, 10.0, 2.0);
+
+	// large all-or-nothing orders between small ones
+	for (int i = 0; i < 40; ++i) {
+		const bool aon = i % 7 == 3;
+		orders.push_back(book.insert<elob::order>(elob::side::bid,
+		    100.0, aon ? 12.0 : 1.0 + i % 3, false, aon));
+	}
+
+	if (!matches_walk(book, 100.0, 100.0)) {
+		return false;
+	}
+
+	// enough cancellations to compact the index
+	for (int i = 0; i < 40; i += 5) {
+		orders[i]->cancel();
+		orders[i + 1]->cancel();
+		orders[i + 2]->cancel();
+	}
+
+	orders[4]->set_quantity(6.0);
+	orders[8]->set_all_or_nothing(true);
+	orders[9]->set_quantity(0.5);
+	book.replace(orders[13], 100.0, 0.5);
+
+	// partial fills and the replenished iceberg slice
+	book.insert<elob::order>(elob::side::ask, 100.0, 4.5);
+	book.insert<elob::order>(elob::side::ask, 100.0, 2.0);
+
+	return iceberg->get_quantity() + iceberg->get_hidden_quantity() ==
+		   8.0 &&
+	       matches_walk(book, 100.0, 100.0);
+}
+
+bool quantity_index_test::keep_forks_apart() {
+	elob::book book;
+	std::vector<elob::order_ptr> orders;
+
+	for (int i = 0; i < 30; ++i) {
+		const bool aon = i % 10 == 5;
+		orders.push_back(book.insert<elob::order>(
+		    elob::side::bid, 100.0, aon ? 9.0 : 2.0, false, aon));
+	}
+
+	if (!matches_walk(book, 100.0, 70.0)) {
+		return false;
+	}
+
+	// the original moves its orders and their index out of the level
+	// it shares with the fork
+	const auto fork = book.fork();
+	orders[1]->cancel();
+	orders[3]->set_quantity(4.5);
+	orders[15]->set_quantity(7.0);
+
+	if (!matches_walk(book, 100.0, 70.0) ||
+	    !matches_walk(*fork, 100.0, 70.0)) {
+		return false;
+	}
+
+	fork->insert<elob::order>(elob::side::ask, 100.0, 11.0);
+	orders[25]->set_quantity(3.0);
+
+	return matches_walk(book, 100.0, 70.0) &&
+	       matches_walk(*fork, 100.0, 70.0) &&
+	       fork->bid_limit_at(100.0)->second.get_quantity() == 43.0;
+}
+
+#endif // #ifndef QUANTITY_INDEX_TEST_HPP
@@ -0,0 +1,82 @@
+#ifndef REPLACE_TEST_HPP
+#define REPLACE_TEST_HPP
+#include "test.hpp"
+
+class replace_test : public test {
+	inline static bool keep_priority_on_reduction();
+	inline static bool lose_priority_on_increase();
+	inline static bool execute_on_price_change();
+	inline static bool reject_unqueued_order();
+
+	public:
+	replace_test();
+};
+
+#include "../include/book.hpp"
+
+replace_test::replace_test() : test("replace_test") {
+	add("keep_priority_on_reduction", keep_priority_on_reduction);
+	add("lose_priority_on_increase", lose_priority_on_increase);
+	add("execute_on_price_change", execute_on_price_change);
+	add("reject_unqueued_order", reject_unqueued_order);
+}
+
+bool replace_test::keep_priority_on_reduction() {
+	elob::book book;
+	const auto first = book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+
+	if (!book.replace(first, 99.0, 3.0) ||
+	    book.bid_limit_at(99.0)->second.get_quantity() != 8.0) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::ask, 99.0, 3.0);
+
+	return !first->is_queued() && second->get_quantity() == 5.0 &&
+	       book.bid_limit_at(99.0)->second.get_quantity() == 5.0;
+}
+
+bool replace_test::lose_priority_on_increase() {
+	elob::book book;
+	const auto first = book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	const auto second =
+	    book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+
+	book.replace(first, 99.0, 6.0);
+	book.insert<elob::order>(elob::side::ask, 99.0, 5.0);
+
+	return first->is_queued() && first->get_quantity() == 6.0 &&
+	       !second->is_queued() &&
+	       book.bid_limit_at(99.0)->second.get_quantity() == 6.0;
+}
+
+bool replace_test::execute_on_price_change() {
+	elob::book book;
+	book.insert<elob::order>(elob::side::ask, 101.0, 5.0);
+	const auto first = book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+
+	book.replace(first, 101.0, 2.0);
+
+	return !first->is_queued() && first->get_quantity() == 0.0 &&
+	       first->get_price() == 101.0 &&
+	       book.ask_limit_at(101.0)->second.get_quantity() == 3.0 &&
+	       book.bid_limit_at(99.0)->second.get_quantity() == 5.0 &&
+	       book.get_market_price() == 101.0;
+}
+
+bool replace_test::reject_unqueued_order() {
+	elob::book book;
+	const auto order =
+	    std::make_shared<elob::order>(elob::side::bid, 99.0, 5.0);
+	const auto queued =
+	    book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+
+	return !book.replace(order, 100.0, 5.0) &&
+	       !book.replace(queued, 100.0, 0.0) && queued->is_queued() &&
+	       queued->get_price() == 99.0;
+}
+
+#endif // #ifndef REPLACE_TEST_HPP
@@ -0,0 +1,277 @@
+#ifndef RISK_TEST_HPP
+#define RISK_TEST_HPP
+#include "test.hpp"
+
+class risk_test : public test {
+	inline static bool track_fills();
+	inline static bool match_recount();
+	inline static bool reject_on_limits();
+	inline static bool inherit_risk_in_forks();
+
+	public:
+	risk_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/iceberg.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+elob::order_ptr owned(elob::book &t_book, const std::uint64_t t_owner,
+    elob::order_ptr t_order) {
+	t_order->set_owner(t_owner);
+	t_book.insert(t_order);
+	return t_order;
+}
+
+} // namespace
+
+risk_test::risk_test() : test("risk_test") {
+	add("track_fills", track_fills);
+	add("match_recount", match_recount);
+	add("reject_on_limits", reject_on_limits);
+	add("inherit_risk_in_forks", inherit_risk_in_forks);
+}
+
+bool risk_test::track_fills() {
+	elob::book book;
+	const auto bid = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 5.0));
+	owned(book, 2,
+	    std::make_shared<elob::order>(elob::side::ask, 100.0, 3.0));
+	auto buyer = book.get_participant_risk(1);
+	auto seller = book.get_participant_risk(2);
+
+	if (buyer.open_bid_quantity != 2.0 || buyer.position != 3.0 ||
+	    buyer.notional != 300.0 || buyer.order_count != 1 ||
+	    seller.open_ask_quantity != 0.0 || seller.position != -3.0 ||
+	    seller.notional != 300.0 || seller.order_count != 0) {
+		return false;
+	}
+
+	// the hidden quantity of iceberg orders is open as well
+	const auto ask = owned(book, 2,
+	    std::make_shared<elob::iceberg>(
+		elob::side::ask, 101.0, 10.0, 2.0));
+	owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 101.0, 3.0));
+	seller = book.get_participant_risk(2);
+
+	if (seller.open_ask_quantity != 7.0 || seller.position != -6.0 ||
+	    seller.notional != 603.0 || seller.order_count != 1) {
+		return false;
+	}
+
+	bid->set_quantity(4.0);
+	book.replace(ask, 101.0, 5.0);
+	buyer = book.get_participant_risk(1);
+	seller = book.get_participant_risk(2);
+
+	if (buyer.open_bid_quantity != 4.0 || seller.open_ask_quantity != 5.0) {
+		return false;
+	}
+
+	bid->cancel();
+	book.mass_cancel(2);
+	buyer = book.get_participant_risk(1);
+	seller = book.get_participant_risk(2);
+	return buyer.open_bid_quantity == 0.0 && buyer.order_count == 0 &&
+	       buyer.position == 6.0 && seller.open_ask_quantity == 0.0 &&
+	       seller.order_count == 0 && seller.position == -6.0 &&
+	       book.get_participant_risk(3).order_count == 0;
+}
+
+bool risk_test::match_recount() {
+	elob::book book(elob::pro_rata);
+	book.set_lazy_cancel(true);
+	std::vector<elob::order_ptr> orders;
+	std::uint32_t seed = 4242;
+
+	const auto next = [&seed](const std::uint32_t t_range) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % t_range;
+	};
+
+	for (int step = 0; step < 3000; ++step) {
+		const std::uint32_t action = next(10);
+
+		if (action < 6 || orders.empty()) {
+			const auto side =
+			    next(2) == 0 ? elob::side::bid : elob::side::ask;
+			const double price = 98.0 + next(5);
+			const double quantity = 1.0 + next(6);
+			const std::uint64_t owner = next(3);
+			elob::order_ptr order_obj;
+
+			if (next(5) == 0) {
+				order_obj = std::make_shared<elob::iceberg>(
+				    side, price, quantity * 2.0, quantity);
+			} else {
+				order_obj = std::make_shared<elob::order>(
+				    side, price, quantity);
+			}
+
+			orders.push_back(owned(book, owner, order_obj));
+		} else if (action < 8) {
+			orders[next(orders.size())]->cancel();
+		} else if (action < 9) {
+			const std::size_t i = next(orders.size());
+			orders[i]->set_quantity(1.0 + next(4));
+		} else {
+			book.mass_cancel(1 + next(2),
+			    next(2) == 0 ? elob::side::bid : elob::side::ask,
+			    99.0, 101.0);
+		}
+
+		// recount the risk from the orders
+		for (std::uint64_t owner = 1; owner <= 2; ++owner) {
+			elob::participant_risk expected;
+
+			for (const auto &order_obj : orders) {
+				if (order_obj->get_owner() != owner) {
+					continue;
+				}
+
+				const double open =
+				    order_obj->get_quantity() +
+				    order_obj->get_hidden_quantity();
+
+				if (!order_obj->is_queued()) {
+					continue;
+				}
+
+				++expected.order_count;
+
+				if (order_obj->get_side() == elob::side::bid) {
+					expected.open_bid_quantity += open;
+				} else {
+					expected.open_ask_quantity += open;
+				}
+			}
+
+			// pro-rata fills may not be whole numbers
+			const auto risk = book.get_participant_risk(owner);
+
+			if (risk.order_count != expected.order_count ||
+			    std::abs(risk.open_bid_quantity -
+				expected.open_bid_quantity) > 1e-9 ||
+			    std::abs(risk.open_ask_quantity -
+				expected.open_ask_quantity) > 1e-9) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool risk_test::reject_on_limits() {
+	elob::book book;
+	elob::risk_limits limits;
+	limits.max_order_quantity = 5.0;
+	limits.max_order_count = 2;
+	limits.max_position = 8.0;
+	limits.max_notional = 500.0;
+	book.set_risk_limits(1, limits);
+
+	const auto too_large = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 90.0, 6.0));
+	const auto first = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 90.0, 5.0));
+
+	// the bids could leave the participant long 10
+	const auto too_long = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 89.0, 5.0));
+	const auto second = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::ask, 110.0, 1.0));
+	const auto too_many = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::ask, 111.0, 1.0));
+
+	if (too_large->get_book() || too_long->get_book() ||
+	    too_many->get_book() || !first->is_queued() ||
+	    !second->is_queued()) {
+		return false;
+	}
+
+	// fills count against the notional limit
+	second->cancel();
+	book.insert<elob::order>(elob::side::ask, 90.0, 5.0);
+	const auto expensive = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 120.0, 1.0));
+
+	// sells are valued at the best bid if it is higher
+	book.insert<elob::order>(elob::side::bid, 150.0, 1.0);
+	const auto crossing = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::ask, 90.0, 1.0));
+	const auto cheap = owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 40.0, 1.0));
+
+	// unowned orders and other participants are not limited
+	const auto other = owned(book, 2,
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 50.0));
+
+	if (expensive->get_book() != nullptr ||
+	    crossing->get_book() != nullptr || !cheap->is_queued() ||
+	    !other->is_queued() ||
+	    book.get_participant_risk(1).notional != 450.0) {
+		return false;
+	}
+
+	// queued orders cannot grow beyond the limits either
+	elob::book other_book;
+	limits = elob::risk_limits();
+	limits.max_order_quantity = 10.0;
+	limits.max_open_quantity = 10.0;
+	other_book.set_risk_limits(3, limits);
+	const auto order_obj = owned(other_book, 3,
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 5.0));
+
+	if (other_book.replace(order_obj, 100.0, 1000.0) ||
+	    other_book.replace(order_obj, 99.0, 5000.0) ||
+	    order_obj->set_quantity(1e6) ||
+	    order_obj->get_quantity() != 5.0 ||
+	    order_obj->get_price() != 100.0 ||
+	    !other_book.replace(order_obj, 99.0, 8.0) ||
+	    !order_obj->set_quantity(10.0)) {
+		return false;
+	}
+
+	// nor can queued orders change hands beyond them
+	const auto large = other_book.insert<elob::order>(
+	    elob::side::ask, 120.0, 500.0);
+
+	return !large->set_owner(3) && large->get_owner() == 0 &&
+	       order_obj->set_quantity(2.0) &&
+	       other_book.get_participant_risk(3).open_bid_quantity == 2.0 &&
+	       other_book.get_participant_risk(3).open_ask_quantity == 0.0;
+}
+
+bool risk_test::inherit_risk_in_forks() {
+	elob::book book;
+	elob::risk_limits limits;
+	limits.max_open_quantity = 4.0;
+	book.set_risk_limits(1, limits);
+	owned(book, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 99.0, 3.0));
+	const auto fork = book.fork();
+
+	// the fork trades against its copy of the order
+	fork->insert<elob::order>(elob::side::ask, 99.0, 2.0);
+	const auto rejected = owned(*fork, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 98.0, 4.0));
+	const auto accepted = owned(*fork, 1,
+	    std::make_shared<elob::order>(elob::side::bid, 98.0, 3.0));
+
+	const auto original = book.get_participant_risk(1);
+	const auto forked = fork->get_participant_risk(1);
+	return rejected->get_book() == nullptr && accepted->is_queued() &&
+	       original.open_bid_quantity == 3.0 && original.position == 0.0 &&
+	       forked.open_bid_quantity == 4.0 && forked.position == 2.0 &&
+	       forked.order_count == 2 && fork->mass_cancel(1) == 2 &&
+	       fork->get_participant_risk(1).open_bid_quantity == 0.0;
+}
+
+#endif // #ifndef RISK_TEST_HPP
@@ -0,0 +1,157 @@
+#ifndef SHM_FEED_TEST_HPP
+#define SHM_FEED_TEST_HPP
+#include "test.hpp"
+
+class shm_feed_test : public test {
+	inline static bool publish_levels_and_trades();
+	inline static bool detect_overrun();
+	inline static bool read_while_publishing();
+
+	public:
+	shm_feed_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/shm_feed.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// reads t_count messages published by another thread into a ring of
+// t_capacity slots and checks that they arrive in order
+bool read_concurrently(
+    const std::size_t t_capacity, const std::uint64_t t_count) {
+	const std::string name = "/elob_test_" + std::to_string(getpid());
+	elob::shm_publisher publisher(name, t_capacity);
+	elob::shm_subscriber subscriber(name);
+	std::atomic<bool> started(false);
+
+	std::thread writer([&]() {
+		while (!started.load(std::memory_order_acquire)) {
+		}
+
+		for (std::uint64_t i = 1; i <= t_count; ++i) {
+			publisher.on_published(static_cast<double>(i));
+		}
+	});
+
+	started.store(true, std::memory_order_release);
+	elob::feed_record record;
+	std::uint64_t received = 0;
+	bool ordered = true;
+
+	while (subscriber.get_next_sequence() <= t_count) {
+		const std::uint64_t sequence = subscriber.get_next_sequence();
+
+		if (subscriber.poll(record) != elob::feed_status::ok) {
+			continue;
+		}
+
+		++received;
+		ordered = ordered &&
+			  elob::codec::batch_message_decoder(record.data)
+				  .market_price() == sequence;
+	}
+
+	writer.join();
+	return ordered && received + subscriber.get_dropped() == t_count &&
+	       (t_capacity < t_count || subscriber.get_dropped() == 0);
+}
+
+} // namespace
+
+shm_feed_test::shm_feed_test() : test("shm_feed_test") {
+	add("publish_levels_and_trades", publish_levels_and_trades);
+	add("detect_overrun", detect_overrun);
+	add("read_while_publishing", read_while_publishing);
+}
+
+bool shm_feed_test::publish_levels_and_trades() {
+	const std::string name = "/elob_test_" + std::to_string(getpid());
+	elob::shm_publisher publisher(name, 64);
+	elob::shm_subscriber subscriber(name);
+	elob::book book;
+	book.set_listener(&publisher);
+
+	book.insert<elob::order>(elob::side::ask, 101.0, 10.0);
+	book.insert<elob::order>(elob::side::bid, 101.0, 4.0);
+
+	// ask level, end of first batch
+	// trade, ask level, end of second batch
+	elob::feed_record records[5];
+
+	for (auto &record : records) {
+		if (subscriber.poll(record) != elob::feed_status::ok) {
+			return false;
+		}
+	}
+
+	const elob::codec::level_message_decoder queued(records[0].data);
+	const elob::codec::fill_message_decoder trade(records[2].data);
+	const elob::codec::level_message_decoder traded(records[3].data);
+	const elob::codec::batch_message_decoder published(records[4].data);
+	const auto template_id = [&](const std::size_t t_index) {
+		return elob::codec::header_decoder(records[t_index].data)
+		    .template_id();
+	};
+
+	elob::feed_record record;
+
+	return subscriber.poll(record) == elob::feed_status::empty &&
+	       template_id(0) == queued.template_id &&
+	       queued.quantity() == 10.0 &&
+	       template_id(1) == published.template_id &&
+	       template_id(2) == trade.template_id &&
+	       trade.side() == elob::side::bid && trade.quantity() == 4.0 &&
+	       template_id(3) == traded.template_id &&
+	       traded.side() == elob::side::ask && traded.quantity() == 6.0 &&
+	       traded.batch() == trade.batch() &&
+	       template_id(4) == published.template_id &&
+	       published.market_price() == 101.0;
+}
+
+bool shm_feed_test::detect_overrun() {
+	const std::string name = "/elob_test_" + std::to_string(getpid());
+	elob::shm_publisher publisher(name, 4);
+	elob::shm_subscriber subscriber(name);
+
+	for (std::size_t i = 0; i < 10; ++i) {
+		publisher.on_published(i);
+	}
+
+	elob::feed_record record;
+	const bool overrun =
+	    subscriber.poll(record) == elob::feed_status::overrun;
+
+	// the last four messages are still in the ring
+	if (!overrun || subscriber.get_dropped() != 6) {
+		return false;
+	}
+
+	for (std::size_t i = 6; i < 10; ++i) {
+		if (subscriber.poll(record) != elob::feed_status::ok ||
+		    elob::codec::batch_message_decoder(record.data)
+			    .market_price() != i) {
+			return false;
+		}
+	}
+
+	publisher.on_published(10.0);
+
+	return subscriber.poll(record) == elob::feed_status::ok &&
+	       elob::codec::batch_message_decoder(record.data)
+		       .market_price() == 10.0 &&
+	       subscriber.poll(record) == elob::feed_status::empty;
+}
+
+bool shm_feed_test::read_while_publishing() {
+	// a ring that holds every message is never overrun, a small one
+	// loses messages but never delivers them out of order
+	return read_concurrently(1 << 18, 200000) &&
+	       read_concurrently(16, 200000);
+}
+
+#endif // #ifndef SHM_FEED_TEST_HPP
@@ -0,0 +1,106 @@
+#ifndef SIDE_TEST_HPP
+#define SIDE_TEST_HPP
+#include "test.hpp"
+
+class side_test : public test {
+	inline static bool insert_static_side();
+	inline static bool reject_other_side();
+	inline static bool reject_deferred_other_side();
+	inline static bool trigger_symmetrically();
+
+	public:
+	side_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/trigger.hpp"
+
+namespace {
+
+// inserts another order through the ask kernel once it is queued
+class forwarding_order : public elob::order {
+	public:
+	elob::order_ptr m_forwarded;
+
+	forwarding_order(const elob::side t_side, const double t_price,
+	    const double t_quantity, elob::order_ptr t_forwarded)
+	    : order(t_side, t_price, t_quantity),
+	      m_forwarded(std::move(t_forwarded)) {}
+
+	protected:
+	void on_queued() override {
+		get_book()->insert<elob::side::ask>(m_forwarded);
+	}
+};
+
+} // namespace
+
+side_test::side_test() : test("side_test") {
+	add("insert_static_side", insert_static_side);
+	add("reject_other_side", reject_other_side);
+	add("reject_deferred_other_side", reject_deferred_other_side);
+	add("trigger_symmetrically", trigger_symmetrically);
+}
+
+bool side_test::insert_static_side() {
+	elob::book book;
+	const auto ask =
+	    std::make_shared<elob::order>(elob::side::ask, 100.0, 2.0);
+	const auto bid =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+	book.insert<elob::side::ask>(ask);
+	book.insert<elob::side::bid>(bid);
+
+	return ask->is_queued() && ask->get_quantity() == 1.0 &&
+	       !bid->is_queued() && book.get_market_price() == 100.0;
+}
+
+bool side_test::reject_other_side() {
+	elob::book book;
+	const auto bid =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+	const auto trigger =
+	    std::make_shared<elob::trigger>(elob::side::bid, 90.0);
+	book.insert<elob::side::ask>(bid);
+	book.insert<elob::side::ask>(trigger);
+
+	return !bid->is_queued() && bid->get_book() == nullptr &&
+	       !trigger->is_queued() &&
+	       book.get_bid_price() == elob::min_price;
+}
+
+bool side_test::reject_deferred_other_side() {
+	elob::book book;
+	const auto bid =
+	    std::make_shared<elob::order>(elob::side::bid, 100.0, 1.0);
+
+	// the bid arrives while the insertion of the ask is deferring
+	// orders
+	book.insert<forwarding_order>(elob::side::ask, 101.0, 1.0, bid);
+
+	return !bid->is_queued() && bid->get_book() == nullptr &&
+	       book.get_bid_price() == elob::min_price &&
+	       book.get_ask_price() == 101.0;
+}
+
+bool side_test::trigger_symmetrically() {
+	elob::book book;
+
+	// neither side triggers before the first trade
+	const auto bid = std::make_shared<elob::trigger>(elob::side::bid, 0.0);
+	const auto ask = std::make_shared<elob::trigger>(elob::side::ask, 0.0);
+	book.insert(bid);
+	book.insert(ask);
+
+	if (!bid->is_queued() || !ask->is_queued()) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::ask, 100.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 100.0, 1.0);
+
+	// the market price has reached ask triggers at or below it
+	return bid->is_queued() && !ask->is_queued();
+}
+
+#endif // #ifndef SIDE_TEST_HPP
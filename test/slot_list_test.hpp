@@ -0,0 +1,107 @@
+#ifndef SLOT_LIST_TEST_HPP
+#define SLOT_LIST_TEST_HPP
+#include "test.hpp"
+
+class slot_list_test : public test {
+	inline static bool reuse_slots();
+	inline static bool keep_slots_when_moved();
+	inline static bool keep_aon_priority();
+
+	public:
+	slot_list_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/slot_list.hpp"
+#include <utility>
+#include <vector>
+
+slot_list_test::slot_list_test() : test("slot_list_test") {
+	add("reuse_slots", reuse_slots);
+	add("keep_slots_when_moved", keep_slots_when_moved);
+	add("keep_aon_priority", keep_aon_priority);
+}
+
+bool slot_list_test::reuse_slots() {
+	elob::slot_list<int> list;
+	std::vector<std::uint32_t> slots;
+
+	for (int i = 0; i < 5; ++i) {
+		slots.push_back(list.push_back(i));
+	}
+
+	list.erase(slots[1]);
+	list.erase(slots[3]);
+
+	// the freed slots are handed out again, the order is kept
+	const std::uint32_t front = list.insert(list.first(), 5);
+	const std::uint32_t back = list.push_back(6);
+	list.move_back(slots[2]);
+
+	if ((front != slots[3] && front != slots[1]) ||
+	    (back != slots[3] && back != slots[1]) || list.size() != 5) {
+		return false;
+	}
+
+	const std::vector<int> expected = {5, 0, 4, 6, 2};
+	return std::vector<int>(list.begin(), list.end()) == expected &&
+	       *std::prev(list.end()) == 2 && list[slots[4]] == 4;
+}
+
+bool slot_list_test::keep_slots_when_moved() {
+	elob::book book;
+	std::vector<elob::order_ptr> orders;
+
+	for (int i = 0; i < 20; ++i) {
+		orders.push_back(book.insert<elob::order>(
+		    elob::side::ask, 100.0, 1.0 + i, false, i % 4 == 0));
+	}
+
+	// the fork moves the queue of the book, the orders keep their
+	// slots in it
+	const auto fork = book.fork();
+	orders[1]->set_quantity(10.0);
+
+	for (int i = 2; i < 20; i += 3) {
+		if (!orders[i]->cancel()) {
+			return false;
+		}
+	}
+
+	orders[4]->set_all_or_nothing(false);
+	orders[6]->set_all_or_nothing(true);
+	book.insert<elob::order>(elob::side::bid, 100.0, 26.0);
+
+	// the bid fills 0, 1, 3 and 4, skips 6 and fills 7 partially
+	return !orders[0]->is_queued() && !orders[1]->is_queued() &&
+	       !orders[3]->is_queued() && !orders[4]->is_queued() &&
+	       orders[6]->is_queued() && orders[7]->get_quantity() == 2.0 &&
+	       book.ask_limit_at(100.0)->second.order_count() == 10 &&
+	       fork->ask_limit_at(100.0)->second.order_count() == 20;
+}
+
+bool slot_list_test::keep_aon_priority() {
+	elob::book book;
+	const auto first = book.insert<elob::order>(
+	    elob::side::ask, 100.0, 3.0, false, true);
+	const auto middle =
+	    book.insert<elob::order>(elob::side::ask, 100.0, 5.0);
+	const auto last = book.insert<elob::order>(
+	    elob::side::ask, 100.0, 2.0, false, true);
+
+	// the order keeps its place among the all-or-nothing orders
+	middle->set_all_or_nothing(true);
+	middle->set_quantity(2.0);
+
+	// the increase moves the first order behind the others
+	book.replace(first, 100.0, 4.0);
+
+	const auto bid = book.insert<elob::order>(
+	    elob::side::bid, 100.0, 4.0, false, true);
+
+	return !bid->is_queued() && first->is_queued() &&
+	       !middle->is_queued() && !last->is_queued() &&
+	       book.ask_limit_at(100.0)->second.aon_order_count() == 1;
+}
+
+#endif // #ifndef SLOT_LIST_TEST_HPP
@@ -0,0 +1,86 @@
+#ifndef SNAPSHOT_TEST_HPP
+#define SNAPSHOT_TEST_HPP
+#include "test.hpp"
+
+class snapshot_test : public test {
+	inline static bool publish_top_of_book();
+	inline static bool publish_once_per_insert();
+	inline static bool publish_on_cancel();
+
+	public:
+	snapshot_test();
+};
+
+#include "../include/book.hpp"
+
+snapshot_test::snapshot_test() : test("snapshot_test") {
+	add("publish_top_of_book", publish_top_of_book);
+	add("publish_once_per_insert", publish_once_per_insert);
+	add("publish_on_cancel", publish_on_cancel);
+}
+
+bool snapshot_test::publish_top_of_book() {
+	elob::book book;
+	const auto &snapshot = book.enable_snapshot();
+
+	for (std::size_t i = 0; i < 20; ++i) {
+		book.insert<elob::order>(elob::side::bid, 100.0 - i, 10.0);
+		book.insert<elob::order>(elob::side::ask, 101.0 + i, 10.0);
+	}
+
+	book.insert<elob::order>(elob::side::bid, 101.0, 4.0);
+
+	elob::snapshot_data data;
+	snapshot.read(data);
+
+	return data.bid_count == elob::snapshot_depth &&
+	       data.ask_count == elob::snapshot_depth &&
+	       data.get_bid_price() == book.get_bid_price() &&
+	       data.get_ask_price() == book.get_ask_price() &&
+	       data.asks[0].quantity == 6.0 &&
+	       data.get_market_price() == 101.0 &&
+	       data.last_trade_quantity == 4.0;
+}
+
+class chained_order : public elob::order {
+	public:
+	using elob::order::order;
+
+	protected:
+	void on_traded(elob::c_order_ptr &t_order) override {
+		get_book()->insert<elob::order>(
+		    elob::side::ask, 99.0, 1.0, true);
+	}
+};
+
+bool snapshot_test::publish_once_per_insert() {
+	elob::book book;
+	const auto &snapshot = book.enable_snapshot();
+
+	book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	book.insert<elob::order>(elob::side::ask, 100.0, 5.0);
+	const auto sequence = snapshot.get_sequence();
+
+	// the resting ask trades and inserts a deferred order
+	book.insert<chained_order>(elob::side::bid, 100.0, 5.0);
+
+	elob::snapshot_data data;
+	snapshot.read(data);
+
+	return snapshot.get_sequence() == sequence + 1 &&
+	       data.bid_count == 1 && data.bids[0].quantity == 4.0;
+}
+
+bool snapshot_test::publish_on_cancel() {
+	elob::book book;
+	const auto &snapshot = book.enable_snapshot();
+	const auto order = book.insert<elob::order>(elob::side::bid, 99.0, 5.0);
+	order->cancel();
+
+	elob::snapshot_data data;
+	snapshot.read(data);
+
+	return data.bid_count == 0 && data.get_bid_price() == elob::min_price;
+}
+
+#endif // #ifndef SNAPSHOT_TEST_HPP
@@ -0,0 +1,145 @@
+#ifndef TRIGGER_LADDER_TEST_HPP
+#define TRIGGER_LADDER_TEST_HPP
+#include "test.hpp"
+
+class trigger_ladder_test : public test {
+	inline static bool fire_in_bulk();
+	inline static bool cancel_while_firing();
+	inline static bool follow_first_level();
+
+	public:
+	trigger_ladder_test();
+};
+
+#include "../include/book.hpp"
+#include "../include/trigger.hpp"
+#include <vector>
+
+namespace {
+
+// records the order in which the triggers fired and optionally
+// cancels another trigger when it fires
+class ladder_trigger : public elob::trigger {
+	public:
+	std::vector<int> &m_fired;
+	const int m_id;
+	elob::trigger_ptr m_cancels;
+
+	ladder_trigger(const elob::side t_side, const double t_price,
+	    std::vector<int> &t_fired, const int t_id)
+	    : trigger(t_side, t_price), m_fired(t_fired), m_id(t_id) {}
+
+	protected:
+	void on_triggered() override {
+		m_fired.push_back(m_id);
+
+		if (m_cancels) {
+			m_cancels->cancel();
+		}
+	}
+};
+
+} // namespace
+
+trigger_ladder_test::trigger_ladder_test() : test("trigger_ladder_test") {
+	add("fire_in_bulk", fire_in_bulk);
+	add("cancel_while_firing", cancel_while_firing);
+	add("follow_first_level", follow_first_level);
+}
+
+bool trigger_ladder_test::fire_in_bulk() {
+	elob::book book;
+	std::vector<int> fired;
+	std::vector<std::shared_ptr<ladder_trigger>> triggers;
+
+	for (int i = 0; i < 2000; ++i) {
+		triggers.push_back(std::make_shared<ladder_trigger>(
+		    elob::side::ask, 105.0, fired, i));
+		book.insert(triggers.back());
+	}
+
+	// cancel enough triggers to compact the level
+	for (int i = 0; i < 2000; i += 3) {
+		triggers[i]->cancel();
+		triggers[i + 1]->cancel();
+	}
+
+	book.insert<elob::order>(elob::side::ask, 105.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 105.0, 1.0);
+
+	if (fired.size() != 666) {
+		return false;
+	}
+
+	for (std::size_t i = 0; i < fired.size(); ++i) {
+		if (fired[i] != static_cast<int>(i) * 3 + 2 ||
+		    triggers[fired[i]]->is_queued()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool trigger_ladder_test::cancel_while_firing() {
+	elob::book book;
+	std::vector<int> fired;
+	std::vector<std::shared_ptr<ladder_trigger>> triggers;
+
+	for (int i = 0; i < 6; ++i) {
+		triggers.push_back(std::make_shared<ladder_trigger>(
+		    elob::side::bid, i < 3 ? 95.0 : 94.0, fired, i));
+		book.insert(triggers.back());
+	}
+
+	// the first trigger cancels a trigger of its level and one of
+	// the next level before they fire
+	triggers[0]->m_cancels = triggers[1];
+	triggers[2]->m_cancels = triggers[4];
+	book.insert<elob::order>(elob::side::bid, 94.0, 1.0);
+	book.insert<elob::order>(elob::side::ask, 94.0, 1.0);
+
+	return fired == std::vector<int>{0, 2, 3, 5} &&
+	       !triggers[1]->is_queued() && !triggers[4]->is_queued() &&
+	       !triggers[5]->is_queued();
+}
+
+bool trigger_ladder_test::follow_first_level() {
+	elob::book book;
+	std::vector<int> fired;
+	const auto near =
+	    std::make_shared<ladder_trigger>(elob::side::ask, 102.0, fired, 0);
+	const auto far =
+	    std::make_shared<ladder_trigger>(elob::side::ask, 104.0, fired, 1);
+	book.insert(far);
+	book.insert(near);
+
+	// trades below the first level do not fire
+	book.insert<elob::order>(elob::side::ask, 101.0, 2.0);
+	book.insert<elob::order>(elob::side::bid, 101.0, 1.0);
+
+	if (!fired.empty()) {
+		return false;
+	}
+
+	near->set_price(103.0);
+	near->cancel();
+	book.insert<elob::order>(elob::side::ask, 103.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 103.0, 2.0);
+
+	if (!fired.empty() || !far->is_queued()) {
+		return false;
+	}
+
+	book.insert<elob::order>(elob::side::ask, 104.0, 1.0);
+	book.insert<elob::order>(elob::side::bid, 104.0, 1.0);
+
+	// the spare level is reused for the next trigger
+	const auto next =
+	    std::make_shared<ladder_trigger>(elob::side::ask, 106.0, fired, 2);
+	book.insert(next);
+	return fired == std::vector<int>{1} && !far->is_queued() &&
+	       next->is_queued();
+}
+
+#endif // #ifndef TRIGGER_LADDER_TEST_HPP
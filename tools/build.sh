@@ -0,0 +1,5 @@
+#!
+rm -f tools/gateway.out tools/loadgen.out tools/layout.out
+g++ -Ofast -Wall -std=c++17 tools/gateway.cpp -o tools/gateway.out
+g++ -Ofast -Wall -std=c++17 tools/loadgen.cpp -o tools/loadgen.out
+g++ -Ofast -Wall -std=c++17 tools/layout.cpp -o tools/layout.out
@@ -0,0 +1,695 @@
+/* Order entry gateway that runs a single elob::book as a local matching
+	service. Clients connect over a Unix domain socket or loopback TCP
+	and exchange the insert, cancel, amend, ack and fill messages of
+	the codec defined in include/codec.hpp. All connections are
+	multiplexed with epoll on a single thread: each readable socket is
+	drained and decoded in place in one batch straight into book
+	calls, and the acks and fills generated by a batch are encoded
+	directly into per-client output chunks and written back with one
+	writev per client.
+
+	usage: gateway <socket path | tcp:port> */
+
+#include "../include/book.hpp"
+#include "protocol.hpp"
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace gw = elob::gateway;
+namespace codec = elob::codec;
+
+class gateway;
+class client;
+
+/**
+ * @brief An order entered through the gateway. Its event methods
+ * translate book events into protocol messages for the owning client.
+ *
+ */
+class gateway_order : public elob::order {
+	private:
+	client &m_client;
+	const std::uint64_t m_token;
+	const std::uint8_t m_ack_status;
+	double m_remaining;
+
+	protected:
+	void on_accepted() override;
+	void on_rejected() override;
+	void on_traded(elob::c_order_ptr &t_order) override;
+	void on_replaced() override;
+	void on_canceled() override;
+
+	public:
+	gateway_order(client &t_client, const std::uint64_t t_token,
+	    const std::uint8_t t_side, const double t_price,
+	    const double t_quantity, const std::uint8_t t_flags,
+	    const std::uint8_t t_ack_status);
+};
+
+/**
+ * @brief A connected client: its socket, unparsed input, pending
+ * output and live orders by token.
+ *
+ */
+class client {
+	private:
+	static constexpr std::size_t chunk_size = 4096;
+
+	struct chunk {
+		char data[chunk_size];
+		std::size_t size = 0;
+	};
+
+	gateway &m_gateway;
+	const int m_fd;
+	std::vector<char> m_input;
+	std::vector<std::unique_ptr<chunk>> m_output;
+	std::vector<std::unique_ptr<chunk>> m_spare;
+	std::size_t m_output_offset = 0; // bytes of m_output[0] sent
+	bool m_writable = true;
+	bool m_dirty = false;
+	bool m_closed = false;
+
+	std::unordered_map<std::uint64_t, std::shared_ptr<gateway_order>>
+	    m_orders;
+
+	/**
+	 * @brief Execute a single message decoded in place.
+	 *
+	 * @return false if the message is malformed.
+	 */
+	bool handle(const char *t_message);
+	void enter(const std::uint64_t t_token, const std::uint8_t t_side,
+	    const double t_price, const double t_quantity,
+	    const std::uint8_t t_flags, const std::uint8_t t_ack_status);
+	void cancel(const std::uint64_t t_token);
+	void amend(const std::uint64_t t_token, const double t_price,
+	    const double t_quantity);
+
+	/**
+	 * @brief Reserve space for an outgoing message in the last
+	 * output chunk.
+	 *
+	 * @return pointer to t_length bytes to encode the message into.
+	 */
+	char *reserve(const std::size_t t_length);
+
+	public:
+	client(gateway &t_gateway, const int t_fd);
+
+	/**
+	 * @brief Read everything available and execute all complete
+	 * messages.
+	 *
+	 * @return false if the connection was closed.
+	 */
+	bool read();
+
+	/**
+	 * @brief Queue an ack. It is sent on the next flush.
+	 *
+	 */
+	void send_ack(const std::uint64_t t_token, const std::uint8_t t_status,
+	    const std::uint8_t t_side = 0, const double t_price = 0.0,
+	    const double t_quantity = 0.0);
+
+	/**
+	 * @brief Queue a fill. It is sent on the next flush.
+	 *
+	 */
+	void send_fill(const std::uint64_t t_token, const std::uint8_t t_side,
+	    const double t_price, const double t_quantity);
+
+	/**
+	 * @brief Write pending output with a single writev.
+	 *
+	 * @return false if the connection failed.
+	 */
+	bool flush();
+
+	/**
+	 * @brief Resume writing once the socket became writable again.
+	 *
+	 * @return false if the connection failed.
+	 */
+	bool resume();
+
+	/**
+	 * @brief Cancel all live orders of the client.
+	 *
+	 */
+	void cancel_all();
+
+	void forget(const std::uint64_t t_token);
+
+	bool is_closed() const { return m_closed; }
+	void close_connection();
+	int get_fd() const { return m_fd; }
+	gateway &get_gateway() { return m_gateway; }
+
+	~client();
+};
+
+class gateway {
+	private:
+	elob::book m_book;
+	const int m_listen_fd;
+	const int m_epoll_fd;
+	std::unordered_map<int, std::unique_ptr<client>> m_clients;
+	std::vector<client *> m_dirty;
+	const elob::order *m_aggressor = nullptr;
+
+	void accept_clients();
+	void flush_clients();
+
+	public:
+	gateway(const int t_listen_fd);
+
+	void run(volatile std::sig_atomic_t &t_running);
+
+	elob::book &get_book() { return m_book; }
+
+	/**
+	 * @brief Insert an order on behalf of a client. The order is
+	 * remembered as the aggressor so that executions can be priced
+	 * at the resting order's price.
+	 *
+	 */
+	void insert(const std::shared_ptr<gateway_order> &t_order);
+
+	/**
+	 * @brief Replace a queued order on behalf of a client. Like
+	 * insert, the order is remembered as the aggressor.
+	 *
+	 * @return false if the order is no longer queued.
+	 */
+	bool replace(const std::shared_ptr<gateway_order> &t_order,
+	    const double t_price, const double t_quantity);
+
+	bool is_aggressor(const elob::order *t_order) const {
+		return t_order == m_aggressor;
+	}
+
+	void mark_dirty(client *t_client) { m_dirty.push_back(t_client); }
+
+	/**
+	 * @brief Start or stop waiting for a client's socket to become
+	 * writable after its send buffer filled up.
+	 *
+	 */
+	void watch_output(client &t_client, const bool t_watch);
+
+	~gateway();
+};
+
+gateway_order::gateway_order(client &t_client, const std::uint64_t t_token,
+    const std::uint8_t t_side, const double t_price, const double t_quantity,
+    const std::uint8_t t_flags, const std::uint8_t t_ack_status)
+    : elob::order(t_side == 0 ? elob::side::bid : elob::side::ask, t_price,
+	  t_quantity, t_flags & codec::immediate_or_cancel_flag,
+	  t_flags & codec::all_or_nothing_flag),
+      m_client(t_client), m_token(t_token), m_ack_status(t_ack_status),
+      m_remaining(t_quantity) {}
+
+void gateway_order::on_accepted() {
+	m_client.send_ack(
+	    m_token, m_ack_status, get_side(), get_price(), get_quantity());
+}
+
+void gateway_order::on_rejected() {
+	m_client.send_ack(m_token, codec::rejected_status);
+	m_client.forget(m_token);
+}
+
+void gateway_order::on_traded(elob::c_order_ptr &t_order) {
+	const bool aggressor = m_client.get_gateway().is_aggressor(this);
+
+	m_client.send_fill(m_token, get_side(),
+	    aggressor ? t_order->get_price() : get_price(),
+	    m_remaining - get_quantity());
+
+	m_remaining = get_quantity();
+
+	if (m_remaining <= 0.0) {
+		m_client.forget(m_token);
+	}
+}
+
+void gateway_order::on_replaced() {
+	m_remaining = get_quantity();
+	m_client.send_ack(m_token, codec::replaced_status, get_side(),
+	    get_price(), get_quantity());
+}
+
+void gateway_order::on_canceled() {
+	m_client.send_ack(m_token, codec::canceled_status, get_side(),
+	    get_price(), get_quantity());
+	m_client.forget(m_token);
+}
+
+client::client(gateway &t_gateway, const int t_fd)
+    : m_gateway(t_gateway), m_fd(t_fd) {}
+
+bool client::read() {
+	char buffer[64 * 1024];
+
+	while (true) {
+		const ssize_t count = recv(m_fd, buffer, sizeof(buffer), 0);
+
+		if (count == 0) {
+			return false;
+		}
+
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		// decode in place from the receive buffer where possible
+		const char *data = buffer;
+		std::size_t size = static_cast<std::size_t>(count);
+
+		if (!m_input.empty()) {
+			m_input.insert(m_input.end(), buffer, buffer + count);
+			data = m_input.data();
+			size = m_input.size();
+		}
+
+		std::size_t offset = 0;
+
+		while (true) {
+			const std::size_t length =
+			    codec::check(data + offset, size - offset);
+
+			if (length == 0) {
+				break;
+			}
+
+			if (length == SIZE_MAX || !handle(data + offset)) {
+				return false;
+			}
+
+			offset += length;
+		}
+
+		if (offset == size) {
+			m_input.clear();
+		} else {
+			std::vector<char> rest(data + offset, data + size);
+			m_input.swap(rest);
+		}
+	}
+}
+
+bool client::handle(const char *t_message) {
+	switch (codec::header_decoder(t_message).template_id()) {
+	case codec::insert_message_decoder::template_id: {
+		const codec::insert_message_decoder message(t_message);
+		enter(message.token(), message.side(), message.price(),
+		    message.quantity(), message.flags(),
+		    codec::accepted_status);
+		return true;
+	}
+	case codec::cancel_message_decoder::template_id:
+		cancel(codec::cancel_message_decoder(t_message).token());
+		return true;
+	case codec::amend_message_decoder::template_id: {
+		const codec::amend_message_decoder message(t_message);
+		amend(message.token(), message.price(), message.quantity());
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+void client::enter(const std::uint64_t t_token, const std::uint8_t t_side,
+    const double t_price, const double t_quantity, const std::uint8_t t_flags,
+    const std::uint8_t t_ack_status) {
+	if (t_side > 1 || m_orders.count(t_token) != 0) {
+		send_ack(t_token, codec::rejected_status);
+		return;
+	}
+
+	const auto order_obj = std::make_shared<gateway_order>(
+	    *this, t_token, t_side, t_price, t_quantity, t_flags, t_ack_status);
+	m_orders.emplace(t_token, order_obj);
+	m_gateway.insert(order_obj);
+}
+
+void client::cancel(const std::uint64_t t_token) {
+	const auto order_it = m_orders.find(t_token);
+
+	if (order_it == m_orders.end()) {
+		send_ack(t_token, codec::rejected_status);
+		return;
+	}
+
+	const auto order_obj = order_it->second;
+
+	if (order_obj->cancel()) {
+		send_ack(t_token, codec::canceled_status, order_obj->get_side(),
+		    order_obj->get_price(), order_obj->get_quantity());
+		forget(t_token);
+	}
+}
+
+void client::amend(
+    const std::uint64_t t_token, const double t_price, const double t_quantity) {
+	const auto order_it = m_orders.find(t_token);
+
+	if (order_it == m_orders.end()) {
+		send_ack(t_token, codec::rejected_status);
+		return;
+	}
+
+	// the order is forgotten once the replacement fills it
+	const auto order_obj = order_it->second;
+
+	if (!m_gateway.replace(order_obj, t_price, t_quantity)) {
+		send_ack(t_token, codec::rejected_status);
+	}
+}
+
+char *client::reserve(const std::size_t t_length) {
+	if (m_output.empty() ||
+	    m_output.back()->size + t_length > chunk_size) {
+		if (m_spare.empty()) {
+			m_output.push_back(std::make_unique<chunk>());
+		} else {
+			m_output.push_back(std::move(m_spare.back()));
+			m_spare.pop_back();
+		}
+	}
+
+	auto &last = *m_output.back();
+	char *const data = last.data + last.size;
+	last.size += t_length;
+
+	if (!m_dirty) {
+		m_dirty = true;
+		m_gateway.mark_dirty(this);
+	}
+
+	return data;
+}
+
+void client::send_ack(const std::uint64_t t_token, const std::uint8_t t_status,
+    const std::uint8_t t_side, const double t_price, const double t_quantity) {
+	if (m_closed) {
+		return;
+	}
+
+	codec::ack_message_encoder(
+	    reserve(codec::ack_message_encoder::encoded_length))
+	    .encode_header()
+	    .token(t_token)
+	    .price(t_price)
+	    .quantity(t_quantity)
+	    .status(t_status)
+	    .side(t_side);
+}
+
+void client::send_fill(const std::uint64_t t_token, const std::uint8_t t_side,
+    const double t_price, const double t_quantity) {
+	if (m_closed) {
+		return;
+	}
+
+	codec::fill_message_encoder(
+	    reserve(codec::fill_message_encoder::encoded_length))
+	    .encode_header()
+	    .token(t_token)
+	    .batch(0)
+	    .price(t_price)
+	    .quantity(t_quantity)
+	    .side(t_side);
+}
+
+bool client::flush() {
+	m_dirty = false;
+
+	while (!m_output.empty() && m_writable) {
+		iovec vectors[IOV_MAX];
+		std::size_t vector_count = 0;
+
+		for (const auto &chunk_obj : m_output) {
+			if (vector_count == IOV_MAX) {
+				break;
+			}
+
+			const std::size_t offset =
+			    vector_count == 0 ? m_output_offset : 0;
+			vectors[vector_count].iov_base = chunk_obj->data + offset;
+			vectors[vector_count].iov_len = chunk_obj->size - offset;
+			++vector_count;
+		}
+
+		ssize_t written = writev(m_fd, vectors, vector_count);
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				m_gateway.watch_output(*this, true);
+				m_writable = false;
+				return true;
+			}
+
+			return false;
+		}
+
+		// recycle completely written chunks
+		std::size_t done = 0;
+		std::size_t remaining = static_cast<std::size_t>(written);
+
+		while (done < m_output.size()) {
+			const std::size_t size =
+			    m_output[done]->size - m_output_offset;
+
+			if (remaining < size) {
+				m_output_offset += remaining;
+				break;
+			}
+
+			remaining -= size;
+			m_output_offset = 0;
+			m_output[done]->size = 0;
+			m_spare.push_back(std::move(m_output[done]));
+			++done;
+		}
+
+		m_output.erase(m_output.begin(), m_output.begin() + done);
+	}
+
+	return true;
+}
+
+bool client::resume() {
+	m_writable = true;
+	m_gateway.watch_output(*this, false);
+	return flush();
+}
+
+void client::cancel_all() {
+	std::vector<std::shared_ptr<gateway_order>> orders;
+	orders.reserve(m_orders.size());
+
+	for (const auto &[token, order_obj] : m_orders) {
+		orders.push_back(order_obj);
+	}
+
+	for (const auto &order_obj : orders) {
+		order_obj->cancel();
+	}
+
+	m_orders.clear();
+}
+
+void client::forget(const std::uint64_t t_token) { m_orders.erase(t_token); }
+
+void client::close_connection() {
+	if (!m_closed) {
+		cancel_all();
+		m_closed = true;
+	}
+}
+
+client::~client() { close(m_fd); }
+
+gateway::gateway(const int t_listen_fd)
+    : m_listen_fd(t_listen_fd), m_epoll_fd(epoll_create1(0)) {
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = m_listen_fd;
+	epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, &event);
+}
+
+void gateway::insert(const std::shared_ptr<gateway_order> &t_order) {
+	m_aggressor = t_order.get();
+	m_book.insert(t_order);
+	m_aggressor = nullptr;
+}
+
+bool gateway::replace(const std::shared_ptr<gateway_order> &t_order,
+    const double t_price, const double t_quantity) {
+	m_aggressor = t_order.get();
+	const bool replaced = m_book.replace(t_order, t_price, t_quantity);
+	m_aggressor = nullptr;
+	return replaced;
+}
+
+void gateway::watch_output(client &t_client, const bool t_watch) {
+	epoll_event event;
+	event.events = EPOLLIN | (t_watch ? EPOLLOUT : 0);
+	event.data.fd = t_client.get_fd();
+	epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, t_client.get_fd(), &event);
+}
+
+void gateway::accept_clients() {
+	while (true) {
+		const int fd = accept(m_listen_fd, nullptr, nullptr);
+
+		if (fd < 0) {
+			return;
+		}
+
+		if (!gw::configure_socket(fd)) {
+			close(fd);
+			continue;
+		}
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+		m_clients.emplace(fd, std::make_unique<client>(*this, fd));
+	}
+}
+
+void gateway::flush_clients() {
+	for (auto *client_obj : m_dirty) {
+		if (!client_obj->is_closed() && !client_obj->flush()) {
+			client_obj->close_connection();
+		}
+	}
+
+	m_dirty.clear();
+
+	for (auto it = m_clients.begin(); it != m_clients.end();) {
+		if (it->second->is_closed()) {
+			epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, it->first, nullptr);
+			it = m_clients.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void gateway::run(volatile std::sig_atomic_t &t_running) {
+	epoll_event events[256];
+
+	while (t_running) {
+		const int count = epoll_wait(m_epoll_fd, events, 256, -1);
+
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			break;
+		}
+
+		bool closed = false;
+
+		for (int i = 0; i < count; ++i) {
+			const int fd = events[i].data.fd;
+
+			if (fd == m_listen_fd) {
+				accept_clients();
+				continue;
+			}
+
+			const auto client_it = m_clients.find(fd);
+
+			if (client_it == m_clients.end() ||
+			    client_it->second->is_closed()) {
+				continue;
+			}
+
+			auto &client_obj = *client_it->second;
+
+			if ((events[i].events & EPOLLOUT) && !client_obj.resume()) {
+				client_obj.close_connection();
+				closed = true;
+				continue;
+			}
+
+			if ((events[i].events & (EPOLLERR | EPOLLHUP)) ||
+			    !client_obj.read()) {
+				client_obj.close_connection();
+				closed = true;
+			}
+		}
+
+		if (!m_dirty.empty() || closed) {
+			flush_clients();
+		}
+	}
+}
+
+gateway::~gateway() {
+	for (auto &[fd, client_obj] : m_clients) {
+		client_obj->close_connection();
+	}
+
+	m_clients.clear();
+	close(m_epoll_fd);
+	close(m_listen_fd);
+}
+
+namespace {
+volatile std::sig_atomic_t running = 1;
+
+void stop(int) { running = 0; }
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		std::cerr << "usage: " << argv[0]
+			  << " <socket path | tcp:port>\n";
+		return 1;
+	}
+
+	const int listen_fd = gw::listen_on(argv[1]);
+
+	if (listen_fd < 0) {
+		std::cerr << "cannot listen on " << argv[1] << ": "
+			  << std::strerror(errno) << '\n';
+		return 1;
+	}
+
+	std::signal(SIGINT, stop);
+	std::signal(SIGTERM, stop);
+	std::signal(SIGPIPE, SIG_IGN);
+
+	gateway gateway_obj(listen_fd);
+	gateway_obj.run(running);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/* Layout benchmark for queued orders. It rests deep queues of small
+	orders, interleaving the levels so that neighbouring orders of a
+	queue are not neighbours in memory, evicts them from the cache and
+	sweeps all levels with one inbound order. For every queued order it
+	counts the cache lines holding the fields a complete fill reads or
+	writes, and it reports the time per fill of the cold sweep. The
+	reference count of the order and the entry that links it into its
+	queue are not included.
+
+	usage: layout [orders per level] [levels] [rounds] */
+
+#include "../include/book.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace elob {
+
+struct order_layout {
+	static constexpr std::uintptr_t line_size = 64;
+
+	// the cache lines read or written when t_order is filled
+	// completely
+	static std::size_t lines_touched(const order &t_order) {
+		std::set<std::uintptr_t> lines;
+		const auto touch = [&lines](const void *t_field,
+				       const std::size_t t_size) {
+			const auto first =
+			    reinterpret_cast<std::uintptr_t>(t_field);
+			const auto last = first + t_size - 1;
+
+			for (auto line = first / line_size;
+			     line <= last / line_size; ++line) {
+				lines.insert(line);
+			}
+		};
+
+		touch(&t_order, sizeof(void *)); // vtable pointer
+		touch(&t_order.m_quantity, sizeof(t_order.m_quantity));
+		touch(&t_order.m_hidden_quantity,
+		    sizeof(t_order.m_hidden_quantity));
+		touch(&t_order.m_price, sizeof(t_order.m_price));
+		touch(&t_order.m_peg, sizeof(t_order.m_peg));
+		touch(&t_order.m_all_or_nothing,
+		    sizeof(t_order.m_all_or_nothing));
+		touch(&t_order.m_queued, sizeof(t_order.m_queued));
+		touch(&t_order.m_self, sizeof(t_order.m_self));
+		touch(&t_order.m_book, sizeof(t_order.m_book));
+		touch(&t_order.m_owner, sizeof(t_order.m_owner));
+		return lines.size();
+	}
+};
+
+} // namespace elob
+
+namespace {
+
+// large enough to evict the queued orders from the last level cache
+std::vector<char> eviction_buffer(std::size_t(64) << 20);
+
+void evict() {
+	for (std::size_t i = 0; i < eviction_buffer.size(); i += 64) {
+		++eviction_buffer[i];
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t order_count = argc > 1 ? std::stoul(argv[1]) : 10000;
+	const std::size_t level_count = argc > 2 ? std::stoul(argv[2]) : 8;
+	const std::size_t rounds = argc > 3 ? std::stoul(argv[3]) : 5;
+
+	if (order_count == 0 || level_count == 0 || rounds == 0) {
+		std::cerr << "usage: " << argv[0]
+			  << " [orders per level] [levels] [rounds]\n";
+		return 1;
+	}
+
+	std::size_t lines = 0;
+	std::size_t fills = 0;
+	std::vector<double> nanoseconds;
+
+	for (std::size_t round = 0; round < rounds; ++round) {
+		elob::book book;
+		std::vector<elob::order_ptr> orders;
+
+		for (std::size_t i = 0; i < order_count; ++i) {
+			for (std::size_t level = 0; level < level_count;
+			     ++level) {
+				orders.push_back(book.insert<elob::order>(
+				    elob::side::ask, 100.0 + level, 1.0));
+			}
+		}
+
+		for (const auto &order : orders) {
+			lines += elob::order_layout::lines_touched(*order);
+		}
+
+		evict();
+		const auto start = steady_clock::now();
+		book.insert<elob::order>(elob::side::bid, elob::max_price,
+		    static_cast<double>(orders.size()));
+		const auto elapsed = steady_clock::now() - start;
+		fills += orders.size();
+		nanoseconds.push_back(
+		    std::chrono::duration<double, std::nano>(elapsed).count() /
+		    orders.size());
+	}
+
+	std::sort(nanoseconds.begin(), nanoseconds.end());
+
+	std::cout << std::setw(12) << "ORDERS" << std::setw(12) << "BYTES"
+		  << std::setw(12) << "ALIGNMENT" << std::setw(12)
+		  << "LINES/FILL" << std::setw(12) << "NS/FILL" << '\n'
+		  << std::setw(12) << order_count * level_count << std::setw(12)
+		  << sizeof(elob::order) << std::setw(12)
+		  << alignof(elob::order) << std::setw(12) << std::fixed
+		  << std::setprecision(2)
+		  << static_cast<double>(lines) / fills << std::setw(12)
+		  << nanoseconds[nanoseconds.size() / 2] << '\n';
+
+	return 0;
+}
@@ -0,0 +1,235 @@
+/* Load generator for the order entry gateway. For every connection count
+	it opens that many connections and lets each of them alternate
+	between entering a resting order and cancelling it, with one
+	request in flight per connection. The round trip latency of every
+	request (send to first response) is recorded and reported as
+	percentiles.
+
+	usage: loadgen <socket path | tcp:port> [round trips per connection]
+	    [connection count ...] */
+
+#include "protocol.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <vector>
+
+namespace gw = elob::gateway;
+namespace codec = elob::codec;
+using steady_clock = std::chrono::steady_clock;
+
+namespace {
+
+struct connection {
+	int fd = -1;
+	std::uint64_t token = 0;
+	std::size_t round_trips = 0;
+	bool order_live = false;
+	steady_clock::time_point sent_at;
+	std::vector<char> input;
+};
+
+bool send_next(connection &t_connection, const std::size_t t_index) {
+	char buffer[codec::max_message_length];
+	std::size_t length = 0;
+
+	if (t_connection.order_live) {
+		codec::cancel_message_encoder(buffer).encode_header().token(
+		    t_connection.token);
+		length = codec::cancel_message_encoder::encoded_length;
+	} else {
+		// bids rest below asks so that orders never trade
+		const std::uint8_t side = (t_index + ++t_connection.token) % 2;
+		codec::insert_message_encoder(buffer)
+		    .encode_header()
+		    .token(t_connection.token)
+		    .price(side == 0 ? 99.0 : 101.0)
+		    .quantity(1.0)
+		    .side(side)
+		    .flags(0);
+		length = codec::insert_message_encoder::encoded_length;
+	}
+
+	t_connection.sent_at = steady_clock::now();
+	return write(t_connection.fd, buffer, length) ==
+	       static_cast<ssize_t>(length);
+}
+
+double percentile(const std::vector<double> &t_sorted, const double t_rank) {
+	if (t_sorted.empty()) {
+		return 0.0;
+	}
+
+	const std::size_t index = std::min(t_sorted.size() - 1,
+	    static_cast<std::size_t>(t_rank * t_sorted.size()));
+	return t_sorted[index];
+}
+
+bool run(const std::string &t_address, const std::size_t t_connection_count,
+    const std::size_t t_round_trips) {
+	const int epoll_fd = epoll_create1(0);
+	std::vector<connection> connections(t_connection_count);
+	std::vector<double> latencies;
+	latencies.reserve(t_connection_count * t_round_trips);
+
+	for (std::size_t i = 0; i < t_connection_count; ++i) {
+		connections[i].fd = gw::connect_to(t_address);
+
+		if (connections[i].fd < 0) {
+			std::cerr << "cannot connect to " << t_address << ": "
+				  << std::strerror(errno) << '\n';
+			return false;
+		}
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u64 = i;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connections[i].fd, &event);
+	}
+
+	const auto started_at = steady_clock::now();
+
+	for (std::size_t i = 0; i < t_connection_count; ++i) {
+		send_next(connections[i], i);
+	}
+
+	std::size_t active = t_connection_count;
+	epoll_event events[256];
+
+	while (active > 0) {
+		const int count = epoll_wait(epoll_fd, events, 256, 1000);
+
+		if (count <= 0) {
+			if (count < 0 && errno == EINTR) {
+				continue;
+			}
+
+			std::cerr << "gateway stopped responding\n";
+			break;
+		}
+
+		for (int e = 0; e < count; ++e) {
+			const std::size_t index = events[e].data.u64;
+			auto &conn = connections[index];
+			char buffer[4096];
+			const ssize_t size = read(conn.fd, buffer, sizeof(buffer));
+
+			if (size <= 0) {
+				continue;
+			}
+
+			const auto received_at = steady_clock::now();
+			conn.input.insert(conn.input.end(), buffer, buffer + size);
+			std::size_t offset = 0;
+
+			while (true) {
+				const char *const data = conn.input.data() + offset;
+				const std::size_t length = codec::check(
+				    data, conn.input.size() - offset);
+
+				if (length == 0 || length == SIZE_MAX) {
+					break;
+				}
+
+				offset += length;
+
+				if (codec::header_decoder(data).template_id() !=
+				    codec::ack_message_decoder::template_id) {
+					continue;
+				}
+
+				const auto status =
+				    codec::ack_message_decoder(data).status();
+
+				if (status == codec::accepted_status) {
+					conn.order_live = true;
+				} else if (status == codec::canceled_status) {
+					conn.order_live = false;
+				} else if (status != codec::rejected_status) {
+					continue;
+				}
+
+				latencies.push_back(
+				    std::chrono::duration<double, std::micro>(
+					received_at - conn.sent_at)
+					.count());
+
+				if (++conn.round_trips == t_round_trips) {
+					--active;
+				} else {
+					send_next(conn, index);
+				}
+			}
+
+			conn.input.erase(
+			    conn.input.begin(), conn.input.begin() + offset);
+		}
+	}
+
+	const double seconds =
+	    std::chrono::duration<double>(steady_clock::now() - started_at)
+		.count();
+
+	for (const auto &conn : connections) {
+		close(conn.fd);
+	}
+
+	close(epoll_fd);
+
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << std::setw(12) << t_connection_count << std::setw(12)
+		  << latencies.size() << std::setw(12)
+		  << static_cast<std::size_t>(latencies.size() / seconds)
+		  << std::fixed << std::setprecision(1) << std::setw(10)
+		  << percentile(latencies, 0.5) << std::setw(10)
+		  << percentile(latencies, 0.9) << std::setw(10)
+		  << percentile(latencies, 0.99) << std::setw(10)
+		  << percentile(latencies, 0.999) << std::setw(10)
+		  << (latencies.empty() ? 0.0 : latencies.back()) << '\n';
+
+	return active == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0]
+			  << " <socket path | tcp:port> [round trips per "
+			     "connection] [connection count ...]\n";
+		return 1;
+	}
+
+	const std::string address = argv[1];
+	const std::size_t round_trips = argc > 2 ? std::stoul(argv[2]) : 10000;
+	std::vector<std::size_t> connection_counts;
+
+	for (int i = 3; i < argc; ++i) {
+		connection_counts.push_back(std::stoul(argv[i]));
+	}
+
+	if (connection_counts.empty()) {
+		connection_counts = {1, 2, 4, 8, 16};
+	}
+
+	std::cout << std::setw(12) << "CONNECTIONS" << std::setw(12) << "TRIPS"
+		  << std::setw(12) << "TRIPS/S" << std::setw(10) << "P50 US"
+		  << std::setw(10) << "P90 US" << std::setw(10) << "P99 US"
+		  << std::setw(10) << "P99.9 US" << std::setw(10) << "MAX US"
+		  << '\n';
+
+	for (const auto connection_count : connection_counts) {
+		if (!run(address, connection_count, round_trips)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
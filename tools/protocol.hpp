@@ -0,0 +1,166 @@
+#ifndef PROTOCOL_HPP
+#define PROTOCOL_HPP
+#include "../include/codec.hpp"
+#include <string>
+
+namespace elob {
+namespace gateway {
+
+/* Socket helpers shared by the gateway and its load generator. The
+	messages exchanged over these sockets are defined by the codec in
+	include/codec.hpp: clients send insert, cancel and amend messages
+	and receive ack and fill messages. Orders are identified by a
+	token chosen by the client which must be unique among the
+	client's live orders. */
+
+/**
+ * @brief Open a listening socket. Addresses of the form "tcp:<port>"
+ * listen on the loopback interface, anything else is used as the path
+ * of a Unix domain socket.
+ *
+ * @param t_address the address to listen on
+ * @return the non-blocking socket or -1 on failure
+ */
+inline int listen_on(const std::string &t_address);
+
+/**
+ * @brief Connect to a gateway. See listen_on for the address format.
+ *
+ * @param t_address the address of the gateway
+ * @return the connected socket or -1 on failure
+ */
+inline int connect_to(const std::string &t_address);
+
+/**
+ * @brief Make a socket non-blocking and, for TCP, disable Nagle's
+ * algorithm.
+ *
+ * @param t_fd the socket
+ * @return true on success
+ */
+inline bool configure_socket(const int t_fd);
+
+} // namespace gateway
+} // namespace elob
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace elob {
+namespace gateway {
+namespace detail {
+
+inline bool is_tcp(const std::string &t_address) {
+	return t_address.compare(0, 4, "tcp:") == 0;
+}
+
+inline sockaddr_in tcp_address(const std::string &t_address) {
+	sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(std::stoi(t_address.substr(4)));
+	return address;
+}
+
+inline sockaddr_un unix_address(const std::string &t_address) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(
+	    address.sun_path, t_address.c_str(), sizeof(address.sun_path) - 1);
+	return address;
+}
+
+} // namespace detail
+} // namespace gateway
+} // namespace elob
+
+bool elob::gateway::configure_socket(const int t_fd) {
+	const int flags = fcntl(t_fd, F_GETFL, 0);
+
+	if (flags < 0 || fcntl(t_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return false;
+	}
+
+	int family = 0;
+	socklen_t length = sizeof(family);
+	getsockopt(t_fd, SOL_SOCKET, SO_DOMAIN, &family, &length);
+
+	if (family == AF_INET) {
+		const int enable = 1;
+		setsockopt(t_fd, IPPROTO_TCP, TCP_NODELAY, &enable,
+		    sizeof(enable));
+	}
+
+	return true;
+}
+
+int elob::gateway::listen_on(const std::string &t_address) {
+	int fd = -1;
+	int result = -1;
+
+	if (detail::is_tcp(t_address)) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		const int enable = 1;
+		setsockopt(
+		    fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+		const auto address = detail::tcp_address(t_address);
+		result = bind(fd, reinterpret_cast<const sockaddr *>(&address),
+		    sizeof(address));
+	} else {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		unlink(t_address.c_str());
+		const auto address = detail::unix_address(t_address);
+		result = bind(fd, reinterpret_cast<const sockaddr *>(&address),
+		    sizeof(address));
+	}
+
+	if (fd < 0 || result < 0 || listen(fd, SOMAXCONN) < 0 ||
+	    !configure_socket(fd)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		return -1;
+	}
+
+	return fd;
+}
+
+int elob::gateway::connect_to(const std::string &t_address) {
+	int fd = -1;
+	int result = -1;
+
+	if (detail::is_tcp(t_address)) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		const auto address = detail::tcp_address(t_address);
+		result = connect(fd,
+		    reinterpret_cast<const sockaddr *>(&address),
+		    sizeof(address));
+	} else {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		const auto address = detail::unix_address(t_address);
+		result = connect(fd,
+		    reinterpret_cast<const sockaddr *>(&address),
+		    sizeof(address));
+	}
+
+	if (fd < 0 || result < 0 || !configure_socket(fd)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+
+		return -1;
+	}
+
+	return fd;
+}
+
+#endif // #ifndef PROTOCOL_HPP